@@ -0,0 +1,521 @@
+/*
+benchmarks.cpp
+    Throughput benchmarks of the paths the dumper runs at scale, on synthetic arm9-like images.
+
+    Each benchmark runs for at least the minimum time, and reports records/s and MB/s.
+    Results are printed as a table, and written to a JSON file so runs can be compared.
+
+    Usage:
+        pmd2_benchmarks [--size-kb <n>] [--tables <n>] [--entries <n>] [--min-time-ms <n>]
+                        [--filter <text>] [--out <results.json>]
+*/
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include "eventtables.hpp"
+#include "tableview.hpp"
+#include "tablejoin.hpp"
+#include "buildprofiles.hpp"
+#include "coverage.hpp"
+#include "blz.hpp"
+
+namespace
+{
+    /*
+        NullBuffer
+            Stream buffer that throws away everything written to it, so the formatting
+            benchmarks measure the formatting, and not the disk.
+    */
+    class NullBuffer : public std::streambuf
+    {
+    protected:
+        int_type        overflow( int_type c )override                   { return traits_type::not_eof(c); }
+        std::streamsize xsputn  ( const char *, std::streamsize n )override { return n; }
+    };
+
+    /*
+        NullSink
+            Output sink that does nothing, to measure decoding alone.
+    */
+    class NullSink
+    {
+    public:
+        template<class _EntryTy>
+            void BeginTable( const std::string &, uint32_t, size_t ) {}
+
+        template<class _EntryTy>
+            void WriteRow( uint32_t, const _EntryTy & entry, std::optional<std::string_view> symbol )
+        {
+            m_checksum += entry.SymbolPtr() + (symbol? symbol->size() : 0);
+        }
+
+        template<class _EntryTy>
+            void EndTable( typename _EntryTy::Stats & ) {}
+
+        void Finish() {}
+
+        inline uint64_t Checksum()const { return m_checksum; }
+
+    private:
+        uint64_t m_checksum = 0;
+    };
+
+    enum struct eTableKind
+    {
+        Level,
+        Spec,
+        EventSubFile,
+        EntitySymbol,
+        NbKinds,
+    };
+
+    struct SyntheticTable
+    {
+        eTableKind kind;
+        uint32_t   offset;
+        size_t     nbentries;
+        size_t     entrysize;
+    };
+
+    /*
+        SyntheticImage
+            An image laid out like the game's binaries: each table is preceded by the symbols it points to.
+            The rest is filled with low entropy bytes, so it compresses about as well as real code.
+    */
+    struct SyntheticImage
+    {
+        std::vector<uint8_t>        data;
+        uint32_t                    loadoffset = Arm9BinLoadOffset;
+        std::vector<SyntheticTable> tables;
+        std::vector<uint32_t>       symboloffsets;  //File offset of every symbol
+    };
+
+    template<class _EntryTy>
+        void WriteSyntheticTable( SyntheticImage & img, size_t & pos, size_t nbentries, eTableKind kind, std::mt19937 & rng )
+    {
+        std::vector<uint32_t> ptrs;
+        for( size_t i = 0; i < nbentries; ++i )
+        {
+            const std::string symbol = "SYM_" + std::to_string( static_cast<int>(kind) ) + "_" + std::to_string(i);
+            std::copy( symbol.begin(), symbol.end(), img.data.begin() + pos );
+            img.data[pos + symbol.size()] = 0;
+            img.symboloffsets.push_back( static_cast<uint32_t>(pos) );
+            ptrs.push_back( img.loadoffset + static_cast<uint32_t>(pos) );
+            pos += symbol.size() + 1;
+        }
+        pos = (pos + 3) & ~size_t(3);
+
+        img.tables.push_back( SyntheticTable{ kind, static_cast<uint32_t>(pos), nbentries, _EntryTy::Size } );
+        for( size_t i = 0; i < nbentries; ++i, pos += _EntryTy::Size )
+        {
+            ForEachField<_EntryTy>( [&]( const auto & field, size_t offset )
+            {
+                typedef typename std::decay_t<decltype(field)>::field_t field_t;
+                const uint64_t value = (field.format == eFieldFmt::Symbol)? ptrs[i] : (rng() % 300);
+                for( size_t b = 0; b < sizeof(field_t); ++b )
+                    img.data[pos + offset + b] = static_cast<uint8_t>( value >> (b * 8) );
+            });
+        }
+    }
+
+    //Worst case space a table takes, symbols included
+    size_t SyntheticTableSpace( size_t nbentries )
+    {
+        return nbentries * (16 + 12) + 4;
+    }
+
+    SyntheticImage MakeSyntheticImage( size_t imgsize, size_t nbtables, size_t nbentries )
+    {
+        SyntheticImage img;
+        std::mt19937   rng(1234);
+        imgsize = std::max( imgsize, (nbtables * SyntheticTableSpace(nbentries)) + 16 );
+        img.data.resize( imgsize );
+        for( auto & b : img.data )
+            b = static_cast<uint8_t>( rng() & 0x3 );
+
+        //Spread the tables over the image
+        const size_t slotlen = imgsize / std::max<size_t>( nbtables, 1 );
+        for( size_t t = 0; t < nbtables; ++t )
+        {
+            size_t           pos  = t * slotlen;
+            const eTableKind kind = static_cast<eTableKind>( t % static_cast<size_t>(eTableKind::NbKinds) );
+            switch(kind)
+            {
+                case eTableKind::Level:        WriteSyntheticTable<LevelEntry>           ( img, pos, nbentries, kind, rng ); break;
+                case eTableKind::Spec:         WriteSyntheticTable<SpecListEntry>        ( img, pos, nbentries, kind, rng ); break;
+                case eTableKind::EventSubFile: WriteSyntheticTable<EventSubFileListEntry>( img, pos, nbentries, kind, rng ); break;
+                default:                       WriteSyntheticTable<EntitySymbolListEntry>( img, pos, nbentries, kind, rng ); break;
+            };
+        }
+        return img;
+    }
+
+    //Runs ParseAndDumpLUT over every table of the image
+    template<class _sinkTy>
+        void ParseAllTables( const SyntheticImage & img, _sinkTy & out )
+    {
+        const uint8_t * pbeg = img.data.data();
+        const uint8_t * pend = pbeg + img.data.size();
+        for( const auto & tbl : img.tables )
+        {
+            switch(tbl.kind)
+            {
+                case eTableKind::Level:        ParseAndDumpLUT<LevelEntry>           ( tbl.offset, tbl.nbentries, pbeg, pend, out, "Level Table",          img.loadoffset ); break;
+                case eTableKind::Spec:         ParseAndDumpLUT<SpecListEntry>        ( tbl.offset, tbl.nbentries, pbeg, pend, out, "Spec Table",           img.loadoffset ); break;
+                case eTableKind::EventSubFile: ParseAndDumpLUT<EventSubFileListEntry>( tbl.offset, tbl.nbentries, pbeg, pend, out, "Event Sub File Table", img.loadoffset ); break;
+                default:                       ParseAndDumpLUT<EntitySymbolListEntry>( tbl.offset, tbl.nbentries, pbeg, pend, out, "Entity Symbol Table",  img.loadoffset ); break;
+            };
+        }
+        out.Finish();
+    }
+
+    //Calls "fun( tableview )" with a TableView of every table of the image
+    template<class _FunTy>
+        void ForEachTableView( const SyntheticImage & img, _FunTy && fun )
+    {
+        const uint8_t * pbeg = img.data.data();
+        const uint8_t * pend = pbeg + img.data.size();
+        for( const auto & tbl : img.tables )
+        {
+            switch(tbl.kind)
+            {
+                case eTableKind::Level:        fun( TableView<LevelEntry>           ( pbeg, pend, tbl.offset, tbl.nbentries, img.loadoffset ) ); break;
+                case eTableKind::Spec:         fun( TableView<SpecListEntry>        ( pbeg, pend, tbl.offset, tbl.nbentries, img.loadoffset ) ); break;
+                case eTableKind::EventSubFile: fun( TableView<EventSubFileListEntry>( pbeg, pend, tbl.offset, tbl.nbentries, img.loadoffset ) ); break;
+                default:                       fun( TableView<EntitySymbolListEntry>( pbeg, pend, tbl.offset, tbl.nbentries, img.loadoffset ) ); break;
+            };
+        }
+    }
+
+    // ----------------------------------------------------------------------------------------
+    struct BenchResult
+    {
+        std::string name;
+        uint64_t    iterations = 0;
+        double      seconds    = 0;
+        uint64_t    records    = 0;     //Records processed per iteration
+        uint64_t    bytes      = 0;     //Bytes processed per iteration
+
+        double NsPerIteration  ()const { return (seconds * 1e9) / static_cast<double>(iterations); }
+        double RecordsPerSecond()const { return static_cast<double>(records * iterations) / seconds; }
+        double MBPerSecond     ()const { return static_cast<double>(bytes * iterations) / (seconds * 1024.0 * 1024.0); }
+    };
+
+    //Keeps the compiler from dropping the work of a benchmark
+    volatile uint64_t g_sideeffect = 0;
+
+    /*
+        RunBench
+            Calls "fun()" once to warm up, then as many times as fits in "mintime".
+    */
+    BenchResult RunBench( const std::string & name, std::chrono::milliseconds mintime, uint64_t records, uint64_t bytes, const std::function<uint64_t()> & fun )
+    {
+        BenchResult res;
+        res.name    = name;
+        res.records = records;
+        res.bytes   = bytes;
+        g_sideeffect = g_sideeffect + fun();
+
+        auto tstart = std::chrono::steady_clock::now();
+        auto tcur   = tstart;
+        do
+        {
+            g_sideeffect = g_sideeffect + fun();
+            ++res.iterations;
+            tcur = std::chrono::steady_clock::now();
+        }while( (tcur - tstart) < mintime );
+        res.seconds = std::chrono::duration<double>(tcur - tstart).count();
+        return res;
+    }
+
+    void WriteResultsJson( const std::string & fpath, const std::vector<BenchResult> & results, size_t imgsize, size_t nbtables, size_t nbentries, long long mintimems )
+    {
+        std::ofstream out(fpath);
+        if( !out )
+            throw std::runtime_error("Couldn't write the results to " + fpath + "!");
+        out <<"{\n"
+            <<"  \"config\": { \"image_bytes\": " <<imgsize <<", \"tables\": " <<nbtables <<", \"entries_per_table\": " <<nbentries
+            <<", \"min_time_ms\": " <<mintimems <<" },\n"
+            <<"  \"results\": [\n";
+        out <<std::setprecision(6);
+        for( size_t i = 0; i < results.size(); ++i )
+        {
+            const BenchResult & res = results[i];
+            out <<"    { \"name\": \"" <<res.name <<"\", \"iterations\": " <<res.iterations <<", \"seconds\": " <<res.seconds
+                <<", \"ns_per_iteration\": " <<res.NsPerIteration() <<", \"records_per_second\": " <<res.RecordsPerSecond()
+                <<", \"mb_per_second\": " <<res.MBPerSecond() <<" }" <<( (i + 1) < results.size()? "," : "" ) <<"\n";
+        }
+        out <<"  ]\n"
+            <<"}\n";
+    }
+
+    void PrintResults( std::ostream & out, const std::vector<BenchResult> & results )
+    {
+        out <<std::left <<std::setw(34) <<"Benchmark" <<std::right <<std::setw(14) <<"ns/iter" <<std::setw(16) <<"records/s" <<std::setw(12) <<"MB/s" <<"\n"
+            <<std::string( 76, '-' ) <<"\n";
+        for( const auto & res : results )
+        {
+            out <<std::left <<std::setw(34) <<res.name <<std::right <<std::fixed <<std::setprecision(0)
+                <<std::setw(14) <<res.NsPerIteration() <<std::setw(16) <<res.RecordsPerSecond()
+                <<std::setprecision(1) <<std::setw(12) <<res.MBPerSecond() <<"\n";
+        }
+    }
+}
+
+int main( int argc, const char * argv[] )
+{
+    size_t      imgsize     = 720 * 1024;
+    size_t      nbtables    = 4;
+    size_t      nbentries   = 500;
+    long long   mintimems   = 300;
+    std::string filter;
+    std::string outpath     = "bench_results.json";
+
+    try
+    {
+        for( int i = 1; i < argc; ++i )
+        {
+            const std::string arg     = argv[i];
+            const bool        hasnext = (i + 1) < argc;
+            if( arg == "--size-kb" && hasnext )
+                imgsize = std::stoul( argv[++i] ) * 1024;
+            else if( arg == "--tables" && hasnext )
+                nbtables = std::stoul( argv[++i] );
+            else if( arg == "--entries" && hasnext )
+                nbentries = std::stoul( argv[++i] );
+            else if( arg == "--min-time-ms" && hasnext )
+                mintimems = std::stoll( argv[++i] );
+            else if( arg == "--filter" && hasnext )
+                filter = argv[++i];
+            else if( arg == "--out" && hasnext )
+                outpath = argv[++i];
+            else
+            {
+                std::cout <<"Usage: pmd2_benchmarks [--size-kb <n>] [--tables <n>] [--entries <n>] [--min-time-ms <n>] [--filter <text>] [--out <results.json>]\n";
+                return (arg == "--help" || arg == "-h")? 0 : 1;
+            }
+        }
+
+        const SyntheticImage img     = MakeSyntheticImage( imgsize, nbtables, nbentries );
+        const uint8_t *      pbeg    = img.data.data();
+        const uint8_t *      pend    = pbeg + img.data.size();
+        const auto           mintime = std::chrono::milliseconds(mintimems);
+        std::cout <<"Synthetic image: " <<img.data.size() <<" bytes, " <<img.tables.size() <<" tables of " <<nbentries <<" entries\n\n";
+
+        uint64_t nbrecords  = 0;
+        uint64_t tablebytes = 0;
+        for( const auto & tbl : img.tables )
+        {
+            nbrecords  += tbl.nbentries;
+            tablebytes += tbl.nbentries * tbl.entrysize;
+        }
+        uint64_t symbolbytes = 0;
+        for( uint32_t offs : img.symboloffsets )
+            symbolbytes += safestrlen( pbeg + offs, pend ) + 1;
+
+        //The values LimitVal is fed, taken from the images' 16 bits fields
+        std::vector<int16_t> values16( img.data.size() / 2 );
+        for( size_t i = 0; i < values16.size(); ++i )
+            values16[i] = LoadIntLE<int16_t>( pbeg + (i * 2) );
+
+        std::vector<uint8_t> compressed = BLZCompress( pbeg, img.data.size() );
+
+        NullBuffer   nullbuf;
+        std::ostream nullout( &nullbuf );
+
+        std::vector<BenchResult> results;
+        auto lambdaBench = [&]( const std::string & name, uint64_t records, uint64_t bytes, const std::function<uint64_t()> & fun )
+        {
+            if( !filter.empty() && name.find(filter) == std::string::npos )
+                return;
+            results.push_back( RunBench( name, mintime, records, bytes, fun ) );
+        };
+
+        lambdaBench( "ReadIntFromBytes<uint32_t>", img.data.size() / 4, img.data.size(), [&]()
+        {
+            uint64_t    sum = 0;
+            const uint8_t * it = pbeg;
+            for( size_t i = 0; i < img.data.size() / 4; ++i )
+                sum += ReadIntFromBytes<uint32_t>( it, pend );
+            return sum;
+        });
+
+        lambdaBench( "LoadIntLE<uint32_t>", img.data.size() / 4, img.data.size(), [&]()
+        {
+            uint64_t sum = 0;
+            for( size_t i = 0; i < img.data.size() / 4; ++i )
+                sum += LoadIntLE<uint32_t>( pbeg + (i * 4) );
+            return sum;
+        });
+
+        lambdaBench( "safestrlen", img.symboloffsets.size(), symbolbytes, [&]()
+        {
+            uint64_t sum = 0;
+            for( uint32_t offs : img.symboloffsets )
+                sum += safestrlen( pbeg + offs, pend );
+            return sum;
+        });
+
+        lambdaBench( "FetchString", img.symboloffsets.size(), symbolbytes, [&]()
+        {
+            uint64_t sum = 0;
+            for( uint32_t offs : img.symboloffsets )
+                sum += FetchString( offs, pbeg, pend ).size();
+            return sum;
+        });
+
+        //Indexed per table, like ParseAndDumpLUT() does, with the indexing counted in
+        lambdaBench( "StringIndex::Fetch", img.symboloffsets.size(), symbolbytes, [&]()
+        {
+            uint64_t sum  = 0;
+            size_t   next = 0;
+            for( const SyntheticTable & tbl : img.tables )
+            {
+                const StringIndex strings( pbeg, pend, img.symboloffsets[next], img.symboloffsets[next + tbl.nbentries - 1] );
+                for( size_t i = 0; i < tbl.nbentries; ++i )
+                    sum += strings.Fetch( img.symboloffsets[next + i] ).size();
+                next += tbl.nbentries;
+            }
+            return sum;
+        });
+
+        lambdaBench( "LimitVal<int16_t>::Process", values16.size(), values16.size() * sizeof(int16_t), [&]()
+        {
+            LimitVal<int16_t> stat;
+            for( int16_t v : values16 )
+                stat.Process(v);
+            return stat.cntavg + static_cast<uint64_t>(stat.accavg);
+        });
+
+        lambdaBench( "ParseAndDumpLUT/decode", nbrecords, tablebytes, [&]()
+        {
+            NullSink sink;
+            ParseAllTables( img, sink );
+            return sink.Checksum();
+        });
+
+        lambdaBench( "ParseAndDumpLUT/text", nbrecords, tablebytes, [&]()
+        {
+            TextSink sink(nullout);
+            ParseAllTables( img, sink );
+            return uint64_t(1);
+        });
+
+        lambdaBench( "ParseAndDumpLUT/jsonl", nbrecords, tablebytes, [&]()
+        {
+            JsonLinesSink sink(nullout);
+            ParseAllTables( img, sink );
+            return uint64_t(1);
+        });
+
+        lambdaBench( "ParseAndDumpLUT/coverage", nbrecords, tablebytes, [&]()
+        {
+            CoverageMap  map( img.data.size() );
+            CoverageSink sink( map, pbeg );
+            ParseAllTables( img, sink );
+            return static_cast<uint64_t>( map.NbCovered() );
+        });
+
+        //Summarizing a binary once its tables are marked, which batches do for every ROM
+        CoverageMap coveredimg( img.data.size() );
+        {
+            CoverageSink sink( coveredimg, pbeg );
+            ParseAllTables( img, sink );
+        }
+        lambdaBench( "CoverageMap/summary", 1, img.data.size(), [&]()
+        {
+            return static_cast<uint64_t>( coveredimg.NbCovered() + coveredimg.Gaps().size() );
+        });
+
+        lambdaBench( "TableView/all", nbrecords, tablebytes, [&]()
+        {
+            uint64_t sum = 0;
+            ForEachTableView( img, [&sum]( const auto & view )
+            {
+                for( auto row : view )
+                {
+                    sum += row.Entry().SymbolPtr();
+                    sum += row.Symbol()? row.Symbol()->size() : 0;
+                }
+            });
+            return sum;
+        });
+
+        //What a tool reading a handful of rows pays, instead of dumping everything
+        const size_t SampleStride = 64;
+        lambdaBench( "TableView/sample", nbrecords / SampleStride, tablebytes / SampleStride, [&]()
+        {
+            uint64_t sum = 0;
+            ForEachTableView( img, [&]( const auto & view )
+            {
+                for( size_t i = 0; i < view.size(); i += SampleStride )
+                    sum += view[i].Entry().SymbolPtr() + view[i].Symbol()->size();
+            });
+            return sum;
+        });
+
+        //One table referring to the ids of another, a few of them dangling, like the event list's ids
+        SymbolIndex joinindex;
+        {
+            const uint32_t  lefttbl  = joinindex.AddTable( "left",  { "refid" } );
+            const uint32_t  righttbl = joinindex.AddTable( "right", { "id" } );
+            std::mt19937    rng(1234);
+            for( uint32_t i = 0; i < nbrecords; ++i )
+            {
+                const int64_t refid = static_cast<int64_t>( rng() % (nbrecords + (nbrecords / 16) + 1) );
+                const int64_t id    = i;
+                joinindex.AddRow( lefttbl,  i * 12, &refid, std::nullopt );
+                joinindex.AddRow( righttbl, i * 12, &id,    std::nullopt );
+            }
+        }
+        const JoinSpec joinspec = ParseJoinSpec( "left.refid=right.id" );
+        lambdaBench( "RunJoin", nbrecords * 2, 0, [&]()
+        {
+            const JoinSummary summary = RunJoin( joinindex, joinspec, nullout );
+            return static_cast<uint64_t>( summary.nbmatches + summary.nbdangling + summary.nbunused );
+        });
+
+        //Hack bases recognized by strings that aren't in the image, so the whole image is searched
+        BuildDatabase builds;
+        for( int i = 0; i < 8; ++i )
+        {
+            BuildProfile profile;
+            profile.name = "Hack base " + std::to_string(i);
+            profile.patterns.push_back( BuildPattern{ eBuildBinary::Arm9, std::vector<uint8_t>{ 'H', 'A', 'C', 'K', static_cast<uint8_t>('0' + i), 0xFF } } );
+            builds.Add( std::move(profile) );
+        }
+        const std::vector<BuildImage> buildimages { BuildImage{ eBuildBinary::Arm9, ByteRange{ img.data.data(), img.data.data() + img.data.size() }, img.loadoffset } };
+        lambdaBench( "BuildDatabase::Identify", 1, img.data.size(), [&]()
+        {
+            return static_cast<uint64_t>( builds.Identify( "", buildimages ).nbpatterns );
+        });
+
+        if( !compressed.empty() )
+        {
+            std::vector<uint8_t> decompressed( img.data.size() );
+            lambdaBench( "BLZDecompress", 1, img.data.size(), [&]()
+            {
+                BLZDecompress( compressed.data(), compressed.size(), decompressed.data(), decompressed.size() );
+                return uint64_t( decompressed[0] );
+            });
+        }
+
+        PrintResults( std::cout, results );
+        WriteResultsJson( outpath, results, img.data.size(), img.tables.size(), nbentries, mintimems );
+        std::cout <<"\nResults written to " <<outpath <<"\n";
+    }
+    catch( const std::exception & e )
+    {
+        std::cerr <<"<!>- Error: " <<e.what() <<"\n";
+        return 1;
+    }
+    return 0;
+}
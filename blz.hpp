@@ -0,0 +1,287 @@
+#ifndef BLZ_HPP
+#define BLZ_HPP
+/*
+blz.hpp
+    Backward LZ77 ("BLZ"), the compression Nintendo's SDK uses for the arm9 binary and the overlays.
+
+    A compressed binary starts with a plain uncompressed part, followed by the compressed data, and
+    ends with a 8 bytes footer. The compressed data is read backward, from the footer toward the
+    start of the file, and it fills the output buffer from its end toward its start.
+
+    Footer, at the very end of the compressed region:
+        uint24  enclen      Length of the compressed part, footer and padding included
+        uint8   hdrlen      Length of the footer, plus 0xFF padding bytes placed before it
+        uint32  inclen      How many bytes larger the decompressed data is than the compressed region
+
+    The decompressor never allocates: the caller queries the decompressed size, and passes a buffer
+    that large.
+*/
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace blz
+{
+    const size_t   FooterLen       = 8;
+    const size_t   MaxHeaderLen    = FooterLen + 3;   //The footer is 4 bytes aligned with up to 3 padding bytes
+    const size_t   MinMatchLen     = 3;
+    const size_t   MaxMatchLen     = 0xF + MinMatchLen;
+    const size_t   MinMatchDisp    = 3;
+    const size_t   MaxMatchDisp    = 0xFFF + MinMatchDisp;
+    const size_t   ModuleParamsMaxSearch = 0x8000;  //How far into the arm9 to look for the module params
+
+    //Magic numbers at the end of the arm9's "ModuleParams" struct
+    const uint32_t NitroCodeBE     = 0xDEC00621;
+    const uint32_t NitroCodeLE     = 0x2106C0DE;
+    //Offset of the magic numbers and of the "compressed static end" address in the ModuleParams struct
+    const size_t   OffsModParamsMagic       = 0x1C;
+    const size_t   OffsModParamsCompStatEnd = 0x14;
+
+    inline uint32_t ReadU32LE( const uint8_t * p )
+    {
+        return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+    struct FooterInfo
+    {
+        size_t enclen = 0;
+        size_t hdrlen = 0;
+        size_t inclen = 0;
+    };
+
+    //Parses the footer at the end of the region. Returns false if it doesn't look like a valid BLZ footer.
+    inline bool ReadFooter( const uint8_t * src, size_t srclen, FooterInfo & info )
+    {
+        if( srclen < FooterLen )
+            return false;
+        const uint8_t * pfooter = src + srclen - FooterLen;
+        info.enclen = ReadU32LE(pfooter) & 0x00FFFFFF;
+        info.hdrlen = pfooter[3];
+        info.inclen = ReadU32LE(pfooter + 4);
+
+        if( info.inclen == 0 || info.hdrlen < FooterLen || info.hdrlen > MaxHeaderLen || info.enclen < info.hdrlen || info.enclen > srclen )
+            return false;
+        //Padding between the compressed data and the footer
+        for( size_t i = FooterLen; i < info.hdrlen; ++i )
+        {
+            if( src[srclen - 1 - i] != 0xFF )
+                return false;
+        }
+        return true;
+    }
+}
+
+/*
+    BLZIsCompressed
+        Whether the region ends with a valid BLZ footer.
+*/
+inline bool BLZIsCompressed( const uint8_t * src, size_t srclen )
+{
+    blz::FooterInfo info;
+    return blz::ReadFooter( src, srclen, info );
+}
+
+/*
+    BLZDecompressedSize
+        Size of the decompressed data for a compressed region.
+*/
+inline size_t BLZDecompressedSize( const uint8_t * src, size_t srclen )
+{
+    blz::FooterInfo info;
+    if( !blz::ReadFooter( src, srclen, info ) )
+        throw std::runtime_error("BLZDecompressedSize(): The data isn't BLZ compressed!");
+    return srclen + info.inclen;
+}
+
+/*
+    BLZDecompress
+        Decompresses the region into "dst". "dstlen" must be the value BLZDecompressedSize() returned.
+        Throws if the compressed data is corrupted.
+*/
+inline void BLZDecompress( const uint8_t * src, size_t srclen, uint8_t * dst, size_t dstlen )
+{
+    blz::FooterInfo info;
+    if( !blz::ReadFooter( src, srclen, info ) )
+        throw std::runtime_error("BLZDecompress(): The data isn't BLZ compressed!");
+    if( dstlen != srclen + info.inclen )
+        throw std::runtime_error("BLZDecompress(): The destination buffer has the wrong size!");
+
+    //The start of the file isn't compressed
+    const size_t plainlen = srclen - info.enclen;
+    std::memcpy( dst, src, plainlen );
+
+    const uint8_t * pakbeg = src + plainlen;
+    const uint8_t * pakend = src + srclen - info.hdrlen;
+    uint8_t *       rawbeg = dst + plainlen;
+    uint8_t *       rawend = dst + dstlen;
+
+    while( rawend > rawbeg )
+    {
+        if( pakend <= pakbeg )
+            throw std::runtime_error("BLZDecompress(): Ran out of compressed data!");
+        const uint8_t flags = *(--pakend);
+
+        for( uint8_t mask = 0x80; mask != 0 && rawend > rawbeg; mask >>= 1 )
+        {
+            if( !(flags & mask) )
+            {
+                if( pakend <= pakbeg )
+                    throw std::runtime_error("BLZDecompress(): Ran out of compressed data!");
+                *(--rawend) = *(--pakend);
+                continue;
+            }
+
+            if( (pakend - pakbeg) < 2 )
+                throw std::runtime_error("BLZDecompress(): Ran out of compressed data!");
+            size_t info16 = static_cast<size_t>( *(--pakend) ) << 8;
+            info16       |= *(--pakend);
+            size_t len    = (info16 >> 12) + blz::MinMatchLen;
+            size_t disp   = (info16 & 0xFFF) + blz::MinMatchDisp;
+
+            if( len > static_cast<size_t>(rawend - rawbeg) )
+                len = static_cast<size_t>(rawend - rawbeg);
+            if( disp > static_cast<size_t>( (dst + dstlen) - rawend ) )
+                throw std::runtime_error("BLZDecompress(): A match points past the end of the output!");
+
+            //The source and destination overlap when disp < len, so this has to go byte by byte
+            for( ; len != 0; --len )
+            {
+                --rawend;
+                *rawend = rawend[disp];
+            }
+        }
+    }
+}
+
+/*
+    BLZFindArm9CompressedEnd
+        Compressed arm9 binaries don't end with the BLZ footer: the "ModuleParams" struct inside the
+        arm9 holds the address where the compressed part ends instead. Returns the offset of that end
+        in the binary, or 0 if the arm9 isn't compressed or has no ModuleParams.
+*/
+inline size_t BLZFindArm9CompressedEnd( const uint8_t * src, size_t srclen, uint32_t ramaddr )
+{
+    const size_t searchlen = std::min( srclen, blz::ModuleParamsMaxSearch );
+    for( size_t off = blz::OffsModParamsMagic; (off + 8) <= searchlen; off += 4 )
+    {
+        if( blz::ReadU32LE(src + off) != blz::NitroCodeLE || blz::ReadU32LE(src + off + 4) != blz::NitroCodeBE )
+            continue;
+        const uint32_t compend = blz::ReadU32LE( src + off - blz::OffsModParamsMagic + blz::OffsModParamsCompStatEnd );
+        if( compend <= ramaddr || (compend - ramaddr) > srclen )
+            return 0;
+        return compend - ramaddr;
+    }
+    return 0;
+}
+
+/*
+    BLZCompress
+        Compresses a buffer, greedily picking the longest match among the last few candidates.
+        Not as tight as Nintendo's encoder, but produces data any BLZ decoder reads.
+        Returns an empty vector if compressing doesn't make the data smaller.
+*/
+inline std::vector<uint8_t> BLZCompress( const uint8_t * src, size_t srclen )
+{
+    using namespace blz;
+    const size_t  HashBits   = 14;
+    const size_t  MaxChain   = 32;
+    const int64_t NoPos      = -1;
+
+    //Matches are searched going backward from the end, so the hash chains index the reversed data
+    std::vector<int64_t> head( size_t(1) << HashBits, NoPos );
+    std::vector<int64_t> chain( srclen, NoPos );
+    auto lambdaHashAt = [src]( size_t pos ) //Hash of the 3 bytes ending at pos
+    {
+        uint32_t v = (static_cast<uint32_t>(src[pos]) << 16) | (static_cast<uint32_t>(src[pos - 1]) << 8) | src[pos - 2];
+        return static_cast<size_t>( (v * 2654435761u) >> (32 - HashBits) );
+    };
+    auto lambdaInsert = [&]( size_t pos )
+    {
+        if( pos < 2 )
+            return;
+        size_t h   = lambdaHashAt(pos);
+        chain[pos] = head[h];
+        head[h]    = static_cast<int64_t>(pos);
+    };
+
+    //Tokens are built in the order the decoder reads them, and reversed at the end
+    std::vector<uint8_t> tokens;
+    tokens.reserve( srclen + (srclen / 8) + 1 );
+    size_t  remaining = srclen;     //Bytes left to encode, the next one is src[remaining - 1]
+    size_t  flagpos   = 0;
+    uint8_t flagmask  = 0;
+
+    while( remaining > 0 )
+    {
+        if( flagmask == 0 )
+        {
+            flagpos = tokens.size();
+            tokens.push_back(0);
+            flagmask = 0x80;
+        }
+
+        const size_t cur     = remaining - 1;
+        size_t       bestlen = 0;
+        size_t       bestdisp= 0;
+        if( cur >= 2 )
+        {
+            int64_t cand = head[lambdaHashAt(cur)];
+            for( size_t nbtries = 0; cand != NoPos && nbtries < MaxChain; ++nbtries, cand = chain[static_cast<size_t>(cand)] )
+            {
+                const size_t disp = static_cast<size_t>(cand) - cur;
+                if( disp > MaxMatchDisp )
+                    break;
+                if( disp < MinMatchDisp )
+                    continue;
+                size_t len = 0;
+                while( len < MaxMatchLen && len <= cur && src[cur - len] == src[cur - len + disp] )
+                    ++len;
+                if( len > bestlen )
+                {
+                    bestlen  = len;
+                    bestdisp = disp;
+                }
+            }
+        }
+
+        if( bestlen >= MinMatchLen )
+        {
+            tokens[flagpos] |= flagmask;
+            const size_t info16 = ((bestlen - MinMatchLen) << 12) | (bestdisp - MinMatchDisp);
+            tokens.push_back( static_cast<uint8_t>(info16 >> 8) );
+            tokens.push_back( static_cast<uint8_t>(info16 & 0xFF) );
+            for( size_t i = 0; i < bestlen; ++i )
+                lambdaInsert( cur - i );
+            remaining -= bestlen;
+        }
+        else
+        {
+            tokens.push_back( src[cur] );
+            lambdaInsert(cur);
+            --remaining;
+        }
+        flagmask >>= 1;
+    }
+
+    const size_t padding = (4 - ((tokens.size() + FooterLen) % 4)) % 4;
+    const size_t hdrlen  = FooterLen + padding;
+    const size_t enclen  = tokens.size() + hdrlen;
+    if( enclen >= srclen || enclen > 0x00FFFFFF )
+        return std::vector<uint8_t>();
+
+    std::vector<uint8_t> out( tokens.rbegin(), tokens.rend() );
+    out.insert( out.end(), padding, 0xFF );
+    const uint32_t inclen = static_cast<uint32_t>(srclen - enclen);
+    const uint8_t  footer[FooterLen] =
+    {
+        static_cast<uint8_t>(enclen), static_cast<uint8_t>(enclen >> 8), static_cast<uint8_t>(enclen >> 16), static_cast<uint8_t>(hdrlen),
+        static_cast<uint8_t>(inclen), static_cast<uint8_t>(inclen >> 8), static_cast<uint8_t>(inclen >> 16), static_cast<uint8_t>(inclen >> 24),
+    };
+    out.insert( out.end(), footer, footer + FooterLen );
+    return out;
+}
+
+#endif
@@ -0,0 +1,715 @@
+#ifndef BUILDPROFILES_HPP
+#define BUILDPROFILES_HPP
+/*
+buildprofiles.hpp
+    Identifies which game, region and build a binary comes from, to know where its tables are.
+
+    A build profile gives the game code in the ROM header, the load addresses of the arm9 and
+    overlay 11, where the tables are in each, and byte patterns found only in that build. The
+    patterns of every profile are searched in a single pass over each binary, with an Aho-Corasick
+    automaton. A binary then matches the profiles whose game code is the ROM's, whose patterns it
+    all contains, or whose tables are all valid at the profile's locations. The profile with the
+    most patterns found wins, so a hack base is told apart from the build it's based on.
+
+    Only the layout of Explorers of Sky (NA) is bundled, since it's the only one this tool was
+    verified against. The other builds of Time, Darkness and Sky are recognized by their game code,
+    and their tables are looked for from the NA locations, as before. Signature files add profiles
+    for other builds and hack bases, see ParseSignatureFile().
+*/
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstddef>
+#include <fstream>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "eventtables.hpp"
+#include "lutscanner.hpp"
+#include "ndsrom.hpp"
+#include "xxh64.hpp"
+
+enum struct eBuildBinary : uint8_t
+{
+    Arm9,
+    Overlay11,
+};
+
+/*
+    BuildPattern
+        Bytes found somewhere in one of the binaries of a build.
+*/
+struct BuildPattern
+{
+    eBuildBinary         binary = eBuildBinary::Arm9;
+    std::vector<uint8_t> bytes;
+};
+
+/*
+    BuildProfile
+        A build of the game, how to recognize it, and where its tables are.
+        Tables the profile doesn't list are looked for at their Explorers of Sky (NA) location first.
+*/
+struct BuildProfile
+{
+    std::string               name;                                         //Ex: "Explorers of Sky (NA)"
+    std::string               gamecode;                                     //Game code in the header, '?' matches any character. Empty if unknown.
+    uint32_t                  arm9loadoffset      = Arm9BinLoadOffset;      //Used for extracted binaries, ROM images have theirs in the header
+    uint32_t                  overlay11loadoffset = Overlay_0011LoadOffset;
+    std::vector<KnownLUT>     arm9luts;
+    std::vector<KnownLUT>     overlay11luts;
+    std::vector<BuildPattern> patterns;
+
+    inline const std::vector<KnownLUT> & LUTs( eBuildBinary binary )const
+    {
+        return (binary == eBuildBinary::Arm9)? arm9luts : overlay11luts;
+    }
+
+    inline uint32_t LoadOffset( eBuildBinary binary )const
+    {
+        return (binary == eBuildBinary::Arm9)? arm9loadoffset : overlay11loadoffset;
+    }
+};
+
+/*
+    BuildImage
+        An unpacked binary to identify. "loadoffset" is 0 for an extracted binary, whose load
+        address isn't known until its build is.
+*/
+struct BuildImage
+{
+    eBuildBinary binary     = eBuildBinary::Arm9;
+    ByteRange    bin;
+    uint32_t     loadoffset = 0;
+};
+
+/*
+    BuildMatch
+        The profile picked for a binary, and what it was picked on. When nothing matched,
+        "pprofile" is the default profile, and "bidentified" is false.
+*/
+struct BuildMatch
+{
+    const BuildProfile * pprofile    = nullptr;
+    bool                 bidentified = false;
+    bool                 bgamecode   = false;   //The game code in the header is the profile's
+    size_t               nbpatterns  = 0;       //Patterns of the profile found in the binaries
+    bool                 blayout     = false;   //The tables are all at the profile's locations
+};
+
+namespace buildprofiles
+{
+    /*
+        TableSlot
+            One of the dumped tables, the binary it's in, and its record layout.
+    */
+    struct TableSlot
+    {
+        const KnownLUT * pdefault;
+        eBuildBinary     binary;
+        size_t           stride;
+        size_t           ptroffset;
+    };
+
+    inline const std::vector<TableSlot> & Tables()
+    {
+        static const std::vector<TableSlot> Slots
+        {
+            { &EntitySymbolsEoS,    eBuildBinary::Arm9,      EntitySymbolListEntry::Size, EntitySymbolListEntry::PtrOffset() },
+            { &EventListEoS,        eBuildBinary::Arm9,      LevelEntry::Size,            LevelEntry::PtrOffset() },
+            { &EventSubFileListEoS, eBuildBinary::Overlay11, EventSubFileListEntry::Size, EventSubFileListEntry::PtrOffset() },
+            { &SpecialListEoS,      eBuildBinary::Overlay11, SpecListEntry::Size,         SpecListEntry::PtrOffset() },
+        };
+        return Slots;
+    }
+
+    inline const TableSlot * FindTable( const std::string & tblname )
+    {
+        for( const TableSlot & slot : Tables() )
+        {
+            if( slot.pdefault->tblname == tblname )
+                return &slot;
+        }
+        return nullptr;
+    }
+
+    inline bool GameCodeMatches( std::string_view pattern, std::string_view gamecode )
+    {
+        if( pattern.size() != gamecode.size() )
+            return false;
+        for( size_t i = 0; i < pattern.size(); ++i )
+        {
+            if( pattern[i] != '?' && pattern[i] != gamecode[i] )
+                return false;
+        }
+        return true;
+    }
+
+    /*
+        BundledProfiles
+            Explorers of Sky (NA) comes first, it's the default for binaries nothing matched.
+    */
+    inline std::vector<BuildProfile> BundledProfiles()
+    {
+        struct CodeName
+        {
+            const char * gamecode;
+            const char * name;
+        };
+        static const CodeName OtherBuilds[] =
+        {
+            { "C2SP", "Explorers of Sky (EU)" },
+            { "C2SJ", "Explorers of Sky (JP)" },
+            { "YFTE", "Explorers of Time (NA)" },
+            { "YFTP", "Explorers of Time (EU)" },
+            { "YFTJ", "Explorers of Time (JP)" },
+            { "YFYE", "Explorers of Darkness (NA)" },
+            { "YFYP", "Explorers of Darkness (EU)" },
+            { "YFYJ", "Explorers of Darkness (JP)" },
+        };
+
+        std::vector<BuildProfile> profiles(1);
+        profiles.front().name          = "Explorers of Sky (NA)";
+        profiles.front().gamecode      = "C2SE";
+        profiles.front().arm9luts      = { EntitySymbolsEoS, EventListEoS };
+        profiles.front().overlay11luts = { EventSubFileListEoS, SpecialListEoS };
+        for( const CodeName & build : OtherBuilds )
+        {
+            BuildProfile profile;
+            profile.name     = build.name;
+            profile.gamecode = build.gamecode;
+            profiles.push_back( std::move(profile) );
+        }
+        return profiles;
+    }
+}
+
+/*
+    MultiPatternMatcher
+        Aho-Corasick automaton finding any number of byte patterns in a single pass over the data.
+        The automaton is a full transition table, one step per byte whatever the number of patterns.
+        Once built, each transition holds the offset of the next state's row in the table, with the
+        high bit set if that state ends a pattern, so a step is a single load.
+        Most of the data doesn't start any pattern, and each step depends on the previous one, so
+        while at the root, the data is skipped up to the next byte that starts a pattern instead.
+        With SSE2 and up to 4 distinct first bytes, that's done 16 bytes at a time.
+*/
+class MultiPatternMatcher
+{
+public:
+    MultiPatternMatcher()
+        :m_next( 256, NoState ), m_outputs(1)
+    {}
+
+    //Returns the index of the pattern. Build() must be called after the last one is added.
+    size_t Add( const std::vector<uint8_t> & pattern )
+    {
+        if( pattern.empty() )
+            throw std::runtime_error("MultiPatternMatcher::Add(): Empty patterns can't be matched!");
+        uint32_t state = 0;
+        for( uint8_t c : pattern )
+        {
+            uint32_t & next = m_next[(state * 256) + c];
+            if( next == NoState )
+            {
+                next = static_cast<uint32_t>( m_outputs.size() );
+                m_outputs.emplace_back();
+                m_next.resize( m_next.size() + 256, NoState );
+            }
+            state = m_next[(state * 256) + c];
+        }
+        m_outputs[state].push_back( static_cast<uint32_t>(m_nbpatterns) );
+        return m_nbpatterns++;
+    }
+
+    //Fills in the failure transitions, breadth first
+    void Build()
+    {
+        std::vector<uint32_t> fail( m_outputs.size(), 0 );
+        std::vector<uint32_t> queue;
+        for( size_t c = 0; c < 256; ++c )
+        {
+            if( m_next[c] == NoState )
+                m_next[c] = 0;
+            else
+                queue.push_back( m_next[c] );
+        }
+        for( size_t i = 0; i < queue.size(); ++i )
+        {
+            const uint32_t state = queue[i];
+            const std::vector<uint32_t> & failout = m_outputs[fail[state]];
+            m_outputs[state].insert( m_outputs[state].end(), failout.begin(), failout.end() );
+            for( size_t c = 0; c < 256; ++c )
+            {
+                uint32_t & next = m_next[(state * 256) + c];
+                if( next == NoState )
+                    next = m_next[(fail[state] * 256) + c];
+                else
+                {
+                    fail[next] = m_next[(fail[state] * 256) + c];
+                    queue.push_back(next);
+                }
+            }
+        }
+        for( uint32_t & next : m_next )
+            next = (next * 256) | ( m_outputs[next].empty()? 0 : OutputFlag );
+
+        m_nbstarts = 0;
+        for( size_t c = 0; c < 256; ++c )
+        {
+            m_bstarts[c] = m_next[c] != 0;
+            if( m_bstarts[c] && m_nbstarts++ < MaxVecStarts )
+                m_starts[m_nbstarts - 1] = static_cast<uint8_t>(c);
+        }
+    }
+
+    inline size_t NbPatterns()const { return m_nbpatterns; }
+
+    /*
+        Find
+            Sets "found" for every pattern in the data. Stops as soon as all of them were found.
+            Returns the number of patterns found.
+    */
+    size_t Find( const uint8_t * beg, const uint8_t * end, std::vector<bool> & found )const
+    {
+        found.assign( m_nbpatterns, false );
+        size_t   nbfound = 0;
+        uint32_t row     = 0;
+        for( const uint8_t * p = beg; p != end; ++p )
+        {
+            if( row == 0 && (p = SkipToStart( p, end )) == end )
+                break;
+            const uint32_t next = m_next[row + *p];
+            row = next & ~OutputFlag;
+            if( (next & OutputFlag) == 0 )
+                continue;
+            for( uint32_t pat : m_outputs[row / 256] )
+            {
+                if( !found[pat] )
+                {
+                    found[pat] = true;
+                    ++nbfound;
+                }
+            }
+            if( nbfound == m_nbpatterns )
+                break;
+        }
+        return nbfound;
+    }
+
+private:
+    static constexpr uint32_t NoState      = 0xFFFFFFFF;
+    static constexpr uint32_t OutputFlag   = 0x80000000;
+    static constexpr size_t   MaxVecStarts = 4;
+
+    //The first byte at or after "p" that starts a pattern, or "end"
+    const uint8_t * SkipToStart( const uint8_t * p, const uint8_t * end )const
+    {
+#ifdef LUTSCANNER_USE_SSE2
+        if( m_nbstarts != 0 && m_nbstarts <= MaxVecStarts )
+        {
+            __m128i vstarts[MaxVecStarts];
+            for( size_t i = 0; i < MaxVecStarts; ++i )
+                vstarts[i] = _mm_set1_epi8( static_cast<char>( m_starts[ std::min( i, m_nbstarts - 1 ) ] ) );
+            for( ; (end - p) >= 16; p += 16 )
+            {
+                const __m128i data = _mm_loadu_si128( reinterpret_cast<const __m128i*>(p) );
+                const __m128i eq   = _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( data, vstarts[0] ), _mm_cmpeq_epi8( data, vstarts[1] ) ),
+                                                   _mm_or_si128( _mm_cmpeq_epi8( data, vstarts[2] ), _mm_cmpeq_epi8( data, vstarts[3] ) ) );
+                const uint32_t mask = static_cast<uint32_t>( _mm_movemask_epi8(eq) );
+                if( mask != 0 )
+                    return p + CountTrailingZeros(mask);
+            }
+        }
+#endif
+        while( p != end && !m_bstarts[*p] )
+            ++p;
+        return p;
+    }
+
+    static inline unsigned CountTrailingZeros( uint32_t bits )
+    {
+#ifdef _MSC_VER
+        unsigned long idx = 0;
+        _BitScanForward( &idx, bits );
+        return static_cast<unsigned>(idx);
+#else
+        return static_cast<unsigned>( __builtin_ctz(bits) );
+#endif
+    }
+
+private:
+    std::vector<uint32_t>              m_next;         //256 transitions per state
+    std::vector<std::vector<uint32_t>> m_outputs;      //Patterns ending at each state
+    size_t                             m_nbpatterns = 0;
+    bool                               m_bstarts[256] = {};    //Bytes that start a pattern
+    uint8_t                            m_starts [MaxVecStarts] = {};
+    size_t                             m_nbstarts   = 0;
+};
+
+/*
+    BuildDatabase
+        The bundled build profiles, and those loaded from signature files, which take precedence.
+        Must be fully loaded before it's used from several threads.
+*/
+class BuildDatabase
+{
+public:
+    BuildDatabase()
+        :m_profiles( buildprofiles::BundledProfiles() )
+    {
+        Rebuild();
+    }
+
+    //Profiles from signature files go before the bundled ones, so they win ties
+    void Add( BuildProfile profile )
+    {
+        m_profiles.insert( m_profiles.begin() + m_nbuser, std::move(profile) );
+        ++m_nbuser;
+        Rebuild();
+    }
+
+    void LoadSignatureFile( const std::string & fpath );
+
+    inline const std::vector<BuildProfile> & Profiles()const { return m_profiles; }
+    inline const BuildProfile &              Default()const  { return m_profiles[m_nbuser]; }
+
+    /*
+        Fingerprint
+            Hash of the profiles loaded from signature files, 0 if there are none. Dumps made with
+            the bundled profiles alone don't depend on anything else than the binaries.
+    */
+    uint64_t Fingerprint()const
+    {
+        if( m_nbuser == 0 )
+            return 0;
+        XXH64State state;
+        auto lambdaString = [&state]( const std::string & str ){ state.UpdateInt( str.size() ); state.Update( str.data(), str.size() ); };
+        for( size_t i = 0; i < m_nbuser; ++i )
+        {
+            const BuildProfile & profile = m_profiles[i];
+            lambdaString( profile.name );
+            lambdaString( profile.gamecode );
+            state.UpdateInt( profile.arm9loadoffset );
+            state.UpdateInt( profile.overlay11loadoffset );
+            for( const auto * pluts : { &profile.arm9luts, &profile.overlay11luts } )
+            {
+                state.UpdateInt( pluts->size() );
+                for( const KnownLUT & lut : *pluts )
+                {
+                    lambdaString( lut.tblname );
+                    state.UpdateInt( lut.offset );
+                    state.UpdateInt( static_cast<uint64_t>(lut.nbentries) );
+                }
+            }
+            state.UpdateInt( profile.patterns.size() );
+            for( const BuildPattern & pattern : profile.patterns )
+            {
+                state.UpdateInt( static_cast<uint8_t>(pattern.binary) );
+                state.UpdateInt( pattern.bytes.size() );
+                state.Update( pattern.bytes.data(), pattern.bytes.size() );
+            }
+        }
+        return state.Digest();
+    }
+
+    /*
+        Identify
+            Picks the profile of the build the binaries come from. "gamecode" is the one in the ROM
+            header, or empty for extracted binaries. Only the patterns of the binaries given are
+            searched for, so to tell builds apart by their overlay 11 alone, give them overlay 11 patterns.
+    */
+    BuildMatch Identify( std::string_view gamecode, const std::vector<BuildImage> & images )const
+    {
+        PMD2_PROF_TIME(Locate);
+        std::vector<bool> found[2];
+        bool              bsearched[2] = { false, false };
+        for( const BuildImage & img : images )
+        {
+            const size_t b = static_cast<size_t>(img.binary);
+            bsearched[b] = true;
+            if( m_matchers[b].NbPatterns() != 0 )
+                m_matchers[b].Find( img.bin.begin(), img.bin.end(), found[b] );
+        }
+
+        BuildMatch best;
+        size_t     bestnbpatterns = 0;
+        for( size_t i = 0; i < m_profiles.size(); ++i )
+        {
+            const BuildProfile & profile = m_profiles[i];
+            BuildMatch           match;
+            match.pprofile = &profile;
+            if( !gamecode.empty() && !profile.gamecode.empty() )
+            {
+                if( !buildprofiles::GameCodeMatches( profile.gamecode, gamecode ) )
+                    continue;
+                match.bgamecode = true;
+            }
+
+            bool bmissing = false;
+            for( const PatternRef & ref : m_patternrefs[i] )
+            {
+                const size_t b = static_cast<size_t>(ref.binary);
+                if( !bsearched[b] )
+                    continue;
+                if( found[b][ref.index] )
+                    ++match.nbpatterns;
+                else
+                    bmissing = true;
+            }
+            if( bmissing )
+                continue;
+
+            match.blayout     = IsLayoutValid( profile, images );
+            match.bidentified = match.bgamecode || match.nbpatterns != 0 || match.blayout;
+            if( !match.bidentified )
+                continue;
+            if( best.pprofile == nullptr || IsBetterMatch( match, profile.patterns.size(), best, bestnbpatterns ) )
+            {
+                best           = match;
+                bestnbpatterns = profile.patterns.size();
+            }
+        }
+
+        if( best.pprofile == nullptr )
+            best.pprofile = &Default();
+        return best;
+    }
+
+private:
+    struct PatternRef
+    {
+        eBuildBinary binary;
+        size_t       index;     //Index of the pattern in the binary's matcher
+    };
+
+    //More patterns found first, then a matching game code, then the layout, then the most generic profile
+    static bool IsBetterMatch( const BuildMatch & match, size_t nbpatterns, const BuildMatch & best, size_t bestnbpatterns )
+    {
+        if( match.nbpatterns != best.nbpatterns )
+            return match.nbpatterns > best.nbpatterns;
+        if( match.bgamecode != best.bgamecode )
+            return match.bgamecode;
+        if( match.blayout != best.blayout )
+            return match.blayout;
+        return nbpatterns < bestnbpatterns;
+    }
+
+    //Whether the profile lists tables for the binaries, and they're all valid where it says
+    static bool IsLayoutValid( const BuildProfile & profile, const std::vector<BuildImage> & images )
+    {
+        size_t nbchecked = 0;
+        for( const BuildImage & img : images )
+        {
+            const uint32_t loadoffset = (img.loadoffset != 0)? img.loadoffset : profile.LoadOffset(img.binary);
+            LUTLocator     locator( img.bin.begin(), img.bin.end(), loadoffset );
+            for( const KnownLUT & lut : profile.LUTs(img.binary) )
+            {
+                const buildprofiles::TableSlot * pslot = buildprofiles::FindTable( lut.tblname );
+                if( pslot == nullptr || !locator.IsValidTable( lut.offset, lut.nbentries, pslot->stride, pslot->ptroffset ) )
+                    return false;
+                ++nbchecked;
+            }
+        }
+        return nbchecked != 0;
+    }
+
+    void Rebuild()
+    {
+        for( MultiPatternMatcher & matcher : m_matchers )
+            matcher = MultiPatternMatcher();
+        m_patternrefs.assign( m_profiles.size(), std::vector<PatternRef>() );
+        for( size_t i = 0; i < m_profiles.size(); ++i )
+        {
+            for( const BuildPattern & pattern : m_profiles[i].patterns )
+                m_patternrefs[i].push_back( PatternRef{ pattern.binary, m_matchers[static_cast<size_t>(pattern.binary)].Add( pattern.bytes ) } );
+        }
+        for( MultiPatternMatcher & matcher : m_matchers )
+            matcher.Build();
+    }
+
+private:
+    std::vector<BuildProfile>            m_profiles;
+    size_t                               m_nbuser = 0;
+    MultiPatternMatcher                  m_matchers[2];     //One per binary
+    std::vector<std::vector<PatternRef>> m_patternrefs;     //The patterns of each profile
+};
+
+namespace buildprofiles
+{
+    inline std::string Trim( std::string_view text )
+    {
+        size_t beg = 0;
+        size_t end = text.size();
+        while( beg < end && std::isspace( static_cast<unsigned char>(text[beg]) ) )
+            ++beg;
+        while( end > beg && std::isspace( static_cast<unsigned char>(text[end - 1]) ) )
+            --end;
+        return std::string( text.substr( beg, end - beg ) );
+    }
+
+    inline uint32_t ParseU32( const std::string & text )
+    {
+        size_t             len   = 0;
+        unsigned long long value = 0;
+        try
+        {
+            value = std::stoull( text, &len, 0 );
+        }
+        catch( const std::exception & )
+        {
+            len = 0;
+        }
+        if( text.empty() || len != text.size() || value > 0xFFFFFFFFull )
+            throw std::runtime_error("\"" + text + "\" isn't a valid 32 bits integer");
+        return static_cast<uint32_t>(value);
+    }
+
+    //Either a "quoted string", with \" and \\ escapes, or hexadecimal bytes. Ex: "DE AD BE EF"
+    inline std::vector<uint8_t> ParsePatternBytes( const std::string & text )
+    {
+        std::vector<uint8_t> bytes;
+        if( !text.empty() && text.front() == '"' )
+        {
+            size_t i = 1;
+            for( ; i < text.size() && text[i] != '"'; ++i )
+            {
+                if( text[i] == '\\' && (i + 1) < text.size() )
+                    ++i;
+                bytes.push_back( static_cast<uint8_t>(text[i]) );
+            }
+            if( i != (text.size() - 1) )
+                throw std::runtime_error("Unterminated string pattern " + text);
+        }
+        else
+        {
+            std::string digits;
+            for( char c : text )
+            {
+                if( std::isspace( static_cast<unsigned char>(c) ) )
+                    continue;
+                if( !std::isxdigit( static_cast<unsigned char>(c) ) )
+                    throw std::runtime_error("Invalid character in hexadecimal pattern " + text);
+                digits.push_back(c);
+            }
+            if( (digits.size() % 2) != 0 )
+                throw std::runtime_error("Odd number of hexadecimal digits in pattern " + text);
+            for( size_t i = 0; i < digits.size(); i += 2 )
+                bytes.push_back( static_cast<uint8_t>( std::stoul( digits.substr( i, 2 ), nullptr, 16 ) ) );
+        }
+        if( bytes.empty() )
+            throw std::runtime_error("Empty pattern");
+        return bytes;
+    }
+
+    inline void SetProfileValue( BuildProfile & profile, const std::string & key, const std::string & value )
+    {
+        if( key == "gamecode" )
+        {
+            if( value.size() != 4 )
+                throw std::runtime_error("The game code must be 4 characters long, got \"" + value + "\"");
+            profile.gamecode = value;
+        }
+        else if( key == "arm9" )
+            profile.arm9loadoffset = ParseU32(value);
+        else if( key == "overlay11" )
+            profile.overlay11loadoffset = ParseU32(value);
+        else if( key == "arm9.pattern" )
+            profile.patterns.push_back( BuildPattern{ eBuildBinary::Arm9, ParsePatternBytes(value) } );
+        else if( key == "overlay11.pattern" )
+            profile.patterns.push_back( BuildPattern{ eBuildBinary::Overlay11, ParsePatternBytes(value) } );
+        else
+        {
+            for( const TableSlot & slot : Tables() )
+            {
+                if( key != MakeTableId( slot.pdefault->tblname ) )
+                    continue;
+                const size_t sep = value.find_first_of(" \t");
+                if( sep == std::string::npos )
+                    throw std::runtime_error("Expected \"<offset> <nbentries>\" for table " + key);
+                KnownLUT lut;
+                lut.tblname   = slot.pdefault->tblname;
+                lut.offset    = ParseU32( value.substr( 0, sep ) );
+                lut.nbentries = ParseU32( Trim( value.substr(sep) ) );
+                std::vector<KnownLUT> & luts = (slot.binary == eBuildBinary::Arm9)? profile.arm9luts : profile.overlay11luts;
+                luts.push_back( std::move(lut) );
+                return;
+            }
+            throw std::runtime_error("Unknown key \"" + key + "\"");
+        }
+    }
+}
+
+/*
+    ParseSignatureFile
+        Reads build profiles, one section per build, starting with the build's name between brackets.
+        Lines starting with '#' are ignored. Ex:
+            [My hack base (NA)]
+            gamecode          = C2SE
+            arm9              = 0x02000000
+            overlay11         = 0x022DC240
+            event_list_table  = 0xA5490 431
+            arm9.pattern      = "MYHACK v1.2"
+            overlay11.pattern = DE AD BE EF
+        "arm9" and "overlay11" are the load addresses of extracted binaries. Tables are given by
+        table id, with their offset in the unpacked binary and their number of entries. Every key
+        is optional, and patterns can be repeated.
+*/
+inline std::vector<BuildProfile> ParseSignatureFile( std::istream & in, const std::string & fpath )
+{
+    std::vector<BuildProfile> profiles;
+    std::string               line;
+    size_t                    lineno = 0;
+    while( std::getline( in, line ) )
+    {
+        ++lineno;
+        try
+        {
+            const std::string text = buildprofiles::Trim(line);
+            if( text.empty() || text.front() == '#' )
+                continue;
+            if( text.front() == '[' )
+            {
+                if( text.back() != ']' || text.size() < 3 )
+                    throw std::runtime_error("Expected [<build name>]");
+                profiles.emplace_back();
+                profiles.back().name = buildprofiles::Trim( std::string_view(text).substr( 1, text.size() - 2 ) );
+                continue;
+            }
+            if( profiles.empty() )
+                throw std::runtime_error("Expected a [<build name>] section first");
+            const size_t eqpos = text.find('=');
+            if( eqpos == std::string::npos )
+                throw std::runtime_error("Expected <key> = <value>");
+            buildprofiles::SetProfileValue( profiles.back(), buildprofiles::Trim( std::string_view(text).substr( 0, eqpos ) ), buildprofiles::Trim( std::string_view(text).substr( eqpos + 1 ) ) );
+        }
+        catch( const std::exception & e )
+        {
+            throw std::runtime_error("ParseSignatureFile(): " + fpath + ":" + std::to_string(lineno) + ": " + e.what() + "!");
+        }
+    }
+    return profiles;
+}
+
+inline void BuildDatabase::LoadSignatureFile( const std::string & fpath )
+{
+    std::ifstream in(fpath);
+    if( !in.is_open() )
+        throw std::runtime_error("BuildDatabase::LoadSignatureFile(): Couldn't open " + fpath + "!");
+    for( BuildProfile & profile : ParseSignatureFile( in, fpath ) )
+        Add( std::move(profile) );
+}
+
+/*
+    BundledBuilds
+        The database with the bundled profiles only.
+*/
+inline const BuildDatabase & BundledBuilds()
+{
+    static const BuildDatabase Builds;
+    return Builds;
+}
+
+#endif
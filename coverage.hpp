@@ -0,0 +1,286 @@
+#ifndef COVERAGE_HPP
+#define COVERAGE_HPP
+/*
+coverage.hpp
+    Which bytes of a binary the decoded tables explain.
+
+    The records of each table ParseAndDumpLUT walks, and each string FetchString reads for them,
+    terminator included, are marked in a bitmap with one bit per byte of the binary. The number of
+    covered bytes is a popcount of the bitmap's words, and the gaps are found a word at a time,
+    skipping the words that are entirely covered or uncovered, so summarizing a binary costs a
+    fraction of decoding its tables.
+
+    Over a corpus, the gaps are counted by exact range. ROMs of the same build share the same
+    gaps, so the large gaps most ROMs share are where to look for the next undocumented table.
+*/
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <iomanip>
+#include <map>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "textbuffer.hpp"
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+/*
+    ByteSpan
+        A range of file offsets, end excluded.
+*/
+struct ByteSpan
+{
+    uint32_t beg = 0;
+    uint32_t end = 0;
+
+    inline uint32_t size()const { return end - beg; }
+};
+
+// ----------------------------------------------------------------------------------------
+/*
+    CoverageMap
+        One bit per byte of a binary, set once something explained the byte.
+*/
+class CoverageMap
+{
+public:
+    explicit CoverageMap( size_t nbbytes = 0 )
+        :m_nbbytes(nbbytes), m_words( (nbbytes + 63) / 64, 0 )
+    {}
+
+    //Marks the bytes from "beg" up to "end", excluded. Whatever lies past the end of the binary is ignored.
+    void Mark( size_t beg, size_t end )
+    {
+        end = std::min( end, m_nbbytes );
+        if( beg >= end )
+            return;
+        const size_t   wbeg  = beg / 64;
+        const size_t   wlast = (end - 1) / 64;
+        const uint64_t first = ~uint64_t(0) << (beg % 64);
+        const uint64_t last  = ~uint64_t(0) >> (63 - ((end - 1) % 64));
+        if( wbeg == wlast )
+        {
+            m_words[wbeg] |= first & last;
+            return;
+        }
+        m_words[wbeg] |= first;
+        std::fill( m_words.begin() + wbeg + 1, m_words.begin() + wlast, ~uint64_t(0) );
+        m_words[wlast] |= last;
+    }
+
+    size_t NbCovered()const
+    {
+        size_t nbcovered = 0;
+        for( uint64_t word : m_words )
+            nbcovered += PopCount(word);
+        return nbcovered;
+    }
+
+    //Every range of bytes nothing explained, in order
+    std::vector<ByteSpan> Gaps()const
+    {
+        std::vector<ByteSpan> gaps;
+        size_t                pos = 0;
+        for(;;)
+        {
+            const size_t beg = FindNext( pos, false );
+            if( beg >= m_nbbytes )
+                break;
+            pos = FindNext( beg, true );
+            gaps.push_back( ByteSpan{ static_cast<uint32_t>(beg), static_cast<uint32_t>(pos) } );
+        }
+        return gaps;
+    }
+
+    inline size_t NbBytes()const { return m_nbbytes; }
+
+private:
+    //The first byte from "pos" on that's covered, or not, or the size of the binary if there's none
+    size_t FindNext( size_t pos, bool bcovered )const
+    {
+        while( pos < m_nbbytes )
+        {
+            const size_t widx = pos / 64;
+            uint64_t     bits = bcovered? m_words[widx] : ~m_words[widx];
+            bits &= ~uint64_t(0) << (pos % 64);
+            if( bits != 0 )
+                return std::min( (widx * 64) + CountTrailingZeros(bits), m_nbbytes );
+            pos = (widx + 1) * 64;
+        }
+        return m_nbbytes;
+    }
+
+    static inline size_t PopCount( uint64_t bits )
+    {
+#ifdef _MSC_VER
+        return static_cast<size_t>( __popcnt64(bits) );
+#else
+        return static_cast<size_t>( __builtin_popcountll(bits) );
+#endif
+    }
+
+    static inline size_t CountTrailingZeros( uint64_t bits )
+    {
+#ifdef _MSC_VER
+        unsigned long idx = 0;
+        _BitScanForward64( &idx, bits );
+        return static_cast<size_t>(idx);
+#else
+        return static_cast<size_t>( __builtin_ctzll(bits) );
+#endif
+    }
+
+private:
+    size_t                m_nbbytes;
+    std::vector<uint64_t> m_words;
+};
+
+// ----------------------------------------------------------------------------------------
+/*
+    CoverageSink
+        Output sink that marks the bytes of each table, and of each string its rows point to,
+        in a CoverageMap of the binary starting at "pfbeg".
+*/
+class CoverageSink
+{
+public:
+    CoverageSink( CoverageMap & map, const uint8_t * pfbeg )
+        :m_map(map), m_pfbeg(reinterpret_cast<const char*>(pfbeg))
+    {}
+
+    template<class _EntryTy>
+        void BeginTable( const std::string &, uint32_t offset, size_t nbentries )
+    {
+        m_map.Mark( offset, offset + (nbentries * _EntryTy::Size) );
+    }
+
+    template<class _EntryTy>
+        void WriteRow( uint32_t, const _EntryTy &, std::optional<std::string_view> symbol )
+    {
+        //Symbols point straight into the binary
+        if( symbol )
+        {
+            const size_t stroffset = static_cast<size_t>( symbol->data() - m_pfbeg );
+            m_map.Mark( stroffset, stroffset + symbol->size() + 1 );
+        }
+    }
+
+    template<class _EntryTy>
+        void EndTable( typename _EntryTy::Stats & )
+    {}
+
+    void Finish()
+    {}
+
+private:
+    CoverageMap & m_map;
+    const char *  m_pfbeg;
+};
+
+// ----------------------------------------------------------------------------------------
+/*
+    CoverageSummary
+        The coverage of a set of binaries of the same kind, and how many of them have each gap.
+*/
+struct CoverageSummary
+{
+    size_t                                          nbfiles   = 0;
+    size_t                                          nbbytes   = 0;
+    size_t                                          nbcovered = 0;
+    std::map<std::pair<uint32_t,uint32_t>, size_t>  gaps;
+
+    void Add( const CoverageMap & map )
+    {
+        ++nbfiles;
+        nbbytes   += map.NbBytes();
+        nbcovered += map.NbCovered();
+        for( const ByteSpan & gap : map.Gaps() )
+            ++gaps[ std::make_pair( gap.beg, gap.end ) ];
+    }
+
+    void Merge( const CoverageSummary & other )
+    {
+        nbfiles   += other.nbfiles;
+        nbbytes   += other.nbbytes;
+        nbcovered += other.nbcovered;
+        for( const auto & gap : other.gaps )
+            gaps[gap.first] += gap.second;
+    }
+};
+
+namespace coverage
+{
+    inline double Percent( size_t nbcovered, size_t nbbytes )
+    {
+        return (nbbytes != 0)? (100.0 * static_cast<double>(nbcovered) / static_cast<double>(nbbytes)) : 0.0;
+    }
+
+    inline void AppendGap( TextBuffer & buf, uint32_t beg, uint32_t end )
+    {
+        buf << "0x";
+        buf.AppendHex( beg, 8 );
+        buf << "   0x";
+        buf.AppendHex( end, 8 );
+        buf << "   0x";
+        buf.AppendHex( end - beg, 8 );
+    }
+}
+
+/*
+    WriteCoverage
+        Writes the coverage of a binary, then each of its gaps.
+        Ex: "arm9: 12.34% covered, 88964 of 720896 byte(s), 57 gap(s)"
+*/
+inline void WriteCoverage( std::ostream & out, const std::string & name, const CoverageMap & map )
+{
+    const std::vector<ByteSpan> gaps      = map.Gaps();
+    const size_t                nbcovered = map.NbCovered();
+    out <<name <<": " <<std::fixed <<std::setprecision(2) <<coverage::Percent( nbcovered, map.NbBytes() ) <<"% covered, "
+        <<nbcovered <<" of " <<map.NbBytes() <<" byte(s), " <<gaps.size() <<" gap(s)\n"
+        <<"Offset       End          Size\n";
+    TextBuffer buf;
+    for( const ByteSpan & gap : gaps )
+    {
+        coverage::AppendGap( buf, gap.beg, gap.end );
+        buf << '\n';
+    }
+    buf.WriteTo(out);
+}
+
+/*
+    WriteCorpusCoverage
+        Writes the coverage of a corpus' binaries of a kind, then every gap with the number of
+        binaries that have it, the most shared first, then the largest first.
+*/
+inline void WriteCorpusCoverage( std::ostream & out, const std::string & name, const CoverageSummary & summary )
+{
+    typedef std::pair<std::pair<uint32_t,uint32_t>, size_t> gap_t;
+    std::vector<gap_t> gaps( summary.gaps.begin(), summary.gaps.end() );
+    std::stable_sort( gaps.begin(), gaps.end(), []( const gap_t & a, const gap_t & b )
+    {
+        if( a.second != b.second )
+            return a.second > b.second;
+        return (a.first.second - a.first.first) > (b.first.second - b.first.first);
+    });
+
+    out <<"=== " <<name <<": " <<summary.nbfiles <<" file(s), " <<std::fixed <<std::setprecision(2) <<coverage::Percent( summary.nbcovered, summary.nbbytes )
+        <<"% covered, " <<summary.nbcovered <<" of " <<summary.nbbytes <<" byte(s), " <<gaps.size() <<" distinct gap(s)\n"
+        <<"Offset       End          Size         Files\n";
+    TextBuffer buf;
+    for( const gap_t & gap : gaps )
+    {
+        coverage::AppendGap( buf, gap.first.first, gap.first.second );
+        buf << "   ";
+        buf.AppendDec( gap.second );
+        buf << '\n';
+    }
+    buf.WriteTo(out);
+}
+
+#endif
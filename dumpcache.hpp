@@ -0,0 +1,166 @@
+#ifndef DUMPCACHE_HPP
+#define DUMPCACHE_HPP
+/*
+dumpcache.hpp
+    Persistent cache of the rendered output of each table of a binary.
+
+    A cache file remembers the hash of the whole input file it was made from, and the rendered
+    text of each of its tables, keyed by a hash of everything that table's output depends on.
+    When the input file didn't change, the output is the cached tables in order. When it did,
+    only the tables whose key changed have to be decoded again.
+
+    File layout, little endian:
+        char[8]  magic      "PMD2CCH\0"
+        uint32   version
+        uint32   nbchunks
+        uint64   filehash
+        nbchunks times:
+            uint64  key
+            uint64  length
+            char[]  text
+*/
+#include <cstdint>
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+#include <filesystem>
+
+class DumpCache
+{
+public:
+    //Bump this whenever the rendered output changes, so old caches are ignored
+    static constexpr uint32_t Version  = 1;
+    static constexpr char     Magic[8] = { 'P','M','D','2','C','C','H','\0' };
+    static constexpr uint32_t MaxChunks = 1024;
+
+    struct Chunk
+    {
+        uint64_t    key = 0;
+        std::string text;
+    };
+
+    explicit DumpCache( uint64_t filehash = 0 )
+        :m_filehash(filehash)
+    {}
+
+    /*
+        Load
+            Replaces the content with the cache file's. Returns false and leaves the cache empty
+            if the file is missing, from another version, or damaged.
+    */
+    bool Load( const std::string & fpath )
+    {
+        m_chunks.clear();
+        m_filehash = 0;
+        std::ifstream in( fpath, std::ios::binary | std::ios::ate );
+        if( !in )
+            return false;
+        const uint64_t fsize = static_cast<uint64_t>( in.tellg() );
+        in.seekg(0);
+
+        char     magic[8] = {};
+        uint32_t version  = 0;
+        uint32_t nbchunks = 0;
+        uint64_t filehash = 0;
+        in.read( magic, sizeof(magic) );
+        if( !in || std::string( magic, sizeof(magic) ) != std::string( Magic, sizeof(Magic) ) || !ReadInt( in, version ) || version != Version ||
+            !ReadInt( in, nbchunks ) || !ReadInt( in, filehash ) || nbchunks > MaxChunks )
+            return false;
+
+        std::vector<Chunk> chunks( nbchunks );
+        for( Chunk & chunk : chunks )
+        {
+            uint64_t len = 0;
+            if( !ReadInt( in, chunk.key ) || !ReadInt( in, len ) || len > (fsize - static_cast<uint64_t>( in.tellg() )) )
+                return false;
+            chunk.text.resize( static_cast<size_t>(len) );
+            if( len != 0 && !in.read( &chunk.text[0], static_cast<std::streamsize>(len) ) )
+                return false;
+        }
+        m_chunks.swap(chunks);
+        m_filehash = filehash;
+        return true;
+    }
+
+    /*
+        Save
+            Writes the cache to a temporary file first, then replaces the old one, so an interrupted
+            run never leaves a truncated cache behind.
+    */
+    void Save( const std::string & fpath )const
+    {
+        namespace fs = std::filesystem;
+        const fs::path  dest(fpath);
+        const fs::path  tmp = dest.string() + ".tmp";
+        std::error_code ec;
+        if( dest.has_parent_path() )
+            fs::create_directories( dest.parent_path(), ec );
+        {
+            std::ofstream out( tmp, std::ios::binary | std::ios::trunc );
+            if( !out )
+                return;     //A cache that can't be written just means the next run won't be faster
+            out.write( Magic, sizeof(Magic) );
+            WriteInt( out, Version );
+            WriteInt( out, static_cast<uint32_t>( m_chunks.size() ) );
+            WriteInt( out, m_filehash );
+            for( const Chunk & chunk : m_chunks )
+            {
+                WriteInt( out, chunk.key );
+                WriteInt( out, static_cast<uint64_t>( chunk.text.size() ) );
+                out.write( chunk.text.data(), static_cast<std::streamsize>( chunk.text.size() ) );
+            }
+            if( !out )
+                return;
+        }
+        fs::rename( tmp, dest, ec );
+    }
+
+    //The cached text for a key, or null. There are only a handful of tables per file.
+    const std::string * Find( uint64_t key )const
+    {
+        for( const Chunk & chunk : m_chunks )
+        {
+            if( chunk.key == key )
+                return &chunk.text;
+        }
+        return nullptr;
+    }
+
+    void Add( uint64_t key, std::string text )
+    {
+        m_chunks.push_back( Chunk{ key, std::move(text) } );
+    }
+
+    inline uint64_t                   FileHash()const { return m_filehash; }
+    inline const std::vector<Chunk> & Chunks  ()const { return m_chunks; }
+    inline bool                       empty   ()const { return m_chunks.empty(); }
+
+private:
+    template<class T>
+        static bool ReadInt( std::istream & in, T & out )
+    {
+        uint8_t bytes[sizeof(T)];
+        if( !in.read( reinterpret_cast<char*>(bytes), sizeof(T) ) )
+            return false;
+        out = 0;
+        for( size_t i = 0; i < sizeof(T); ++i )
+            out |= static_cast<T>( static_cast<T>(bytes[i]) << (i * 8) );
+        return true;
+    }
+
+    template<class T>
+        static void WriteInt( std::ostream & out, T value )
+    {
+        uint8_t bytes[sizeof(T)];
+        for( size_t i = 0; i < sizeof(T); ++i )
+            bytes[i] = static_cast<uint8_t>( value >> (i * 8) );
+        out.write( reinterpret_cast<const char*>(bytes), sizeof(T) );
+    }
+
+    uint64_t           m_filehash;
+    std::vector<Chunk> m_chunks;
+};
+
+#endif
@@ -0,0 +1,2280 @@
+#ifndef EVENTTABLES_HPP
+#define EVENTTABLES_HPP
+/*
+eventtables.hpp
+    The table decoding core: the table entry layouts, their decoders and printers, the statistics,
+    and the output sinks. Shared by the command line tool and the benchmarks.
+*/
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+    #include <intrin.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+#include "lutscanner.hpp"
+#include "xxh64.hpp"
+#include "textbuffer.hpp"
+#include "dumpcache.hpp"
+#include "profiler.hpp"
+#include "threadpool.hpp"
+
+const uint32_t Overlay_0011LoadOffset = 0x022DC240;
+const uint32_t Arm9BinLoadOffset      = 0x02000000;
+
+template<typename _intty>
+    std::string NumberToHexString( _intty val )
+{
+    std::stringstream sstr; 
+    sstr <<std::hex <<"0x" <<std::uppercase <<val;
+    return std::move(sstr.str());
+}
+
+/*
+    Histogram
+        Counts how many times each value was seen.
+        Types of 16 bits or less use a flat array with one counter per possible value,
+        allocated on the first sample. Wider types use a hash map.
+*/
+template<class T, bool _bDense = (sizeof(T) <= 2)>
+    class Histogram;
+
+template<class T>
+    class Histogram<T, true>
+{
+public:
+    typedef T val_t;
+
+    inline void Add( val_t val )
+    {
+        if( m_counts.empty() )
+            m_counts.assign( NbValues, 0 );
+        const size_t idx = ToIndex(val);
+        ++m_counts[idx];
+        m_lo = std::min( m_lo, idx );
+        m_hi = std::max( m_hi, idx + 1 );
+    }
+
+    void Merge( const Histogram & other )
+    {
+        if( other.m_counts.empty() )
+            return;
+        if( m_counts.empty() )
+            m_counts.assign( NbValues, 0 );
+        for( size_t i = other.m_lo; i < other.m_hi; ++i )
+            m_counts[i] += other.m_counts[i];
+        m_lo = std::min( m_lo, other.m_lo );
+        m_hi = std::max( m_hi, other.m_hi );
+    }
+
+    //Calls "fun( value, count )" for every value seen at least once, from the smallest value to the largest
+    template<class _FunTy>
+        void ForEach( _FunTy && fun )const
+    {
+        for( size_t i = m_lo; i < m_hi; ++i )
+        {
+            if( m_counts[i] != 0 )
+                fun( FromIndex(i), m_counts[i] );
+        }
+    }
+
+private:
+    static const size_t NbValues = size_t(1) << (sizeof(val_t) * 8);
+
+    //Values are stored relative to the type's minimum, so the array is in ascending value order
+    static inline size_t ToIndex  ( val_t  val ) { return static_cast<size_t>( static_cast<int64_t>(val) - std::numeric_limits<val_t>::min() ); }
+    static inline val_t  FromIndex( size_t idx ) { return static_cast<val_t>( static_cast<int64_t>(idx) + std::numeric_limits<val_t>::min() ); }
+
+private:
+    std::vector<uint64_t> m_counts;
+    size_t                m_lo = NbValues;  //Range of the indices seen, so only that part is scanned
+    size_t                m_hi = 0;
+};
+
+template<class T>
+    class Histogram<T, false>
+{
+public:
+    typedef T val_t;
+
+    inline void Add( val_t val )
+    {
+        ++m_counts[val];
+    }
+
+    void Merge( const Histogram & other )
+    {
+        for( const auto & entry : other.m_counts )
+            m_counts[entry.first] += entry.second;
+    }
+
+    //Calls "fun( value, count )" for every value seen at least once, from the smallest value to the largest
+    template<class _FunTy>
+        void ForEach( _FunTy && fun )const
+    {
+        std::vector<std::pair<val_t,uint64_t>> sorted( m_counts.begin(), m_counts.end() );
+        std::sort( sorted.begin(), sorted.end() );
+        for( const auto & entry : sorted )
+            fun( entry.first, entry.second );
+    }
+
+private:
+    std::unordered_map<val_t,uint64_t> m_counts;
+};
+
+
+/*
+    A little tool to gather statistics on values
+*/
+template<class T>
+    struct LimitVal
+{
+    typedef T val_t;
+    val_t    min;
+    val_t    avg;
+    val_t    max;
+    uint64_t cntavg; //Counts nb of value samples
+    int64_t  accavg; //Accumulate values
+    Histogram<val_t> distribution; 
+
+    LimitVal()
+        :min(0), avg(0), max(0), cntavg(0), accavg(0)
+    {}
+
+    void Process(val_t anotherval )
+    {
+        if( cntavg == 0 || anotherval < min )
+            min = anotherval;
+        if( cntavg == 0 || anotherval > max )
+            max = anotherval;
+
+        ++cntavg;
+        accavg += anotherval;
+        avg = static_cast<val_t>(accavg / static_cast<int64_t>(cntavg));
+
+        distribution.Add(anotherval);
+    }
+
+    //Combine the samples of another LimitVal into this one
+    void Merge( const LimitVal & other )
+    {
+        if( other.cntavg == 0 )
+            return;
+
+        if( cntavg == 0 || other.min < min )
+            min = other.min;
+        if( cntavg == 0 || other.max > max )
+            max = other.max;
+
+        cntavg += other.cntavg;
+        accavg += other.accavg;
+        avg = static_cast<val_t>(accavg / static_cast<int64_t>(cntavg));
+
+        distribution.Merge(other.distribution);
+    }
+
+    void Print( TextBuffer & out )const
+    {
+        out <<"(";
+        out.AppendDec( static_cast<int64_t>( min ) );
+        out <<" to ";
+        out.AppendDec( static_cast<int64_t>( max ) );
+        out <<" ) Avg : ";
+        out.AppendDec( avg );
+        out <<"\n\tDistribution with more than one match:\n";
+        distribution.ForEach( [&out]( val_t value, uint64_t count )
+        {
+            if( count <= 1 )
+                return;
+            out <<"\t\tVal: ";
+            out.AppendDec( value, 8 );
+            out <<" : ";
+            out.AppendDec( count, 8 );
+            out <<" times\n";
+        });
+    }
+
+    std::string Print()const
+    {
+        TextBuffer buf;
+        Print(buf);
+        return buf.str();
+    }
+};
+
+
+/*********************************************************************************************
+    ReadIntFromBytes
+        Tool to read integer values from a byte vector!
+        ** The iterator's passed as input, has its position changed !!
+*********************************************************************************************/
+template<class T, class _init> 
+    inline T ReadIntFromBytes( _init & itin, _init itend, bool basLittleEndian = true )
+{
+    static_assert( std::numeric_limits<T>::is_integer, "ReadIntFromBytes() : Type T is not an integer!" );
+    T out_val = 0;
+
+    if( basLittleEndian )
+    {
+        unsigned int i = 0;
+        for( ; (itin != itend) && (i < sizeof(T)); ++i, ++itin )
+        {
+            T tmp = (*itin);
+            out_val |= ( tmp << (i * 8) ) & ( 0xFF << (i*8) );
+        }
+
+        if( i != sizeof(T) )
+        {
+#ifdef _DEBUG
+            assert(false);
+#endif
+            throw std::runtime_error( "ReadIntFromBytes(): Not enough bytes to read from the source container!" );
+        }
+    }
+    else
+    {
+        int i = (sizeof(T)-1);
+        for( ; (itin != itend) && (i >= 0); --i, ++itin )
+        {
+            T tmp = (*itin);
+            out_val |= ( tmp << (i * 8) ) & ( 0xFF << (i*8) );
+        }
+
+        if( i != -1 )
+        {
+#ifdef _DEBUG
+            assert(false);
+#endif
+            throw std::runtime_error( "ReadIntFromBytes(): Not enough bytes to read from the source container!" );
+        }
+    }
+    return out_val;
+}
+
+/*********************************************************************************************
+    ReadIntFromBytes
+        Tool to read integer values from a byte container!
+            
+        #NOTE :The iterator is passed by copy here !! And the incremented iterator is returned!
+*********************************************************************************************/
+template<class T, class _init> 
+    inline _init ReadIntFromBytes( T & dest, _init itin, _init itend, bool basLittleEndian = true ) 
+{
+    dest = ReadIntFromBytes<T, _init>( itin, itend, basLittleEndian );
+    return itin;
+}
+
+
+/************************************************************************************
+    safestrlen
+        Count the length of a string, and has a iterator check
+        to ensure it won't loop into infinity if it can't find a 0.
+************************************************************************************/
+template<typename init_t>
+    inline size_t safestrlen( init_t beg, init_t pastend )
+{
+    if constexpr( std::is_pointer<init_t>::value && sizeof(*beg) == 1 )
+    {
+        //Contiguous bytes can be searched with the C library's vectorized memchr
+        const void * pnul = std::memchr( beg, 0, static_cast<size_t>(pastend - beg) );
+        if( pnul == nullptr )
+            throw std::runtime_error("String went past expected end!");
+        return static_cast<size_t>( static_cast<const uint8_t*>(pnul) - reinterpret_cast<const uint8_t*>(beg) );
+    }
+    else
+    {
+        size_t cntchar = 0;
+        for(; beg != pastend && (*beg) != 0; ++cntchar, ++beg );
+
+        if( beg == pastend )
+            throw std::runtime_error("String went past expected end!");
+
+        return cntchar;
+    }
+}
+
+/************************************************************************************
+    FetchString
+        Fetchs a null terminated C-String from a file offset.
+        The returned string_view points directly into the source bytes, so the
+        source must be contiguous and outlive the result!
+************************************************************************************/
+template<typename _init>
+    std::string_view FetchString( uint32_t fileoffset, _init itfbeg, _init itfend )
+{
+    if( static_cast<size_t>(std::distance(itfbeg, itfend)) <= fileoffset )
+        throw std::runtime_error("FetchString(): String offset " + NumberToHexString(fileoffset) + " is past the end of the file!");
+
+    auto    itstr     = itfbeg;
+    std::advance( itstr,  fileoffset );
+    size_t  strlength = safestrlen(itstr, itfend);
+    return std::string_view( reinterpret_cast<const char*>( &(*itstr) ), strlength );
+}
+
+/************************************************************************************
+    StringIndex
+        Constant time lookup of the null terminated strings in a region of a file.
+        The region is scanned once, and the position of each terminator in it is kept
+        in a bitmap. The length of a string is then the distance to the next set bit,
+        so rows pointing at the same string get the same string_view without measuring
+        it again. Offsets outside of the region go through FetchString().
+************************************************************************************/
+class StringIndex
+{
+public:
+    //Past this many bytes, a region costs more to index than to measure each string in it
+    static const uint32_t MaxRegionLen = 256 * 1024;
+
+    StringIndex( const uint8_t * pfbeg = nullptr, const uint8_t * pfend = nullptr )
+        :m_pfbeg(pfbeg), m_pfend(pfend), m_regionbeg(0), m_regionlen(0)
+    {}
+
+    //Indexes the strings from "regionbeg" up to the terminator of the string at "regionlast"
+    StringIndex( const uint8_t * pfbeg, const uint8_t * pfend, uint32_t regionbeg, uint32_t regionlast )
+        :m_pfbeg(pfbeg), m_pfend(pfend), m_regionbeg(regionbeg), m_regionlen(0)
+    {
+        const size_t fsize = static_cast<size_t>(pfend - pfbeg);
+        if( regionbeg > regionlast || regionlast >= fsize || (regionlast - regionbeg) > MaxRegionLen )
+            return;
+
+        //The last string may run past "regionlast", so the region ends at its terminator
+        const uint8_t * plast = pfbeg + regionlast;
+        const uint8_t * pnul  = static_cast<const uint8_t*>( std::memchr( plast, 0, static_cast<size_t>(pfend - plast) ) );
+        if( pnul == nullptr )
+            return; //Unterminated, FetchString() reports it
+
+        m_regionlen = static_cast<size_t>(pnul - (pfbeg + regionbeg)) + 1;
+        m_nulbits.resize( (m_regionlen + 63) / 64, 0 );
+
+        //8 bytes at a time, each bitmap word is filled from 8 loads
+        const uint8_t * pregion = pfbeg + regionbeg;
+        const size_t    nbfull  = m_regionlen / 64;
+        for( size_t w = 0; w < nbfull; ++w )
+        {
+            const uint8_t * pchunk = pregion + (w * 64);
+            uint64_t        bits   = 0;
+            for( unsigned i = 0; i < 8; ++i )
+                bits |= ZeroBytesMask( pchunk + (i * 8) ) << (i * 8);
+            m_nulbits[w] = bits;
+        }
+        for( size_t i = nbfull * 64; i < m_regionlen; ++i )
+            m_nulbits[i / 64] |= static_cast<uint64_t>( pregion[i] == 0 ) << (i % 64);
+    }
+
+    inline std::string_view Fetch( uint32_t fileoffset )const
+    {
+        const size_t relofs = static_cast<size_t>(fileoffset) - m_regionbeg;
+        if( fileoffset < m_regionbeg || relofs >= m_regionlen )
+            return FetchString( fileoffset, m_pfbeg, m_pfend );
+
+        //The region ends on a terminator, so this always stops within the bitmap
+        size_t   widx = relofs / 64;
+        uint64_t bits = m_nulbits[widx] & ( ~uint64_t(0) << (relofs % 64) );
+        while( bits == 0 )
+            bits = m_nulbits[++widx];
+        const size_t strlength = (widx * 64) + CountTrailingZeros(bits) - relofs;
+        return std::string_view( reinterpret_cast<const char*>( m_pfbeg + fileoffset ), strlength );
+    }
+
+    inline size_t RegionLen()const { return m_regionlen; }
+
+private:
+    //One bit for each of the 8 bytes at "pbytes" that's 0, the first byte in the lowest bit
+    static inline uint64_t ZeroBytesMask( const uint8_t * pbytes )
+    {
+        uint64_t word;
+        std::memcpy( &word, pbytes, sizeof(word) );
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+        const uint64_t low7   = 0x7F7F7F7F7F7F7F7FULL;
+        const uint64_t nonzero = ( ((word & low7) + low7) | word ) & ~low7;    //High bit of each non-zero byte
+        const uint64_t zero    = ( ~nonzero & ~low7 ) >> 7;                       //Low bit of each zero byte
+        return (zero * 0x0102040810204080ULL) >> 56;                              //Gathers the 8 bits in the top byte
+    }
+
+    static inline unsigned CountTrailingZeros( uint64_t bits )
+    {
+#ifdef _MSC_VER
+        unsigned long idx = 0;
+        _BitScanForward64( &idx, bits );
+        return static_cast<unsigned>(idx);
+#else
+        return static_cast<unsigned>( __builtin_ctzll(bits) );
+#endif
+    }
+
+private:
+    const uint8_t *       m_pfbeg;
+    const uint8_t *       m_pfend;
+    uint32_t              m_regionbeg;
+    size_t                m_regionlen;
+    std::vector<uint64_t> m_nulbits;
+};
+
+
+/************************************************************************************
+    MappedFile
+        Memory mapping of a whole file, read-only by default.
+        The parsing code works straight on the mapped pages through
+        begin()/end(), instead of on a copy of the file.
+        A writable mapping writes through to the file, and only the pages
+        that were written to are written back.
+************************************************************************************/
+class MappedFile
+{
+public:
+    MappedFile() = default;
+
+    explicit MappedFile( const std::string & fpath, bool bwritable = false )
+        :m_bwritable(bwritable)
+    {
+#ifdef _WIN32
+        m_hfile = CreateFileA( fpath.c_str(), bwritable? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                               bwritable? FILE_ATTRIBUTE_NORMAL : FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+        if( m_hfile == INVALID_HANDLE_VALUE )
+            throw std::runtime_error("Couldn't open file " + fpath);
+
+        LARGE_INTEGER fsize;
+        if( !GetFileSizeEx( m_hfile, &fsize ) )
+        {
+            Close();
+            throw std::runtime_error("Couldn't get the size of file " + fpath);
+        }
+        m_size = static_cast<size_t>(fsize.QuadPart);
+        if( m_size == 0 )
+            return; //Can't map empty files
+
+        m_hmap = CreateFileMappingA( m_hfile, nullptr, bwritable? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr );
+        if( m_hmap != nullptr )
+            m_pdata = static_cast<uint8_t*>( MapViewOfFile( m_hmap, bwritable? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0 ) );
+#else
+        int fd = open( fpath.c_str(), bwritable? O_RDWR : O_RDONLY );
+        if( fd == -1 )
+            throw std::runtime_error("Couldn't open file " + fpath);
+
+        struct stat fstats;
+        if( fstat( fd, &fstats ) != 0 )
+        {
+            close(fd);
+            throw std::runtime_error("Couldn't get the size of file " + fpath);
+        }
+        m_size = static_cast<size_t>(fstats.st_size);
+        if( m_size == 0 )
+        {
+            close(fd);
+            return; //Can't map empty files
+        }
+
+        void * pmap = mmap( nullptr, m_size, bwritable? (PROT_READ | PROT_WRITE) : PROT_READ, bwritable? MAP_SHARED : MAP_PRIVATE, fd, 0 );
+        close(fd); //The mapping keeps its own reference to the file
+        if( pmap != MAP_FAILED )
+            m_pdata = static_cast<uint8_t*>(pmap);
+#endif
+        if( m_pdata == nullptr )
+        {
+            Close();
+            throw std::runtime_error("Couldn't map file " + fpath);
+        }
+    }
+
+    MappedFile( MappedFile && other )noexcept
+    {
+        *this = std::move(other);
+    }
+
+    MappedFile & operator=( MappedFile && other )noexcept
+    {
+        if( this != &other )
+        {
+            Close();
+            std::swap( m_pdata,     other.m_pdata );
+            std::swap( m_size,      other.m_size );
+            std::swap( m_bwritable, other.m_bwritable );
+#ifdef _WIN32
+            std::swap( m_hfile, other.m_hfile );
+            std::swap( m_hmap,  other.m_hmap );
+#endif
+        }
+        return *this;
+    }
+
+    MappedFile( const MappedFile & )             = delete;
+    MappedFile & operator=( const MappedFile & ) = delete;
+
+    ~MappedFile()
+    {
+        Close();
+    }
+
+    inline const uint8_t * data ()const { return m_pdata; }
+    inline const uint8_t * begin()const { return m_pdata; }
+    inline const uint8_t * end  ()const { return m_pdata + m_size; }
+    inline size_t          size ()const { return m_size; }
+    inline bool            empty()const { return m_size == 0; }
+    inline bool            IsWritable()const { return m_bwritable; }
+
+    //Start of the data, for writing. Throws if the file wasn't mapped writable.
+    uint8_t * WritableData()
+    {
+        if( !m_bwritable )
+            throw std::runtime_error("MappedFile::WritableData(): The file was mapped read-only!");
+        return m_pdata;
+    }
+
+    //Waits until everything written to the mapping is on disk
+    void Flush()
+    {
+        if( !m_bwritable || m_pdata == nullptr )
+            return;
+#ifdef _WIN32
+        if( !FlushViewOfFile( m_pdata, 0 ) || !FlushFileBuffers( m_hfile ) )
+#else
+        if( msync( m_pdata, m_size, MS_SYNC ) != 0 )
+#endif
+            throw std::runtime_error("MappedFile::Flush(): Couldn't write the changes back to the file!");
+    }
+
+    /*
+        Prefetch
+            Reads the pages of a range of the file into memory on the calling thread, so whoever
+            parses them next doesn't wait on the disk. The whole range is hinted to the kernel
+            first, so the reads are issued together instead of one page fault at a time.
+    */
+    void Prefetch( const uint8_t * pbeg, const uint8_t * pend )const
+    {
+        pbeg = std::max( pbeg, begin() );
+        pend = std::min( pend, end() );
+        if( pbeg >= pend )
+            return;
+        size_t pagesize = 4096;
+#ifndef _WIN32
+        pagesize = static_cast<size_t>( sysconf(_SC_PAGESIZE) );
+        const uintptr_t pagebeg = reinterpret_cast<uintptr_t>(pbeg) & ~static_cast<uintptr_t>(pagesize - 1);
+        posix_madvise( reinterpret_cast<void*>(pagebeg), static_cast<size_t>( reinterpret_cast<uintptr_t>(pend) - pagebeg ), POSIX_MADV_WILLNEED );
+#endif
+        uint8_t touched = 0;
+        for( const uint8_t * p = pbeg; p < pend; p += pagesize )
+            touched ^= *reinterpret_cast<const volatile uint8_t*>(p);
+        touched ^= *reinterpret_cast<const volatile uint8_t*>(pend - 1);
+        (void)touched;
+    }
+
+    inline void Prefetch()const { Prefetch( begin(), end() ); }
+
+private:
+    void Close()
+    {
+#ifdef _WIN32
+        if( m_pdata != nullptr )
+            UnmapViewOfFile( m_pdata );
+        if( m_hmap != nullptr )
+            CloseHandle( m_hmap );
+        if( m_hfile != INVALID_HANDLE_VALUE )
+            CloseHandle( m_hfile );
+        m_hmap  = nullptr;
+        m_hfile = INVALID_HANDLE_VALUE;
+#else
+        if( m_pdata != nullptr )
+            munmap( m_pdata, m_size );
+#endif
+        m_pdata = nullptr;
+        m_size  = 0;
+    }
+
+private:
+    uint8_t *       m_pdata     = nullptr;
+    size_t          m_size      = 0;
+    bool            m_bwritable = false;
+#ifdef _WIN32
+    HANDLE          m_hfile = INVALID_HANDLE_VALUE;
+    HANDLE          m_hmap  = nullptr;
+#endif
+};
+
+
+/************************************************************************************
+    LoadFile
+        Map a file into memory for easier parsing.
+************************************************************************************/
+inline MappedFile LoadFile( const std::string & fpath )
+{
+    PMD2_PROF_TIME(LoadFile);
+    MappedFile fdat(fpath);
+    PMD2_PROF_COUNT( BytesRead, fdat.end() - fdat.begin() );
+    return fdat;
+}
+
+//============================================================================================================
+//  Entry Field Descriptors
+//============================================================================================================
+/*
+    LoadIntLE
+        Reads a little endian integer at a fixed position in a byte buffer, without bounds checks.
+        The shifts are merged into a single unaligned load by the compiler on little endian hosts.
+*/
+template<class T>
+    inline T LoadIntLE( const uint8_t * psrc )
+{
+    static_assert( std::numeric_limits<T>::is_integer, "LoadIntLE() : Type T is not an integer!" );
+    typedef typename std::make_unsigned<T>::type uint_t;
+    uint_t out_val = 0;
+    for( size_t i = 0; i < sizeof(T); ++i )
+        out_val |= static_cast<uint_t>( static_cast<uint_t>(psrc[i]) << (i * 8) );
+    return static_cast<T>(out_val);
+}
+
+/*
+    StoreIntLE
+        Writes a little endian integer at a fixed position in a byte buffer, without bounds checks.
+        The inverse of LoadIntLE.
+*/
+template<class T>
+    inline void StoreIntLE( uint8_t * pdest, T value )
+{
+    static_assert( std::numeric_limits<T>::is_integer, "StoreIntLE() : Type T is not an integer!" );
+    typedef typename std::make_unsigned<T>::type uint_t;
+    const uint_t in_val = static_cast<uint_t>(value);
+    for( size_t i = 0; i < sizeof(T); ++i )
+        pdest[i] = static_cast<uint8_t>( in_val >> (i * 8) );
+}
+
+/*
+    eFieldFmt
+        How a field is printed in the text dump.
+*/
+enum struct eFieldFmt
+{
+    Dec,        //Right aligned decimal, padded with spaces
+    Hex,        //"0x" followed by upper case hex, padded with zeros
+    Symbol,     //Pointer to the entry's symbol string. Printed last.
+};
+
+/*
+    FieldDesc
+        Describes a single field of a table entry: which member it's stored into, how it's
+        labeled in the column header and the stats, and how it's printed.
+        Fields are listed in the order they're stored in the record, and have no padding between them.
+*/
+template<class _EntryTy, typename _FieldTy>
+    struct FieldDesc
+{
+    typedef _FieldTy field_t;
+    _FieldTy _EntryTy::* member;
+    const char *         name;      //Short name, used in machine readable outputs
+    const char *         header;    //Column header, with trailing spaces
+    const char *         statlabel; //Label in the stats section
+    int                  width;     //Printed width, not counting any "0x" prefix
+    eFieldFmt            format;
+};
+
+template<class _EntryTy, typename _FieldTy>
+    constexpr FieldDesc<_EntryTy,_FieldTy> MakeField( _FieldTy _EntryTy::* member, const char * name, const char * header, const char * statlabel, int width, eFieldFmt format = eFieldFmt::Dec )
+{
+    return FieldDesc<_EntryTy,_FieldTy>{ member, name, header, statlabel, width, format };
+}
+
+template<class _EntryTy>
+    constexpr FieldDesc<_EntryTy,uint32_t> MakeSymbolField( uint32_t _EntryTy::* member )
+{
+    return FieldDesc<_EntryTy,uint32_t>{ member, "symbol", "Symbol ", nullptr, 0, eFieldFmt::Symbol };
+}
+
+/*
+    ForEachField
+        Calls "fun( fielddesc, offsetinrecord )" for every field of the entry, in record order.
+*/
+template<class _EntryTy, class _FunTy>
+    constexpr void ForEachField( _FunTy && fun )
+{
+    std::apply( [&fun]( const auto & ... fields )
+    {
+        size_t offset = 0;
+        ( ( fun( fields, offset ), offset += sizeof(typename std::decay_t<decltype(fields)>::field_t) ), ... );
+    }, _EntryTy::Fields() );
+}
+
+/*
+    TableEntry
+        Base for all table entries. Generates the decoder, the text printer, the column header
+        and the statistics from the entry's field list.
+        The entry must define "Size", the size of a record in bytes, and a constexpr static
+        "Fields()" method returning a tuple of FieldDesc, including exactly one symbol field.
+*/
+template<class _EntryTy>
+    struct TableEntry
+{
+    //Sum of the size of all fields
+    static constexpr size_t LayoutSize()
+    {
+        size_t total = 0;
+        ForEachField<_EntryTy>( [&total]( const auto & field, size_t ){ total += sizeof(typename std::decay_t<decltype(field)>::field_t); } );
+        return total;
+    }
+
+    //Offset of the symbol pointer within the record
+    static constexpr size_t PtrOffset()
+    {
+        size_t ptroff = 0;
+        ForEachField<_EntryTy>( [&ptroff]( const auto & field, size_t offset ){ if( field.format == eFieldFmt::Symbol ) ptroff = offset; } );
+        return ptroff;
+    }
+
+    //The symbol pointer's value
+    uint32_t SymbolPtr()const
+    {
+        uint32_t ptr = 0;
+        ForEachField<_EntryTy>( [this,&ptr]( const auto & field, size_t ){ if( field.format == eFieldFmt::Symbol ) ptr = static_cast<uint32_t>( Self().*(field.member) ); } );
+        return ptr;
+    }
+
+    /*
+        Read
+            Decodes a whole record. The bounds are checked once, then each field is loaded from its fixed offset.
+            The source must be contiguous.
+    */
+    template<typename _init>
+        _init Read( _init itbeg, _init itend )
+    {
+        static_assert( LayoutSize() == _EntryTy::Size, "TableEntry::Read(): The fields don't add up to the entry's size!" );
+        if( static_cast<size_t>(std::distance(itbeg, itend)) < _EntryTy::Size )
+            throw std::runtime_error( "TableEntry::Read(): Not enough bytes to read an entry from the source container!" );
+
+        const uint8_t * precord = reinterpret_cast<const uint8_t*>( &(*itbeg) );
+        ForEachField<_EntryTy>( [this,precord]( const auto & field, size_t offset )
+        {
+            typedef typename std::decay_t<decltype(field)>::field_t field_t;
+            Self().*(field.member) = LoadIntLE<field_t>( precord + offset );
+        });
+        std::advance( itbeg, _EntryTy::Size );
+        return itbeg;
+    }
+
+    /*
+        Write
+            Encodes the whole record into "precord", which must hold at least "Size" bytes.
+            The inverse of Read.
+    */
+    void Write( uint8_t * precord )const
+    {
+        ForEachField<_EntryTy>( [this,precord]( const auto & field, size_t offset )
+        {
+            typedef typename std::decay_t<decltype(field)>::field_t field_t;
+            StoreIntLE<field_t>( precord + offset, Self().*(field.member) );
+        });
+    }
+
+    /*
+        SetField
+            Sets a field by the name it has in the CSV and JSON outputs. The symbol pointer is "symbol_ptr".
+            Any value from the signed minimum to the unsigned maximum of the field's size is accepted,
+            so values copied from a hex editor can be used on signed fields as-is.
+            Returns false if there's no such field, and throws if the value doesn't fit.
+    */
+    bool SetField( std::string_view name, int64_t value )
+    {
+        bool bfound = false;
+        ForEachField<_EntryTy>( [&]( const auto & field, size_t )
+        {
+            typedef typename std::decay_t<decltype(field)>::field_t field_t;
+            typedef std::make_unsigned_t<field_t>                   ufield_t;
+            typedef std::make_signed_t<field_t>                     sfield_t;
+            const bool bmatch = (field.format == eFieldFmt::Symbol)? (name == "symbol_ptr") : (name == field.name);
+            if( bfound || !bmatch )
+                return;
+            if( value < static_cast<int64_t>( std::numeric_limits<sfield_t>::min() ) || value > static_cast<int64_t>( std::numeric_limits<ufield_t>::max() ) )
+                throw std::runtime_error("TableEntry::SetField(): The value " + std::to_string(value) + " doesn't fit in the " + std::to_string(sizeof(field_t) * 8) + " bits field \"" + std::string(name) + "\"!");
+            Self().*(field.member) = static_cast<field_t>( static_cast<ufield_t>(value) );
+            bfound = true;
+        });
+        return bfound;
+    }
+
+    template<typename _outstrm, typename _init >
+        void Print( _outstrm & out, _init itfbeg, _init itfend, const uint32_t ptrDiff  )const
+    {
+        std::string_view fetchedstr = "NULL";
+        const uint32_t   ptrstring  = SymbolPtr();
+        if( ptrstring != 0 )
+            fetchedstr = FetchString( ptrstring - ptrDiff, itfbeg, itfend );
+        PrintFields( out, fetchedstr );
+    }
+
+    //Prints the entry's fields, followed by the symbol string that was fetched for it
+    void PrintFields( TextBuffer & out, std::string_view symbol )const
+    {
+        const char * separator = "-> ";
+        ForEachField<_EntryTy>( [&]( const auto & field, size_t )
+        {
+            typedef typename std::decay_t<decltype(field)>::field_t field_t;
+            const field_t value = Self().*(field.member);
+            if( field.format == eFieldFmt::Dec )
+            {
+                out << separator;
+                out.AppendDec( value, field.width );
+            }
+            else if( field.format == eFieldFmt::Hex )
+            {
+                out << separator <<"0x";
+                out.AppendHex( static_cast<std::make_unsigned_t<field_t>>(value), field.width );
+            }
+            else
+                return;
+            separator = ", ";
+        });
+        out << ", \"" <<symbol <<"\"\n";
+    }
+
+    template<typename _outstrm>
+        void PrintFields( _outstrm & out, std::string_view symbol )const
+    {
+        TextBuffer buf;
+        PrintFields( buf, symbol );
+        out << buf.View();
+    }
+
+    template<typename _outstrm>
+        static void PrintHeader( _outstrm & out )
+    {
+        //The symbol column is always last
+        ForEachField<_EntryTy>( [&out]( const auto & field, size_t ){ if( field.format != eFieldFmt::Symbol ) out << field.header; } );
+        ForEachField<_EntryTy>( [&out]( const auto & field, size_t ){ if( field.format == eFieldFmt::Symbol ) out << field.header; } );
+    }
+
+    // ----------------------------------
+    struct Stats
+    {
+        void LogStats( const _EntryTy & entry )
+        {
+            ForEachStat( [&entry]( const auto & field, auto & stat ){ stat.Process( entry.*(field.member) ); } );
+        }
+
+        void Print( TextBuffer & out )
+        {
+            ForEachStat( [&out]( const auto & field, auto & stat )
+            {
+                out << field.statlabel;
+                stat.Print(out);
+                out << "\n";
+            });
+        }
+
+        std::string Print()
+        {
+            TextBuffer buf;
+            Print(buf);
+            return buf.str();
+        }
+
+        //Combine the stats gathered from another table into this one
+        void Merge( const Stats & other )
+        {
+            MergeImpl( other, std::make_index_sequence<std::tuple_size_v<stats_t>>() );
+        }
+
+    private:
+        template<class _Tuple> struct StatsTuple;
+        template<class ... _Fields> struct StatsTuple<std::tuple<_Fields...>> { typedef std::tuple<LimitVal<typename _Fields::field_t>...> type; };
+        typedef typename StatsTuple<decltype(_EntryTy::Fields())>::type stats_t;
+
+        //Calls "fun( fielddesc, limitval )" for each field that has stats
+        template<class _FunTy>
+            void ForEachStat( _FunTy && fun )
+        {
+            ForEachStatImpl( fun, std::make_index_sequence<std::tuple_size_v<stats_t>>() );
+        }
+
+        template<class _FunTy, size_t ... _Idx>
+            void ForEachStatImpl( _FunTy & fun, std::index_sequence<_Idx...> )
+        {
+            constexpr auto fields = _EntryTy::Fields();
+            ( ( (std::get<_Idx>(fields).statlabel != nullptr)? fun( std::get<_Idx>(fields), std::get<_Idx>(m_stats) ) : void() ), ... );
+        }
+
+        template<size_t ... _Idx>
+            void MergeImpl( const Stats & other, std::index_sequence<_Idx...> )
+        {
+            ( std::get<_Idx>(m_stats).Merge( std::get<_Idx>(other.m_stats) ), ... );
+        }
+
+        stats_t m_stats;
+    };
+
+private:
+    inline const _EntryTy & Self()const { return *static_cast<const _EntryTy*>(this); }
+    inline _EntryTy       & Self()      { return *static_cast<_EntryTy*>(this); }
+};
+
+//============================================================================================================
+//  Output Sinks
+//============================================================================================================
+/*
+    The table walk in ParseAndDumpLUT hands every decoded table to an output sink.
+    A sink implements:
+        template<class E> void BeginTable( const string & headertext, uint32_t offset, size_t nbentries );
+        template<class E> void WriteRow  ( uint32_t rowoffset, const E & entry, std::optional<std::string_view> symbol );
+        template<class E> void EndTable  ( typename E::Stats & stats );
+        void Finish();      //Called once every table was written
+
+    Sinks that can render tables independently of each other also implement:
+        typedef ... fork_t;                     //A sink for a single table
+        std::unique_ptr<fork_t> Fork();         //Called on the thread that owns the sink
+        void Join( fork_t & fork );             //Appends the fork's output, in the order Join is called
+    which lets OrderedTableWriter render the tables of a file in parallel.
+*/
+
+enum struct eOutFmt
+{
+    Text,       //Human readable layout
+    Csv,        //One CSV file per table
+    JsonLines,  //One JSON object per row
+    Binary,     //Columnar binary file with a string pool
+};
+
+/*
+    ParseOutFmt
+        Turns the name of an output format into its value.
+*/
+inline eOutFmt ParseOutFmt( const std::string & fmtname )
+{
+    if( fmtname == "text" )  return eOutFmt::Text;
+    if( fmtname == "csv" )   return eOutFmt::Csv;
+    if( fmtname == "jsonl" ) return eOutFmt::JsonLines;
+    if( fmtname == "bin" )   return eOutFmt::Binary;
+    throw std::runtime_error("Unknown output format \"" + fmtname + "\"! Expected text, csv, jsonl or bin.");
+}
+
+/*
+    MakeTableId
+        Turns a table's header text into a short identifier usable in file names and keys.
+        Ex: "Event List Table" -> "event_list_table"
+*/
+inline std::string MakeTableId( const std::string & headertext )
+{
+    std::string tblid;
+    for( char c : headertext )
+        tblid.push_back( (c == ' ')? '_' : static_cast<char>( tolower( static_cast<unsigned char>(c) ) ) );
+    return tblid;
+}
+
+// ----------------------------------------------------------------------------------------
+/*
+    OutputFiles
+        Where sinks create their output files. By default files are written to disk as they're
+        written to. Deferred, they're kept in memory instead, for a background writer to write out
+        with TakeDeferred(), so the thread doing the dump never waits on the disk.
+        Opening and closing files is thread safe, so forked sinks can share the same OutputFiles.
+*/
+class OutputFiles
+{
+public:
+    struct DeferredFile
+    {
+        std::string path;
+        std::string data;
+        bool        bbinary = false;
+    };
+
+    explicit OutputFiles( bool bdeferred = false )
+        :m_bdeferred(bdeferred)
+    {}
+
+    //A stream writing to "fpath". It stays valid until it's closed.
+    std::ostream & Open( const std::string & fpath, bool bbinary = false )
+    {
+        File file;
+        file.path    = fpath;
+        file.bbinary = bbinary;
+        if( m_bdeferred )
+            file.pstream = std::make_unique<std::ostringstream>();
+        else
+        {
+            auto pfile = std::make_unique<std::ofstream>( fpath, bbinary? (std::ios::out | std::ios::binary) : std::ios::out );
+            if( !pfile->is_open() )
+                throw std::runtime_error("OutputFiles::Open(): Couldn't open " + fpath + " for writing!");
+            file.pstream = std::move(pfile);
+        }
+        std::lock_guard<std::mutex> lk(m_mtx);
+        m_files.push_back( std::move(file) );
+        return *m_files.back().pstream;
+    }
+
+    //Done writing to a stream. Files on disk are flushed and closed, and throw if anything failed.
+    void Close( std::ostream & out )
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        for( auto it = m_files.begin(); it != m_files.end(); ++it )
+        {
+            if( it->pstream.get() != &out )
+                continue;
+            out.flush();
+            if( out.fail() )
+                throw std::runtime_error("OutputFiles::Close(): Couldn't write " + it->path + "!");
+            if( m_bdeferred )
+            {
+                it->bclosed = true;
+                return;
+            }
+            m_files.erase(it);
+            return;
+        }
+    }
+
+    //Hands over the content of every closed deferred file, in the order they were opened
+    std::vector<DeferredFile> TakeDeferred()
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        std::vector<DeferredFile> files;
+        for( auto it = m_files.begin(); it != m_files.end(); )
+        {
+            if( !it->bclosed )
+            {
+                ++it;
+                continue;
+            }
+            files.push_back( DeferredFile{ it->path, static_cast<std::ostringstream&>(*it->pstream).str(), it->bbinary } );
+            it = m_files.erase(it);
+        }
+        return files;
+    }
+
+    inline bool IsDeferred()const { return m_bdeferred; }
+
+private:
+    struct File
+    {
+        std::string                   path;
+        std::unique_ptr<std::ostream> pstream;
+        bool                          bbinary = false;
+        bool                          bclosed = false;
+    };
+
+    bool                 m_bdeferred;
+    std::mutex           m_mtx;
+    std::list<File>      m_files;
+};
+
+// ----------------------------------------------------------------------------------------
+/*
+    BufferedSink
+        Fork of a stream sink: renders into a buffer of its own, for the parent to write out later.
+        Sinks that format into a TextBuffer fork into a buffered sink of their own type instead.
+*/
+template<class _SinkTy>
+    class BufferedSink
+{
+public:
+    BufferedSink()
+        :m_sink(m_buf)
+    {}
+
+    template<class _EntryTy>
+        void BeginTable( const std::string & headertext, uint32_t offset, size_t nbentries )
+    {
+        m_sink.template BeginTable<_EntryTy>( headertext, offset, nbentries );
+    }
+
+    template<class _EntryTy>
+        void WriteRow( uint32_t rowoffset, const _EntryTy & entry, std::optional<std::string_view> symbol )
+    {
+        m_sink.WriteRow( rowoffset, entry, symbol );
+    }
+
+    template<class _EntryTy>
+        void EndTable( typename _EntryTy::Stats & stats )
+    {
+        m_sink.template EndTable<_EntryTy>(stats);
+    }
+
+    //Writes what was rendered to the stream, without copying it into a string first
+    void WriteTo( std::ostream & out )
+    {
+        if( m_buf.tellp() > 0 )
+            out << m_buf.rdbuf();
+    }
+
+private:
+    std::stringstream m_buf;
+    _SinkTy           m_sink;
+};
+
+// ----------------------------------------------------------------------------------------
+/*
+    TextSink
+        Writes the human readable text layout.
+        A TextSink made without a stream only renders into its buffer, for its owner to take the text
+        from with Buffer(). That's what forks are, and what the sinks that keep the text of each table use.
+*/
+class TextSink
+{
+public:
+    //Rows are formatted into a buffer, written out at the end of each table, or once it's this large
+    static const size_t WriteThreshold = 256 * 1024;
+
+    explicit TextSink( std::ostream & out )
+        :m_pout(&out)
+    {}
+
+    TextSink()
+        :m_pout(nullptr)
+    {}
+
+    template<class _EntryTy>
+        void BeginTable( const std::string & headertext, uint32_t, size_t )
+    {
+        m_buf << "============================================================\n"
+              << headertext <<"\n"
+              << "============================================================\n"
+              << "\n"
+              << "Offset       ";
+        _EntryTy::PrintHeader(m_buf);
+        m_buf << "\n--------------------------------------------------------------------------------------\n";
+    }
+
+    template<class _EntryTy>
+        void WriteRow( uint32_t rowoffset, const _EntryTy & entry, std::optional<std::string_view> symbol )
+    {
+        m_buf << "0x";
+        m_buf.AppendHex( rowoffset, 8 );
+        m_buf << " ";
+        entry.PrintFields( m_buf, symbol.value_or("NULL") );
+        if( m_pout != nullptr && m_buf.size() >= WriteThreshold )
+            m_buf.WriteTo(*m_pout);
+    }
+
+    template<class _EntryTy>
+        void EndTable( typename _EntryTy::Stats & stats )
+    {
+        m_buf <<"\n"
+              <<"Stats:\n"
+              <<"------------\n";
+        stats.Print(m_buf);
+        m_buf <<"\n";
+        if( m_pout != nullptr )
+            m_buf.WriteTo(*m_pout);
+    }
+
+    void Finish()
+    {
+        if( m_pout == nullptr )
+            return;
+        m_buf.WriteTo(*m_pout);
+        m_pout->flush();
+    }
+
+    //Text rendered and not written out yet
+    inline TextBuffer & Buffer() { return m_buf; }
+
+    //Forks render into their own buffer, which is written out as-is when joined
+    typedef TextSink fork_t;
+    std::unique_ptr<fork_t> Fork()const { return std::make_unique<TextSink>(); }
+    void                    Join( fork_t & fork )
+    {
+        if( m_pout == nullptr )
+        {
+            m_buf << fork.m_buf.View();
+            fork.m_buf.clear();
+            return;
+        }
+        m_buf.WriteTo(*m_pout);
+        fork.m_buf.WriteTo(*m_pout);
+    }
+
+private:
+    std::ostream * m_pout;
+    TextBuffer     m_buf;
+};
+
+// ----------------------------------------------------------------------------------------
+/*
+    CsvSink
+        Writes each table to its own CSV file, named "<basename>.<tableid>.csv".
+        Columns are the row's offset, every field in record order, then the symbol.
+        Null symbols are left empty.
+*/
+class CsvSink
+{
+public:
+    CsvSink( const std::string & targetdir, const std::string & basename, OutputFiles & files )
+        :m_targetdir(targetdir), m_basename(basename), m_files(files), m_pout(nullptr)
+    {}
+
+    template<class _EntryTy>
+        void BeginTable( const std::string & headertext, uint32_t, size_t )
+    {
+        m_pout = &m_files.Open( m_targetdir + "/" + m_basename + "." + MakeTableId(headertext) + ".csv" );
+        std::ostream & out = *m_pout;
+        out << "offset";
+        ForEachField<_EntryTy>( [&out]( const auto & field, size_t )
+        {
+            out << "," << field.name << ((field.format == eFieldFmt::Symbol)? "_ptr" : "");
+        });
+        out << ",symbol\n";
+    }
+
+    template<class _EntryTy>
+        void WriteRow( uint32_t rowoffset, const _EntryTy & entry, std::optional<std::string_view> symbol )
+    {
+        std::ostream & out = *m_pout;
+        out << rowoffset;
+        ForEachField<_EntryTy>( [&out,&entry]( const auto & field, size_t ){ out << "," << +(entry.*(field.member)); } );
+        out << ",";
+        if( symbol )
+        {
+            //Quote the symbol, and double any quotes inside it
+            out << '"';
+            for( char c : *symbol )
+            {
+                if( c == '"' )
+                    out << '"';
+                out << c;
+            }
+            out << '"';
+        }
+        out << "\n";
+    }
+
+    template<class _EntryTy>
+        void EndTable( typename _EntryTy::Stats & )
+    {
+        PMD2_PROF_COUNT( BytesWritten, m_pout->tellp() );
+        m_files.Close( *m_pout );
+        m_pout = nullptr;
+    }
+
+    void Finish()
+    {}
+
+    //Each table has its own file already, so forks write directly, and joining does nothing
+    typedef CsvSink fork_t;
+    std::unique_ptr<fork_t> Fork()const { return std::make_unique<CsvSink>( m_targetdir, m_basename, m_files ); }
+    void                    Join( fork_t & ) {}
+
+private:
+    std::string    m_targetdir;
+    std::string    m_basename;
+    OutputFiles &  m_files;
+    std::ostream * m_pout;
+};
+
+// ----------------------------------------------------------------------------------------
+/*
+    JsonLinesSink
+        Writes one JSON object per row, tagged with the table it comes from.
+        Ex: {"table":"event_list_table","offset":673936,"symbol_ptr":33835756,"unk1":5,...,"symbol":"D00P01"}
+*/
+class JsonLinesSink
+{
+public:
+    explicit JsonLinesSink( std::ostream & out )
+        :m_out(out)
+    {}
+
+    template<class _EntryTy>
+        void BeginTable( const std::string & headertext, uint32_t, size_t )
+    {
+        m_tableid = MakeTableId(headertext);
+    }
+
+    template<class _EntryTy>
+        void WriteRow( uint32_t rowoffset, const _EntryTy & entry, std::optional<std::string_view> symbol )
+    {
+        m_out << "{\"table\":\"" << m_tableid << "\",\"offset\":" << rowoffset;
+        ForEachField<_EntryTy>( [this,&entry]( const auto & field, size_t )
+        {
+            m_out << ",\"" << field.name << ((field.format == eFieldFmt::Symbol)? "_ptr" : "") << "\":" << +(entry.*(field.member));
+        });
+        m_out << ",\"symbol\":";
+        if( symbol )
+            WriteJsonString(*symbol);
+        else
+            m_out << "null";
+        m_out << "}\n";
+    }
+
+    template<class _EntryTy>
+        void EndTable( typename _EntryTy::Stats & )
+    {}
+
+    void Finish()
+    {
+        m_out.flush();
+    }
+
+    typedef BufferedSink<JsonLinesSink> fork_t;
+    std::unique_ptr<fork_t> Fork()const { return std::make_unique<fork_t>(); }
+    void                    Join( fork_t & fork ) { fork.WriteTo(m_out); }
+
+private:
+    //Escapes quotes, backslashes and anything outside of printable ASCII
+    void WriteJsonString( std::string_view str )
+    {
+        static const char HexDigits[] = "0123456789abcdef";
+        m_out << '"';
+        for( char c : str )
+        {
+            const unsigned char uc = static_cast<unsigned char>(c);
+            if( c == '"' || c == '\\' )
+                m_out << '\\' << c;
+            else if( uc < 0x20 || uc > 0x7E )
+                m_out << "\\u00" << HexDigits[uc >> 4] << HexDigits[uc & 0xF];
+            else
+                m_out << c;
+        }
+        m_out << '"';
+    }
+
+private:
+    std::ostream & m_out;
+    std::string         m_tableid;
+};
+
+// ----------------------------------------------------------------------------------------
+/*
+    BinarySink
+        Writes all the tables of a file into a single columnar binary file, meant to be memory mapped
+        as-is by other tools. Everything is little endian, and every column starts on an 8 bytes boundary.
+
+        Header (32 bytes):
+            char[8]  magic          "PMD2TBL\0"
+            uint32   version        1
+            uint32   nbtables
+            uint32   tablesoffset   Offset of the table descriptors
+            uint32   pooloffset     Offset of the string pool
+            uint32   poolsize
+            uint32   reserved
+        Table descriptor (32 bytes):
+            uint32   nameoffset     Table id, in the string pool
+            uint32   nbrows
+            uint32   nbcolumns
+            uint32   columnsoffset  Offset of the column descriptors
+            uint32   lutoffset      Offset of the table in the source binary
+            uint32   rowsize        Size of an entry in the source binary
+            uint32   reserved[2]
+        Column descriptor (16 bytes):
+            uint32   nameoffset     Column name, in the string pool
+            uint8    type           See eColType
+            uint8    valuesize      Size of a single value in bytes
+            uint16   reserved
+            uint32   dataoffset     Offset of the column's values
+            uint32   reserved
+        String pool:
+            Null terminated strings. Each distinct string is stored once.
+
+        The "offset" column holds each row's offset, and the "symbol" column holds the offset of each
+        row's symbol in the string pool, or 0xFFFFFFFF for null symbols.
+*/
+class BinarySink
+{
+public:
+    enum struct eColType : uint8_t
+    {
+        Int8      = 0,
+        UInt8     = 1,
+        Int16     = 2,
+        UInt16    = 3,
+        Int32     = 4,
+        UInt32    = 5,
+        StringRef = 6,  //uint32 offset into the string pool
+    };
+
+    static constexpr uint32_t Version       = 1;
+    static constexpr uint32_t HeaderLen     = 32;
+    static constexpr uint32_t TableDescLen  = 32;
+    static constexpr uint32_t ColumnDescLen = 16;
+    static constexpr uint32_t NullString    = 0xFFFFFFFF;
+
+    BinarySink( const std::string & fpath, OutputFiles & files )
+        :m_fpath(fpath), m_files(files)
+    {}
+
+    template<class _EntryTy>
+        void BeginTable( const std::string & headertext, uint32_t offset, size_t nbentries )
+    {
+        m_tables.emplace_back();
+        TableData & tbl = m_tables.back();
+        tbl.nameoff   = AddToPool( MakeTableId(headertext) );
+        tbl.lutoffset = offset;
+        tbl.rowsize   = static_cast<uint32_t>(_EntryTy::Size);
+
+        AddColumn( tbl, "offset", eColType::UInt32, sizeof(uint32_t), nbentries );
+        ForEachField<_EntryTy>( [this,&tbl,nbentries]( const auto & field, size_t )
+        {
+            typedef typename std::decay_t<decltype(field)>::field_t field_t;
+            const std::string colname = std::string(field.name) + ((field.format == eFieldFmt::Symbol)? "_ptr" : "");
+            AddColumn( tbl, colname, ColTypeOf<field_t>(), sizeof(field_t), nbentries );
+        });
+        AddColumn( tbl, "symbol", eColType::StringRef, sizeof(uint32_t), nbentries );
+    }
+
+    template<class _EntryTy>
+        void WriteRow( uint32_t rowoffset, const _EntryTy & entry, std::optional<std::string_view> symbol )
+    {
+        TableData & tbl = m_tables.back();
+        size_t      col = 0;
+        AppendLE( tbl.columns[col++].data, rowoffset, sizeof(uint32_t) );
+        ForEachField<_EntryTy>( [&tbl,&col,&entry]( const auto & field, size_t )
+        {
+            typedef typename std::decay_t<decltype(field)>::field_t field_t;
+            AppendLE( tbl.columns[col++].data, static_cast<std::make_unsigned_t<field_t>>(entry.*(field.member)), sizeof(field_t) );
+        });
+        AppendLE( tbl.columns[col++].data, symbol? AddToPool( std::string(*symbol) ) : NullString, sizeof(uint32_t) );
+        ++tbl.nbrows;
+    }
+
+    template<class _EntryTy>
+        void EndTable( typename _EntryTy::Stats & )
+    {}
+
+    /*
+        Lays out and writes the whole file.
+    */
+    void Finish()
+    {
+        //Compute where everything goes
+        uint32_t curoff = HeaderLen + static_cast<uint32_t>( m_tables.size() * TableDescLen );
+        for( TableData & tbl : m_tables )
+        {
+            tbl.columnsoffset = curoff;
+            curoff += static_cast<uint32_t>( tbl.columns.size() * ColumnDescLen );
+        }
+        for( TableData & tbl : m_tables )
+        {
+            for( ColumnData & col : tbl.columns )
+            {
+                curoff         = AlignTo8(curoff);
+                col.dataoffset = curoff;
+                curoff        += static_cast<uint32_t>( col.data.size() );
+            }
+        }
+        const uint32_t pooloffset = AlignTo8(curoff);
+
+        //Write it out
+        std::vector<uint8_t> out;
+        out.reserve( pooloffset + m_pool.size() );
+        const char Magic[8] = { 'P','M','D','2','T','B','L','\0' };
+        out.insert( out.end(), Magic, Magic + sizeof(Magic) );
+        AppendLE( out, Version, 4 );
+        AppendLE( out, static_cast<uint32_t>(m_tables.size()), 4 );
+        AppendLE( out, HeaderLen, 4 );
+        AppendLE( out, pooloffset, 4 );
+        AppendLE( out, static_cast<uint32_t>(m_pool.size()), 4 );
+        AppendLE( out, 0u, 4 );
+
+        for( const TableData & tbl : m_tables )
+        {
+            AppendLE( out, tbl.nameoff, 4 );
+            AppendLE( out, tbl.nbrows, 4 );
+            AppendLE( out, static_cast<uint32_t>(tbl.columns.size()), 4 );
+            AppendLE( out, tbl.columnsoffset, 4 );
+            AppendLE( out, tbl.lutoffset, 4 );
+            AppendLE( out, tbl.rowsize, 4 );
+            AppendLE( out, 0u, 4 );
+            AppendLE( out, 0u, 4 );
+        }
+        for( const TableData & tbl : m_tables )
+        {
+            for( const ColumnData & col : tbl.columns )
+            {
+                AppendLE( out, col.nameoff, 4 );
+                out.push_back( static_cast<uint8_t>(col.type) );
+                out.push_back( col.valuesize );
+                AppendLE( out, 0u, 2 );
+                AppendLE( out, col.dataoffset, 4 );
+                AppendLE( out, 0u, 4 );
+            }
+        }
+        for( const TableData & tbl : m_tables )
+        {
+            for( const ColumnData & col : tbl.columns )
+            {
+                out.resize( col.dataoffset, 0 );
+                out.insert( out.end(), col.data.begin(), col.data.end() );
+            }
+        }
+        out.resize( pooloffset, 0 );
+        out.insert( out.end(), m_pool.begin(), m_pool.end() );
+
+        std::ostream & fout = m_files.Open( m_fpath, true );
+        fout.write( reinterpret_cast<const char*>(out.data()), out.size() );
+        m_files.Close(fout);
+        PMD2_PROF_COUNT( BytesWritten, out.size() );
+    }
+
+    /*
+        Fork / Join
+            A fork collects tables into a string pool of its own. Joining moves its tables over, and
+            adds their strings to our pool in the order they were added to the fork's, so the file
+            comes out the same as when the tables are written to this sink directly.
+    */
+    typedef BinarySink fork_t;
+    std::unique_ptr<fork_t> Fork()const { return std::make_unique<BinarySink>( m_fpath, m_files ); }
+
+    void Join( fork_t & fork )
+    {
+        auto lambdaRemap = [this,&fork]( uint32_t stroff )
+        {
+            return AddToPool( std::string( reinterpret_cast<const char*>( fork.m_pool.data() + stroff ) ) );
+        };
+        for( TableData & tbl : fork.m_tables )
+        {
+            tbl.nameoff = lambdaRemap( tbl.nameoff );
+            for( ColumnData & col : tbl.columns )
+                col.nameoff = lambdaRemap( col.nameoff );
+            for( ColumnData & col : tbl.columns )
+            {
+                if( col.type != eColType::StringRef )
+                    continue;
+                for( size_t i = 0; (i + sizeof(uint32_t)) <= col.data.size(); i += sizeof(uint32_t) )
+                {
+                    const uint32_t stroff = LoadIntLE<uint32_t>( col.data.data() + i );
+                    if( stroff == NullString )
+                        continue;
+                    const uint32_t newoff = lambdaRemap(stroff);
+                    for( size_t b = 0; b < sizeof(uint32_t); ++b )
+                        col.data[i + b] = static_cast<uint8_t>( newoff >> (b * 8) );
+                }
+            }
+            m_tables.push_back( std::move(tbl) );
+        }
+        fork.m_tables.clear();
+    }
+
+private:
+    struct ColumnData
+    {
+        uint32_t        nameoff    = 0;
+        eColType        type       = eColType::UInt32;
+        uint8_t         valuesize  = 0;
+        uint32_t        dataoffset = 0;
+        std::vector<uint8_t> data;
+    };
+
+    struct TableData
+    {
+        uint32_t           nameoff       = 0;
+        uint32_t           nbrows        = 0;
+        uint32_t           lutoffset     = 0;
+        uint32_t           rowsize       = 0;
+        uint32_t           columnsoffset = 0;
+        std::vector<ColumnData> columns;
+    };
+
+    template<typename T>
+        static constexpr eColType ColTypeOf()
+    {
+        static_assert( sizeof(T) <= 4, "BinarySink::ColTypeOf(): Fields wider than 32 bits aren't supported!" );
+        if( sizeof(T) == 1 ) return std::is_signed_v<T>? eColType::Int8  : eColType::UInt8;
+        if( sizeof(T) == 2 ) return std::is_signed_v<T>? eColType::Int16 : eColType::UInt16;
+        return std::is_signed_v<T>? eColType::Int32 : eColType::UInt32;
+    }
+
+    void AddColumn( TableData & tbl, const std::string & name, eColType type, size_t valuesize, size_t nbentries )
+    {
+        ColumnData col;
+        col.nameoff   = AddToPool(name);
+        col.type      = type;
+        col.valuesize = static_cast<uint8_t>(valuesize);
+        col.data.reserve( valuesize * nbentries );
+        tbl.columns.push_back( std::move(col) );
+    }
+
+    //Returns the offset of the string in the pool, adding it if it's not already there
+    uint32_t AddToPool( const std::string & str )
+    {
+        auto found = m_poolindex.find(str);
+        if( found != m_poolindex.end() )
+            return found->second;
+        const uint32_t stroff = static_cast<uint32_t>( m_pool.size() );
+        m_pool.insert( m_pool.end(), str.begin(), str.end() );
+        m_pool.push_back(0);
+        m_poolindex.emplace( str, stroff );
+        return stroff;
+    }
+
+    template<typename T>
+        static void AppendLE( std::vector<uint8_t> & dest, T val, size_t nbbytes )
+    {
+        for( size_t i = 0; i < nbbytes; ++i )
+            dest.push_back( static_cast<uint8_t>( static_cast<uint64_t>(val) >> (i * 8) ) );
+    }
+
+    static inline uint32_t AlignTo8( uint32_t off ) { return (off + 7) & ~7u; }
+
+private:
+    std::string                          m_fpath;
+    OutputFiles &                        m_files;
+    std::vector<TableData>               m_tables;
+    std::vector<uint8_t>                 m_pool;
+    std::unordered_map<std::string,uint32_t>  m_poolindex;
+};
+
+// ----------------------------------------------------------------------------------------
+/*
+    WithOutputSink
+        Creates the sink for the requested format, writing the output of the "basename" binary
+        into "targetdir" through "files", and calls "fun( sink )" with it.
+*/
+template<class _FunTy>
+    void WithOutputSink( eOutFmt fmt, const std::string & targetdir, const std::string & basename, OutputFiles & files, _FunTy && fun )
+{
+    const std::string fbasepath = targetdir + "/" + basename;
+    switch(fmt)
+    {
+        case eOutFmt::Text:
+        {
+            std::ostream & out = files.Open( fbasepath + ".txt" );
+            TextSink sink(out);
+            fun(sink);
+            {
+                PMD2_PROF_TIME(Finish);
+                sink.Finish();
+                PMD2_PROF_COUNT( BytesWritten, out.tellp() );
+                files.Close(out);
+            }
+            break;
+        }
+        case eOutFmt::Csv:
+        {
+            CsvSink sink( targetdir, basename, files );
+            fun(sink);
+            PMD2_PROF_TIME(Finish);
+            sink.Finish();
+            break;
+        }
+        case eOutFmt::JsonLines:
+        {
+            std::ostream & out = files.Open( fbasepath + ".jsonl" );
+            JsonLinesSink sink(out);
+            fun(sink);
+            {
+                PMD2_PROF_TIME(Finish);
+                sink.Finish();
+                PMD2_PROF_COUNT( BytesWritten, out.tellp() );
+                files.Close(out);
+            }
+            break;
+        }
+        case eOutFmt::Binary:
+        {
+            BinarySink sink( fbasepath + ".pmd2tbl", files );
+            fun(sink);
+            PMD2_PROF_TIME(Finish);
+            sink.Finish();
+            break;
+        }
+    };
+}
+
+// ----------------------------------------------------------------------------------------
+/*
+    CachedTextSink
+        Writes the text layout, one table at a time, through the dump cache.
+        Before a table is decoded, ReuseTable() is called with the table's cache key. If the previous
+        run rendered a table with the same key, its text is written as-is, and the table isn't decoded.
+        Otherwise the table is rendered as usual, and its text is kept for the next run.
+        Without a stream, as in forks, the text of every table is kept in the sink's buffer instead.
+*/
+class CachedTextSink
+{
+public:
+    CachedTextSink( std::ostream & out, const DumpCache & oldcache, DumpCache & newcache )
+        :m_pout(&out), m_oldcache(oldcache), m_newcache(newcache), m_curkey(0), m_tablebeg(0)
+    {}
+
+    CachedTextSink( const DumpCache & oldcache, DumpCache & newcache )
+        :m_pout(nullptr), m_oldcache(oldcache), m_newcache(newcache), m_curkey(0), m_tablebeg(0)
+    {}
+
+    bool ReuseTable( uint64_t key )
+    {
+        m_curkey = key;
+        const std::string * pcached = m_oldcache.Find(key);
+        if( pcached == nullptr )
+            return false;
+        if( m_pout != nullptr )
+            *m_pout << *pcached;
+        else
+            m_text.Buffer() << *pcached;
+        m_newcache.Add( key, *pcached );
+        return true;
+    }
+
+    template<class _EntryTy>
+        void BeginTable( const std::string & headertext, uint32_t offset, size_t nbentries )
+    {
+        m_tablebeg = m_text.Buffer().size();
+        m_text.BeginTable<_EntryTy>( headertext, offset, nbentries );
+    }
+
+    template<class _EntryTy>
+        void WriteRow( uint32_t rowoffset, const _EntryTy & entry, std::optional<std::string_view> symbol )
+    {
+        m_text.WriteRow( rowoffset, entry, symbol );
+    }
+
+    template<class _EntryTy>
+        void EndTable( typename _EntryTy::Stats & stats )
+    {
+        m_text.EndTable<_EntryTy>(stats);
+        TextBuffer & buf = m_text.Buffer();
+        m_newcache.Add( m_curkey, std::string( buf.View().substr(m_tablebeg) ) );
+        if( m_pout != nullptr )
+            buf.WriteTo(*m_pout);
+    }
+
+    void Finish()
+    {
+        if( m_pout != nullptr )
+            m_pout->flush();
+    }
+
+    //Without a stream, the text of every table so far
+    inline TextBuffer & Buffer() { return m_text.Buffer(); }
+
+    class Branch;
+    typedef Branch fork_t;
+    std::unique_ptr<fork_t> Fork()const;
+    void                    Join( fork_t & fork );
+
+private:
+    std::ostream *    m_pout;
+    const DumpCache & m_oldcache;
+    DumpCache &       m_newcache;
+    TextSink          m_text;       //Renders without a stream, the tables are written from its buffer
+    uint64_t          m_curkey;
+    size_t            m_tablebeg;   //Where the current table's text begins in the buffer
+};
+
+/*
+    CachedTextSink::Branch
+        Fork of a CachedTextSink, with its own text buffer and its own list of new cache chunks.
+*/
+class CachedTextSink::Branch
+{
+public:
+    explicit Branch( const DumpCache & oldcache )
+        :m_sink( oldcache, m_newcache )
+    {}
+
+    bool ReuseTable( uint64_t key ) { return m_sink.ReuseTable(key); }
+
+    template<class _EntryTy>
+        void BeginTable( const std::string & headertext, uint32_t offset, size_t nbentries )
+    {
+        m_sink.BeginTable<_EntryTy>( headertext, offset, nbentries );
+    }
+
+    template<class _EntryTy>
+        void WriteRow( uint32_t rowoffset, const _EntryTy & entry, std::optional<std::string_view> symbol )
+    {
+        m_sink.WriteRow( rowoffset, entry, symbol );
+    }
+
+    template<class _EntryTy>
+        void EndTable( typename _EntryTy::Stats & stats )
+    {
+        m_sink.EndTable<_EntryTy>(stats);
+    }
+
+private:
+    friend class CachedTextSink;
+    DumpCache         m_newcache;
+    CachedTextSink    m_sink;
+};
+
+inline std::unique_ptr<CachedTextSink::Branch> CachedTextSink::Fork()const
+{
+    return std::make_unique<Branch>(m_oldcache);
+}
+
+inline void CachedTextSink::Join( Branch & fork )
+{
+    TextBuffer & text = fork.m_sink.m_text.Buffer();
+    if( m_pout != nullptr )
+        text.WriteTo(*m_pout);
+    else
+        m_text.Buffer() << text.View();
+    for( const DumpCache::Chunk & chunk : fork.m_newcache.Chunks() )
+        m_newcache.Add( chunk.key, chunk.text );
+}
+
+//Whether the sink can skip decoding tables it already has the output of
+template<class _sinkTy, class = void>
+    struct SinkReusesTables : std::false_type {};
+template<class _sinkTy>
+    struct SinkReusesTables<_sinkTy, std::void_t<decltype( std::declval<_sinkTy&>().ReuseTable( uint64_t() ) )>> : std::true_type {};
+
+//Whether the sink can render its tables on separate forks
+template<class _sinkTy, class = void>
+    struct SinkForksTables : std::false_type {};
+template<class _sinkTy>
+    struct SinkForksTables<_sinkTy, std::void_t<decltype( std::declval<_sinkTy&>().Join( *std::declval<_sinkTy&>().Fork() ) )>> : std::true_type {};
+
+template<class _sinkTy, bool = SinkForksTables<_sinkTy>::value>
+    struct SinkForkOf { struct type {}; };
+template<class _sinkTy>
+    struct SinkForkOf<_sinkTy, true> { typedef typename _sinkTy::fork_t type; };
+
+// ----------------------------------------------------------------------------------------
+/*
+    OrderedTableWriter
+        Dumps the tables of a file on parallel tasks, each into its own fork of the file's sink, then
+        joins the forks back in the order the tables were added, so the output doesn't depend on which
+        table finishes first. The file takes as long as its largest table, instead of all of them.
+        Without a pool, or with a sink that can't fork, each table is dumped as it's added.
+
+        "dumptable( sink )" must be callable with either the sink, or its fork type.
+*/
+template<class _sinkTy>
+    class OrderedTableWriter
+{
+public:
+    OrderedTableWriter( _sinkTy & out, ThreadPool * ppool )
+        :m_out(out), m_ppool(ppool), m_tasks(ppool)
+    {}
+
+    template<class _FunTy>
+        void Add( _FunTy dumptable )
+    {
+        if constexpr( SinkForksTables<_sinkTy>::value )
+        {
+            if( m_ppool != nullptr )
+            {
+                m_forks.push_back( m_out.Fork() );
+                auto *      pfork = m_forks.back().get();
+                std::string scope = prof::CurrentScopeName();
+                m_tasks.Run( [pfork, scope, dumptable]() mutable
+                {
+                    PMD2_PROF_SCOPE(scope);
+                    dumptable(*pfork);
+                });
+                return;
+            }
+        }
+        dumptable(m_out);
+    }
+
+    /*
+        Waits on the tables, and writes them to the sink in order.
+        Rethrows the error of the first table that failed, if any.
+    */
+    void Finish()
+    {
+        m_tasks.Wait();
+        if constexpr( SinkForksTables<_sinkTy>::value )
+        {
+            for( auto & pfork : m_forks )
+                m_out.Join(*pfork);
+        }
+        m_forks.clear();
+    }
+
+private:
+    typedef typename SinkForkOf<_sinkTy>::type fork_t;
+
+    _sinkTy &                            m_out;
+    ThreadPool *                         m_ppool;
+    std::vector<std::unique_ptr<fork_t>> m_forks;
+    TaskGroup                            m_tasks;    //Last, so the tasks are done before the forks go away
+};
+
+//============================================================================================================
+/*
+    IndexTableStrings
+        Indexes the strings the symbol pointers of a table point to. They're usually packed
+        together right before the table, so the indexed region is just the span from the lowest
+        to the highest pointer. Pointers that lead outside of the file are left out, so they fail
+        in FetchString() when their row is reached, like they would without the index.
+*/
+template<typename _structType>
+    StringIndex IndexTableStrings( const uint8_t * ptable, const size_t nbentries, const uint8_t * pfbeg, const uint8_t * pfend, const uint32_t ptrDiff )
+{
+    const size_t fsize    = static_cast<size_t>(pfend - pfbeg);
+    uint32_t     lowest   = std::numeric_limits<uint32_t>::max();
+    uint32_t     highest  = 0;
+    for( size_t i = 0; i < nbentries; ++i )
+    {
+        const uint32_t ptrstring = LoadIntLE<uint32_t>( ptable + (i * _structType::Size) + _structType::PtrOffset() );
+        const uint32_t stroffset = ptrstring - ptrDiff;
+        if( ptrstring == 0 || stroffset >= fsize )
+            continue;
+        lowest  = std::min( lowest,  stroffset );
+        highest = std::max( highest, stroffset );
+    }
+    if( lowest > highest )
+        return StringIndex( pfbeg, pfend );
+    return StringIndex( pfbeg, pfend, lowest, highest );
+}
+
+/*
+    TableCacheKey
+        Hash of everything a table's rendered output depends on: its position, its records, and
+        the symbols they point to. The symbols are only measured, not decoded or formatted, so
+        this costs about as much as reading the table once.
+*/
+template<typename _structType>
+    uint64_t TableCacheKey( const uint32_t offset, const size_t nbentries, const uint8_t * pfbeg, const StringIndex & strings, const std::string & headertext, const uint32_t ptrDiff )
+{
+    const uint8_t * ptable  = pfbeg + offset;
+    XXH64State      state;
+    state.Update( headertext.data(), headertext.size() );
+    state.UpdateInt( offset );
+    state.UpdateInt( static_cast<uint64_t>(nbentries) );
+    state.UpdateInt( ptrDiff );
+    state.Update( ptable, nbentries * _structType::Size );
+    for( size_t i = 0; i < nbentries; ++i )
+    {
+        const uint32_t ptrstring = LoadIntLE<uint32_t>( ptable + (i * _structType::Size) + _structType::PtrOffset() );
+        if( ptrstring == 0 )
+            continue;
+        std::string_view symbol = strings.Fetch( ptrstring - ptrDiff );
+        state.Update( symbol.data(), symbol.size() + 1 );  //With the terminator, so "AB","C" and "A","BC" differ
+    }
+    return state.Digest();
+}
+
+template<typename _structType, typename _init, typename _sinkTy>
+    typename _structType::Stats ParseAndDumpLUT( const uint32_t offset, const size_t nbentries, _init itbeg, _init itend, _sinkTy & out, const std::string & headertext, const uint32_t ptrDiff )
+{
+    typename _structType::Stats statisticslog;
+    auto                        itfbeg        = itbeg; //Save iterator before advancing it
+    if( static_cast<size_t>(std::distance(itbeg, itend)) < (offset + (nbentries * _structType::Size)) )
+        throw std::runtime_error("ParseAndDumpLUT(): The " + headertext + " at " + NumberToHexString(offset) + " goes past the end of the file!");
+    std::advance( itbeg, offset );
+    PMD2_PROF_SCOPE(headertext);
+
+    const uint8_t *   pfbeg = reinterpret_cast<const uint8_t*>( &(*itfbeg) );
+    const uint8_t *   pfend = pfbeg + std::distance(itfbeg, itend);
+    StringIndex       strings;
+    {
+        PMD2_PROF_TIME(FetchString);
+        strings = IndexTableStrings<_structType>( pfbeg + offset, nbentries, pfbeg, pfend, ptrDiff );
+    }
+
+    if constexpr( SinkReusesTables<_sinkTy>::value )
+    {
+        //The stats are part of the reused output, so they're left empty here
+        if( out.ReuseTable( TableCacheKey<_structType>( offset, nbentries, pfbeg, strings, headertext, ptrDiff ) ) )
+            return statisticslog;
+    }
+
+    PMD2_PROF_COUNT( RecordsDecoded, nbentries );
+#if PMD2_PROFILING
+    const bool bprofile = prof::IsEnabled();
+#endif
+    {
+        PMD2_PROF_TIME(Format);
+        out.template BeginTable<_structType>( headertext, offset, nbentries );
+    }
+    size_t nbstrings = 0;
+    for( size_t cntentries = 0; cntentries < nbentries; ++cntentries )
+    {
+        _structType curentry;
+        {
+            PMD2_PROF_TIME_IF(bprofile, Decode);
+            itbeg = curentry.Read( itbeg, itend );
+        }
+
+        std::optional<std::string_view> symbol;
+        const uint32_t                  ptrstring = curentry.SymbolPtr();
+        if( ptrstring != 0 )
+        {
+            PMD2_PROF_TIME_IF(bprofile, FetchString);
+            ++nbstrings;
+            symbol = strings.Fetch( ptrstring - ptrDiff );
+        }
+
+        {
+            PMD2_PROF_TIME_IF(bprofile, Format);
+            out.WriteRow( static_cast<uint32_t>( (cntentries * _structType::Size) + offset ), curentry, symbol );
+        }
+        PMD2_PROF_TIME_IF(bprofile, Stats);
+        statisticslog.LogStats(curentry);
+    }
+    PMD2_PROF_COUNT( StringsFetched, nbstrings );
+    PMD2_PROF_TIME(Format);
+    out.template EndTable<_structType>( statisticslog );
+    return statisticslog;
+}
+
+
+
+
+// ----------------------------------------------------------------------------------------
+/*
+    LevelEntry
+        Single entry in the level list
+*/
+struct LevelEntry : public TableEntry<LevelEntry>
+{
+    uint32_t ptrstring  = 0;
+    int16_t  unk1       = 0;
+    int16_t  unk2       = 0;
+    int16_t  unk3       = 0;
+    int16_t  unk4       = 0;
+
+    static const size_t Size = 12;
+
+    static constexpr auto Fields()
+    {
+        return std::make_tuple(
+            MakeSymbolField( &LevelEntry::ptrstring ),
+            MakeField( &LevelEntry::unk1, "unk1", "Unk1   ", "unk1   :", 5 ),
+            MakeField( &LevelEntry::unk2, "unk2", "unk2   ", "unk2   :", 5 ),
+            MakeField( &LevelEntry::unk3, "unk3", "SomeId ", "SomeId :", 5 ),
+            MakeField( &LevelEntry::unk4, "unk4", "Unk4   ", "unk4   :", 5 )
+        );
+    }
+};
+
+//Explorers of Sky (NA), arm9
+//0x000A46EC -> Start of strings
+//0x000A5490 -> Start of LUT. 12 bytes entries. 1 pointer, 4 shorts.
+//0x000A68C4 -> One past end of LUT. 431 entries.
+inline const KnownLUT EventListEoS { "Event List Table", 0xA5490, 431 };
+
+/*
+    LocateEventList
+        Where the event list table is in the arm9, or the closest table with the same layout.
+*/
+inline LUTLocation LocateEventList( LUTLocator & locator )
+{
+    PMD2_PROF_TIME(Locate);
+    return locator.Locate( EventListEoS, LevelEntry::Size, LevelEntry::PtrOffset() );
+}
+
+template<typename _init, typename _sinkTy>
+    LevelEntry::Stats DumpEventListEoS( _init itbeg, _init itend, _sinkTy & out, LUTLocator & locator )
+{
+    const LUTLocation loc = LocateEventList( locator );
+    return ParseAndDumpLUT<LevelEntry>( loc.offset, loc.nbentries, itbeg, itend, out, "Event List Table", locator.LoadOffset() );
+}
+
+
+// ----------------------------------------------------------------------------------------
+/*
+    SpecListEntry
+        Single entry in the level list
+*/
+struct SpecListEntry : public TableEntry<SpecListEntry>
+{
+    int16_t  id         = 0;
+    int16_t  unk2       = 0;
+    uint32_t ptrstring  = 0;
+
+    static const size_t Size = 8;
+
+    static constexpr auto Fields()
+    {
+        return std::make_tuple(
+            MakeField( &SpecListEntry::id,   "id",   "Id     ", "Id   :", 5 ),
+            MakeField( &SpecListEntry::unk2, "unk2", "Unk2   ", "unk2 :", 5 ),
+            MakeSymbolField( &SpecListEntry::ptrstring )
+        );
+    }
+};
+
+
+
+//Explorers of Sky (NA), overlay_0011
+//0x0003D8AC -> start strings
+//0x000405E8 -> Start LUT. 8 bytes entries, 2 shorts, one pointer.
+//0x00041BD0 -> One past end of LUT. 701 entries.
+inline const KnownLUT SpecialListEoS { "Special List Table", 0x405E8, 701 };
+
+/*
+    LocateSpecialList
+        Where the special list table is in the overlay 11, or the closest table with the same layout.
+*/
+inline LUTLocation LocateSpecialList( LUTLocator & locator )
+{
+    PMD2_PROF_TIME(Locate);
+    return locator.Locate( SpecialListEoS, SpecListEntry::Size, SpecListEntry::PtrOffset() );
+}
+
+template<typename _init, typename _sinkTy>
+    SpecListEntry::Stats DumpSpecialListEoS( _init itbeg, _init itend, _sinkTy & out, LUTLocator & locator )
+{
+    const LUTLocation loc = LocateSpecialList( locator );
+    return ParseAndDumpLUT<SpecListEntry>( loc.offset, loc.nbentries, itbeg, itend, out, "Special List Table", locator.LoadOffset() );
+}
+
+// ----------------------------------------------------------------------------------------
+/*
+    EventSubFileListEntry
+        Single entry in the level list
+*/
+struct EventSubFileListEntry : public TableEntry<EventSubFileListEntry>
+{
+    int16_t  unk1       = 0;
+    int16_t  unk2       = 0;
+    uint32_t ptrstring  = 0;
+    uint32_t unk3       = 0;
+
+    static const size_t Size = 12;
+
+    static constexpr auto Fields()
+    {
+        return std::make_tuple(
+            MakeField( &EventSubFileListEntry::unk1, "unk1", "Unk1   ",    "unk1 :", 5 ),
+            MakeField( &EventSubFileListEntry::unk2, "unk2", "Unk2   ",    "unk2 :", 5 ),
+            MakeSymbolField( &EventSubFileListEntry::ptrstring ),
+            MakeField( &EventSubFileListEntry::unk3, "unk3", "Unk3      ", "unk3 :", 8 )
+        );
+    }
+};
+
+
+
+//Explorers of Sky (NA), overlay_0011
+//0x00041C00 -> Start strings.
+//0x00042C14 -> Start LUT. 12 bytes entries. 2 shorts, 1 pointer, 1 int32
+//0x00044610 -> One past the end of LUT. 555 entries, some were null.
+inline const KnownLUT EventSubFileListEoS { "Event Sub File List Table", 0x42C14, 555 };
+
+/*
+    LocateEventSubFileList
+        Where the event sub file list table is in the overlay 11, or the closest table with the same layout.
+*/
+inline LUTLocation LocateEventSubFileList( LUTLocator & locator )
+{
+    PMD2_PROF_TIME(Locate);
+    return locator.Locate( EventSubFileListEoS, EventSubFileListEntry::Size, EventSubFileListEntry::PtrOffset() );
+}
+
+template<typename _init, typename _sinkTy>
+    EventSubFileListEntry::Stats DumpEventSubFileListEoS( _init itbeg, _init itend, _sinkTy & out, LUTLocator & locator )
+{
+    const LUTLocation loc = LocateEventSubFileList( locator );
+    return ParseAndDumpLUT<EventSubFileListEntry>( loc.offset, loc.nbentries, itbeg, itend, out, "Event Sub File List Table", locator.LoadOffset() );
+}
+// ----------------------------------------------------------------------------------------
+/*
+    EntitySymbolListEntry
+        Single entry in the level list
+*/
+struct EntitySymbolListEntry : public TableEntry<EntitySymbolListEntry>
+{
+    int16_t  type       = 0;
+    int16_t  entityid   = 0;
+    uint32_t ptrstring  = 0;
+    uint16_t unk3       = 0;
+    uint16_t unk4       = 0;
+
+    static const size_t Size = 12;
+
+    static constexpr auto Fields()
+    {
+        return std::make_tuple(
+            MakeField( &EntitySymbolListEntry::type,     "type",     "Type   ",    "Type      :", 5 ),
+            MakeField( &EntitySymbolListEntry::entityid, "entityid", "Entity Id ", "Entity ID :", 9 ),
+            MakeSymbolField( &EntitySymbolListEntry::ptrstring ),
+            MakeField( &EntitySymbolListEntry::unk3,     "unk3",     "Unk3   ",    "unk3      :", 4, eFieldFmt::Hex ),
+            MakeField( &EntitySymbolListEntry::unk4,     "unk4",     "Unk4   ",    "unk4      :", 4, eFieldFmt::Hex )
+        );
+    }
+};
+
+
+
+//Explorers of Sky (NA), arm9
+//0x000A6910 -> Start Strings
+//0x000A7FF0 -> Start of LUT. 12 bytes entries. 2 shorts, 1 pointer, 2 shorts.
+//0x000A9208 -> One past end of LUT. 386 entries.
+inline const KnownLUT EntitySymbolsEoS { "Entity Symbol List Table", 0xA7FF0, 386 };
+
+/*
+    LocateEntitySymbols
+        Where the entity symbol list table is in the arm9, or the closest table with the same layout.
+*/
+inline LUTLocation LocateEntitySymbols( LUTLocator & locator )
+{
+    PMD2_PROF_TIME(Locate);
+    return locator.Locate( EntitySymbolsEoS, EntitySymbolListEntry::Size, EntitySymbolListEntry::PtrOffset() );
+}
+
+template<typename _init, typename _sinkTy>
+    EntitySymbolListEntry::Stats DumpEntitySymbolsEoS( _init itbeg, _init itend, _sinkTy & out, LUTLocator & locator )
+{
+    const LUTLocation loc = LocateEntitySymbols( locator );
+    return ParseAndDumpLUT<EntitySymbolListEntry>( loc.offset, loc.nbentries, itbeg, itend, out, "Entity Symbol List Table", locator.LoadOffset() );
+}
+
+
+
+// ----------------------------------------------------------------------------------------
+/*
+    TablesStats
+        Statistics on the fields of every dumped table.
+        The stats of several files can be merged, to get the distribution of values over a whole batch.
+*/
+struct TablesStats
+{
+    EntitySymbolListEntry::Stats entitysymbols;
+    LevelEntry::Stats            events;
+    EventSubFileListEntry::Stats eventsubfiles;
+    SpecListEntry::Stats         specials;
+    size_t                       nbarm9      = 0;
+    size_t                       nboverlay11 = 0;
+
+    void Merge( const TablesStats & other )
+    {
+        entitysymbols.Merge( other.entitysymbols );
+        events       .Merge( other.events );
+        eventsubfiles.Merge( other.eventsubfiles );
+        specials     .Merge( other.specials );
+        nbarm9      += other.nbarm9;
+        nboverlay11 += other.nboverlay11;
+    }
+
+    std::string Print()
+    {
+        TextBuffer out;
+        auto lambdaPrintTable = [&out]( const char * headertext, size_t nbfiles, auto & stats )
+        {
+            out << "============================================================\n"
+                << headertext <<" (";
+            out.AppendDec( nbfiles );
+            out << " file(s))\n"
+                << "============================================================\n";
+            stats.Print(out);
+            out << "\n";
+        };
+        lambdaPrintTable( "Entity Symbol List Table",  nbarm9,      entitysymbols );
+        lambdaPrintTable( "Event List Table",          nbarm9,      events );
+        lambdaPrintTable( "Event Sub File List Table", nboverlay11, eventsubfiles );
+        lambdaPrintTable( "Special List Table",        nboverlay11, specials );
+        return out.str();
+    }
+};
+
+#endif
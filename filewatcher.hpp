@@ -0,0 +1,213 @@
+#ifndef FILEWATCHER_HPP
+#define FILEWATCHER_HPP
+/*
+filewatcher.hpp
+    Waits for files to change on disk.
+
+    On Linux, inotify watches the directories the files are in rather than the files themselves,
+    since editors and build tools often save by renaming a new file over the old one, which would
+    end a watch on the old file. Elsewhere, or if inotify can't be used, the size and modification
+    time of the files are polled instead. Either way, changes are only reported once the files
+    stayed untouched for a short delay, so a file written in several steps is reported once.
+*/
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+    #include <sys/inotify.h>
+    #include <poll.h>
+    #include <unistd.h>
+#endif
+
+class FileWatcher
+{
+public:
+    /*
+        "pollinterval" is how often files are checked when polling, and "settledelay" how long
+        the files must stay untouched before a change is reported.
+    */
+    explicit FileWatcher( std::vector<std::string> fpaths, bool bforcepolling = false,
+                          std::chrono::milliseconds pollinterval = std::chrono::milliseconds(250),
+                          std::chrono::milliseconds settledelay  = std::chrono::milliseconds(50) )
+        :m_fpaths(std::move(fpaths)), m_pollinterval(pollinterval), m_settledelay(settledelay)
+    {
+        for( const std::string & fpath : m_fpaths )
+            m_states.push_back( StatFile(fpath) );
+#ifdef __linux__
+        if( !bforcepolling )
+            InitInotify();
+#else
+        (void)bforcepolling;
+#endif
+    }
+
+    ~FileWatcher()
+    {
+#ifdef __linux__
+        if( m_inotifyfd != -1 )
+            close(m_inotifyfd);
+#endif
+    }
+
+    FileWatcher( const FileWatcher & )             = delete;
+    FileWatcher & operator=( const FileWatcher & ) = delete;
+
+    inline bool UsesInotify()const { return m_inotifyfd != -1; }
+
+    /*
+        WaitForChanges
+            Blocks until at least one of the files changed, and returns the indices of the files
+            that did, in order.
+    */
+    std::vector<size_t> WaitForChanges()
+    {
+#ifdef __linux__
+        if( m_inotifyfd != -1 )
+            return WaitInotify();
+#endif
+        return WaitPolling();
+    }
+
+private:
+    struct FileState
+    {
+        bool                                   bexists = false;
+        std::uintmax_t                         size    = 0;
+        std::filesystem::file_time_type        mtime;
+
+        inline bool operator!=( const FileState & other )const
+        {
+            return bexists != other.bexists || size != other.size || mtime != other.mtime;
+        }
+    };
+
+    static FileState StatFile( const std::string & fpath )
+    {
+        FileState       state;
+        std::error_code ec;
+        state.size    = std::filesystem::file_size( fpath, ec );
+        state.bexists = !ec;
+        if( state.bexists )
+            state.mtime = std::filesystem::last_write_time( fpath, ec );
+        return state;
+    }
+
+    //Indices of the files whose state changed since last time, and remembers their new state
+    std::vector<size_t> CheckStates()
+    {
+        std::vector<size_t> changed;
+        for( size_t i = 0; i < m_fpaths.size(); ++i )
+        {
+            FileState state = StatFile( m_fpaths[i] );
+            if( state != m_states[i] )
+            {
+                m_states[i] = state;
+                changed.push_back(i);
+            }
+        }
+        return changed;
+    }
+
+    std::vector<size_t> WaitPolling()
+    {
+        std::set<size_t> changed;
+        for(;;)
+        {
+            std::this_thread::sleep_for( changed.empty()? m_pollinterval : m_settledelay );
+            std::vector<size_t> newchanges = CheckStates();
+            if( newchanges.empty() && !changed.empty() )
+                return std::vector<size_t>( changed.begin(), changed.end() );
+            changed.insert( newchanges.begin(), newchanges.end() );
+        }
+    }
+
+#ifdef __linux__
+    void InitInotify()
+    {
+        m_inotifyfd = inotify_init1(IN_CLOEXEC);
+        if( m_inotifyfd == -1 )
+            return;
+        for( const std::string & fpath : m_fpaths )
+        {
+            const std::filesystem::path path(fpath);
+            const std::string           dir = path.has_parent_path()? path.parent_path().string() : std::string(".");
+            const int wd = inotify_add_watch( m_inotifyfd, dir.c_str(), IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE | IN_DELETE );
+            if( wd == -1 )
+            {
+                //Fall back to polling for every file, rather than missing some changes
+                close(m_inotifyfd);
+                m_inotifyfd = -1;
+                m_watches.clear();
+                return;
+            }
+            m_watches.push_back( Watch{ wd, path.filename().string() } );
+        }
+    }
+
+    //Reads the pending events, and adds the files they're about to "changed". Returns false on timeout.
+    bool ReadInotify( int timeoutms, std::set<size_t> & changed )
+    {
+        pollfd pfd { m_inotifyfd, POLLIN, 0 };
+        const int nbready = poll( &pfd, 1, timeoutms );
+        if( nbready == 0 )
+            return false;
+        if( nbready < 0 )
+            return true;    //Interrupted, just check again
+
+        alignas(inotify_event) char buf[4096];
+        const ssize_t nbread = read( m_inotifyfd, buf, sizeof(buf) );
+        if( nbread <= 0 )
+            return true;
+        for( ssize_t pos = 0; pos < nbread; )
+        {
+            const inotify_event * pevent = reinterpret_cast<const inotify_event*>( buf + pos );
+            pos += sizeof(inotify_event) + pevent->len;
+            if( pevent->len == 0 )
+                continue;
+            const std::string name( pevent->name );
+            for( size_t i = 0; i < m_watches.size(); ++i )
+            {
+                if( m_watches[i].wd == pevent->wd && m_watches[i].fname == name )
+                    changed.insert(i);
+            }
+        }
+        return true;
+    }
+
+    std::vector<size_t> WaitInotify()
+    {
+        std::set<size_t> changed;
+        while( changed.empty() )
+            ReadInotify( -1, changed );
+        while( ReadInotify( static_cast<int>( m_settledelay.count() ), changed ) )
+        {}
+        for( size_t i : changed )
+            m_states[i] = StatFile( m_fpaths[i] );
+        return std::vector<size_t>( changed.begin(), changed.end() );
+    }
+
+    struct Watch
+    {
+        int         wd;
+        std::string fname;
+    };
+    std::vector<Watch>         m_watches;   //One per file, in the same order
+#endif
+
+private:
+    std::vector<std::string>   m_fpaths;
+    std::vector<FileState>     m_states;
+    std::chrono::milliseconds  m_pollinterval;
+    std::chrono::milliseconds  m_settledelay;
+    int                        m_inotifyfd = -1;
+};
+
+#endif
@@ -0,0 +1,400 @@
+#ifndef LUTSCANNER_HPP
+#define LUTSCANNER_HPP
+/*
+lutscanner.hpp
+    Locates symbol lookup tables inside a binary image, without knowing their offsets beforehand.
+
+    The tables we dump are arrays of fixed size records, where each record contains a pointer to a
+    null terminated ASCII symbol. So we look for runs of 32 bits words, spaced by the record size,
+    that are all either null or pointing at a string inside the image once it's loaded in memory.
+*/
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define LUTSCANNER_USE_SSE2
+#endif
+
+/*
+    FoundLUT
+        A table found by the scanner.
+        "ptrcolumn" is the file offset of the first record's pointer field. The record itself
+        starts "ptroffset" bytes before that, depending on the layout of the record.
+*/
+struct FoundLUT
+{
+    uint32_t ptrcolumn  = 0;
+    uint32_t stride     = 0;
+    size_t   nbentries  = 0;
+};
+
+/*
+    LUTLocation
+        Where a table actually begins, and how many entries it has.
+        "bfallback" is set when the table wasn't valid where it was expected, at "expectedoffset",
+        and the closest table the scan found was picked instead.
+*/
+struct LUTLocation
+{
+    uint32_t offset         = 0;
+    size_t   nbentries      = 0;
+    bool     bfallback      = false;
+    uint32_t expectedoffset = 0;
+};
+
+/*
+    LocatedLUT
+        A table located by name.
+*/
+struct LocatedLUT
+{
+    std::string tblname;
+    LUTLocation loc;
+};
+
+/*
+    KnownLUT
+        Where a given build of the game keeps a table, by the table's name.
+*/
+struct KnownLUT
+{
+    std::string tblname;
+    uint32_t    offset     = 0;
+    size_t      nbentries  = 0;
+};
+
+namespace lutscan
+{
+    //Record sizes the scanner looks for
+    const uint32_t ScannedStrides[]    = { 8, 12 };
+    //Shortest table worth reporting
+    const size_t   MinTableEntries     = 16;
+    //Longest run of null pointers allowed inside a table
+    const size_t   MaxConsecutiveNulls = 8;
+    //Longest symbol accepted
+    const size_t   MaxSymbolLength     = 255;
+
+    enum struct eWordKind : uint8_t
+    {
+        Other   = 0,
+        Null    = 1,
+        Pointer = 2,
+    };
+
+    inline uint32_t ReadWordLE( const uint8_t * p )
+    {
+        return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+    /*
+        IsSymbolAt
+            Whether there's a non-empty, null terminated, printable ASCII string at the file offset.
+    */
+    inline bool IsSymbolAt( const uint8_t * beg, size_t imgsize, size_t offset )
+    {
+        size_t maxlen = std::min( imgsize - offset, MaxSymbolLength + 1 );
+        size_t len    = 0;
+        for( ; len < maxlen; ++len )
+        {
+            uint8_t c = beg[offset + len];
+            if( c == 0 )
+                return len > 0;
+            if( c < 0x20 || c > 0x7E )
+                return false;
+        }
+        return false;
+    }
+
+    /*
+        IsStringAt
+            Whether there's a null terminated string at the file offset, like FetchString() expects.
+            Unlike IsSymbolAt(), the string may be empty and hold any byte.
+    */
+    inline bool IsStringAt( const uint8_t * beg, size_t imgsize, size_t offset )
+    {
+        return offset < imgsize && std::memchr( beg + offset, 0, imgsize - offset ) != nullptr;
+    }
+
+    /*
+        ClassifyWords
+            Sorts every aligned word of the image into null, in-range pointer, or anything else.
+            Pointer range checks are done 4 words at a time when SSE2 is available.
+    */
+    inline void ClassifyWords( const uint8_t * beg, size_t imgsize, uint32_t loadoffset, std::vector<eWordKind> & kinds )
+    {
+        const size_t nbwords = imgsize / 4;
+        kinds.assign( nbwords, eWordKind::Other );
+        size_t iw = 0;
+
+#ifdef LUTSCANNER_USE_SSE2
+        //Unsigned (word - loadoffset) < imgsize, done as a signed compare with the sign bits flipped
+        const __m128i vload  = _mm_set1_epi32( static_cast<int>(loadoffset) );
+        const __m128i vsign  = _mm_set1_epi32( static_cast<int>(0x80000000u) );
+        const __m128i vlimit = _mm_set1_epi32( static_cast<int>( static_cast<uint32_t>(imgsize) ^ 0x80000000u ) );
+        const __m128i vzero  = _mm_setzero_si128();
+        for( ; (iw + 4) <= nbwords; iw += 4 )
+        {
+            __m128i words   = _mm_loadu_si128( reinterpret_cast<const __m128i*>( beg + (iw * 4) ) );
+            __m128i rel     = _mm_xor_si128( _mm_sub_epi32( words, vload ), vsign );
+            int     inrange = _mm_movemask_ps( _mm_castsi128_ps( _mm_cmplt_epi32( rel, vlimit ) ) );
+            int     isnull  = _mm_movemask_ps( _mm_castsi128_ps( _mm_cmpeq_epi32( words, vzero ) ) );
+            if( (inrange | isnull) == 0 )
+                continue;
+            for( int lane = 0; lane < 4; ++lane )
+            {
+                if( isnull & (1 << lane) )
+                    kinds[iw + lane] = eWordKind::Null;
+                else if( inrange & (1 << lane) )
+                    kinds[iw + lane] = eWordKind::Pointer;
+            }
+        }
+#endif
+        for( ; iw < nbwords; ++iw )
+        {
+            uint32_t word = ReadWordLE( beg + (iw * 4) );
+            if( word == 0 )
+                kinds[iw] = eWordKind::Null;
+            else if( (word - loadoffset) < imgsize )
+                kinds[iw] = eWordKind::Pointer;
+        }
+
+        //Only keep the pointers that lead to a symbol
+        for( iw = 0; iw < nbwords; ++iw )
+        {
+            if( kinds[iw] == eWordKind::Pointer && !IsSymbolAt( beg, imgsize, ReadWordLE( beg + (iw * 4) ) - loadoffset ) )
+                kinds[iw] = eWordKind::Other;
+        }
+    }
+
+    /*
+        IsPointerArray
+            Whether the other words of the records in the run are mostly symbol pointers too.
+            A plain array of pointers matches every stride, so we don't want to report it.
+    */
+    inline bool IsPointerArray( const std::vector<eWordKind> & kinds, size_t firstword, size_t strideinwords, size_t nbentries )
+    {
+        size_t nbptrs  = 0;
+        size_t nbslots = 0;
+        for( size_t i = 0; i < nbentries; ++i )
+        {
+            for( size_t w = 1; w < strideinwords; ++w )
+            {
+                size_t iw = firstword + (i * strideinwords) + w;
+                if( iw >= kinds.size() )
+                    break;
+                ++nbslots;
+                if( kinds[iw] == eWordKind::Pointer )
+                    ++nbptrs;
+            }
+        }
+        return (nbptrs * 2) > nbslots;
+    }
+}
+
+/*
+    ScanForLUTs
+        Sweeps the whole image for tables of 8 or 12 bytes records containing a pointer to a symbol.
+        "loadoffset" is the address the image is loaded at on the NDS, used to tell pointers into the image apart.
+        Returns the tables sorted by their position.
+*/
+inline std::vector<FoundLUT> ScanForLUTs( const uint8_t * beg, const uint8_t * end, uint32_t loadoffset, size_t minentries = lutscan::MinTableEntries )
+{
+    using namespace lutscan;
+    const size_t           imgsize = static_cast<size_t>(end - beg);
+    std::vector<eWordKind> kinds;
+    std::vector<FoundLUT>  found;
+    ClassifyWords( beg, imgsize, loadoffset, kinds );
+
+    for( uint32_t stride : ScannedStrides )
+    {
+        const size_t sw = stride / 4;
+        for( size_t phase = 0; phase < sw; ++phase )
+        {
+            size_t runbeg     = 0;  //Word index of the first pointer of the current run
+            size_t runlast    = 0;  //Word index of the last pointer of the current run
+            size_t nbptrs     = 0;
+            size_t nbnulls    = 0;  //Consecutive nulls since the last pointer
+
+            auto lambdaEndRun = [&]()
+            {
+                if( nbptrs >= minentries )
+                {
+                    size_t nbentries = ((runlast - runbeg) / sw) + 1;
+                    if( !IsPointerArray( kinds, runbeg, sw, nbentries ) )
+                    {
+                        FoundLUT lut;
+                        lut.ptrcolumn = static_cast<uint32_t>(runbeg * 4);
+                        lut.stride    = stride;
+                        lut.nbentries = nbentries;
+                        found.push_back(lut);
+                    }
+                }
+                nbptrs  = 0;
+                nbnulls = 0;
+            };
+
+            for( size_t iw = phase; iw < kinds.size(); iw += sw )
+            {
+                switch( kinds[iw] )
+                {
+                    case eWordKind::Pointer:
+                    {
+                        if( nbptrs == 0 )
+                            runbeg = iw;
+                        runlast = iw;
+                        ++nbptrs;
+                        nbnulls = 0;
+                        break;
+                    }
+                    case eWordKind::Null:
+                    {
+                        if( nbptrs != 0 && ++nbnulls > MaxConsecutiveNulls )
+                            lambdaEndRun();
+                        break;
+                    }
+                    default:
+                    {
+                        lambdaEndRun();
+                    }
+                };
+            }
+            lambdaEndRun();
+        }
+    }
+
+    std::sort( found.begin(), found.end(), []( const FoundLUT & a, const FoundLUT & b ){ return a.ptrcolumn < b.ptrcolumn; } );
+    return found;
+}
+
+
+/*
+    LUTLocator
+        Finds where each table is in a single image.
+        Tables that are at their known location are used as-is. Otherwise, the image is scanned once,
+        and the scanned table with the same layout that's the closest to the known location is used.
+        "pknown" optionally lists the locations of the tables in the image's build, which replace
+        the known locations passed to Locate() for the tables it names. It must outlive the locator.
+*/
+class LUTLocator
+{
+public:
+    LUTLocator( const uint8_t * beg, const uint8_t * end, uint32_t loadoffset, const std::vector<KnownLUT> * pknown = nullptr )
+        :m_beg(beg), m_end(end), m_loadoffset(loadoffset), m_pknown(pknown)
+    {}
+
+    LUTLocation Locate( const KnownLUT & known, size_t stride, size_t ptroffset )
+    {
+        return Locate( known.tblname, known.offset, known.nbentries, stride, ptroffset );
+    }
+
+    LUTLocation Locate( const std::string & tblname, uint32_t knownoffset, size_t knownnbentries, size_t stride, size_t ptroffset )
+    {
+        if( m_pknown != nullptr )
+        {
+            for( const KnownLUT & known : *m_pknown )
+            {
+                if( known.tblname != tblname )
+                    continue;
+                knownoffset    = known.offset;
+                knownnbentries = known.nbentries;
+                break;
+            }
+        }
+        if( IsValidTable( knownoffset, knownnbentries, stride, ptroffset ) )
+        {
+            LUTLocation loc;
+            loc.offset    = knownoffset;
+            loc.nbentries = knownnbentries;
+            return loc;
+        }
+
+        const FoundLUT * pbest    = nullptr;
+        uint32_t         bestdist = 0;
+        for( const FoundLUT & lut : Scan() )
+        {
+            if( lut.stride != stride || lut.ptrcolumn < ptroffset )
+                continue;
+            uint32_t lutbeg = static_cast<uint32_t>(lut.ptrcolumn - ptroffset);
+            uint32_t dist   = (lutbeg > knownoffset)? (lutbeg - knownoffset) : (knownoffset - lutbeg);
+            if( pbest == nullptr || dist < bestdist )
+            {
+                pbest    = &lut;
+                bestdist = dist;
+            }
+        }
+
+        if( pbest == nullptr )
+            throw std::runtime_error("LUTLocator::Locate(): Couldn't find the " + tblname + " in the file!");
+
+        LUTLocation loc;
+        loc.offset         = static_cast<uint32_t>(pbest->ptrcolumn - ptroffset);
+        loc.nbentries      = pbest->nbentries;
+        loc.bfallback      = true;
+        loc.expectedoffset = knownoffset;
+        {
+            std::lock_guard<std::mutex> lk(m_fallbackmtx);
+            m_fallbacks.push_back( LocatedLUT{ tblname, loc } );
+        }
+        return loc;
+    }
+
+    //The tables Locate() couldn't find where expected so far, for the caller to report. Thread safe.
+    std::vector<LocatedLUT> Fallbacks()const
+    {
+        std::lock_guard<std::mutex> lk(m_fallbackmtx);
+        return m_fallbacks;
+    }
+
+    //Address the image is loaded at, used to turn pointers into file offsets
+    inline uint32_t LoadOffset()const { return m_loadoffset; }
+
+    //The image the tables are located in
+    inline const uint8_t * ImageBeg()const { return m_beg; }
+    inline const uint8_t * ImageEnd()const { return m_end; }
+
+    //Scans once, even when the tables of the file are located from several threads
+    const std::vector<FoundLUT> & Scan()
+    {
+        std::call_once( m_scanonce, [this](){ m_found = ScanForLUTs( m_beg, m_end, m_loadoffset ); } );
+        return m_found;
+    }
+
+    /*
+        A table is valid when it fits in the file, and all its pointers are either null or lead to a
+        null terminated string in the file. Known locations aren't guessed, so unlike the scan, their
+        strings may be empty or hold anything FetchString() can read.
+    */
+    bool IsValidTable( uint32_t offset, size_t nbentries, size_t stride, size_t ptroffset )const
+    {
+        const size_t imgsize = static_cast<size_t>(m_end - m_beg);
+        if( (offset % 4) != 0 || (offset + (nbentries * stride)) > imgsize )
+            return false;
+
+        for( size_t i = 0; i < nbentries; ++i )
+        {
+            uint32_t ptr = lutscan::ReadWordLE( m_beg + offset + (i * stride) + ptroffset );
+            if( ptr != 0 && ( (ptr - m_loadoffset) >= imgsize || !lutscan::IsStringAt( m_beg, imgsize, ptr - m_loadoffset ) ) )
+                return false;
+        }
+        return true;
+    }
+
+private:
+    const uint8_t *               m_beg;
+    const uint8_t *               m_end;
+    uint32_t                      m_loadoffset;
+    const std::vector<KnownLUT> * m_pknown;
+    std::once_flag                m_scanonce;
+    std::vector<FoundLUT>         m_found;
+    mutable std::mutex            m_fallbackmtx;
+    std::vector<LocatedLUT>       m_fallbacks;
+};
+
+#endif
@@ -10,626 +10,2310 @@
 #include <cstdint>
 #include <cassert>
 #include <map>
+#include <unordered_map>
+#include <tuple>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include "eventtables.hpp"
+#include "threadpool.hpp"
+#include "lutscanner.hpp"
+#include "ndsrom.hpp"
+#include "blz.hpp"
+#include "symbolindex.hpp"
+#include "tablediff.hpp"
+#include "tablepatch.hpp"
+#include "scriptindex.hpp"
+#include "tablejoin.hpp"
+#include "filewatcher.hpp"
+#include "buildprofiles.hpp"
+#include "tablestore.hpp"
+#include "coverage.hpp"
+#include "profiler.hpp"
 using namespace std;
+namespace fs = std::filesystem;
 
-const uint32_t Overlay_0011LoadOffset = 0x022DC240;
-const uint32_t Arm9BinLoadOffset      = 0x02000000;
+// ----------------------------------------------------------------------------------------
+/*
+    DumpOptions
+        How the dumps are written.
+*/
+struct DumpOptions
+{
+    eOutFmt               fmt        = eOutFmt::Text;
+    bool                  busecache  = true;    //Reuse the output of unchanged tables from the previous run. Text only.
+    ThreadPool *          ptablepool = nullptr; //Pool to dump files and tables on in parallel, or null to dump them in order
+    OutputFiles *         pfiles     = nullptr; //Where the output files go, or null to write them straight to disk
+    const BuildDatabase * pbuilds    = nullptr; //Builds to identify the binaries against, or null for the bundled ones only
+    TableStore *          pstore     = nullptr; //Store to put the text of the tables in, with a manifest per binary, or null to write whole dumps
+    BufferPool *          pbuffers   = nullptr; //Decompression buffers reused from one dump to the next, or null to allocate them per dump
+};
+
+//Sub-directory of the output directory where the dump caches are kept
+const string DumpCacheDir = ".pmd2cache";
 
-template<typename _intty>
-    string NumberToHexString( _intty val )
+//Load address given for extracted binaries, which are loaded at their build's address
+const uint32_t LoadOffsetOfBuild = 0;
+
+// ----------------------------------------------------------------------------------------
+/*
+    DecompressArm9IfNeeded
+        If the arm9 binary is BLZ compressed, decompresses it into "buffer" and returns the decompressed
+        binary. Otherwise returns the binary as-is.
+        "buffer" is only ever grown, so reusing it for several files doesn't allocate.
+*/
+ByteRange DecompressArm9IfNeeded( ByteRange bin, uint32_t ramaddr, vector<uint8_t> & buffer )
 {
-    stringstream sstr; 
-    sstr <<hex <<"0x" <<uppercase <<val;
-    return std::move(sstr.str());
+    const size_t compend = BLZFindArm9CompressedEnd( bin.begin(), bin.size(), ramaddr );
+    if( compend == 0 )
+        return bin;
+    if( !BLZIsCompressed( bin.begin(), compend ) )
+        throw runtime_error("DecompressArm9IfNeeded(): The arm9 claims to be compressed, but has no valid BLZ footer!");
+
+    //Anything past the compressed part is copied as-is
+    const size_t declen  = BLZDecompressedSize( bin.begin(), compend );
+    const size_t taillen = bin.size() - compend;
+    if( buffer.size() < (declen + taillen) )
+        buffer.resize( declen + taillen );
+    BLZDecompress( bin.begin(), compend, buffer.data(), declen );
+    std::copy( bin.begin() + compend, bin.end(), buffer.begin() + declen );
+    return ByteRange{ buffer.data(), buffer.data() + declen + taillen };
 }
 
 /*
-    A little tool to gather statistics on values
+    DecompressOverlayIfNeeded
+        If the overlay ends with a BLZ footer, decompresses it into "buffer" and returns the decompressed
+        overlay. Otherwise returns the overlay as-is.
 */
-template<class T>
-    struct LimitVal
+ByteRange DecompressOverlayIfNeeded( ByteRange bin, vector<uint8_t> & buffer )
 {
-    typedef T val_t;
-    val_t min;
-    val_t avg;
-    val_t max;
-    int   cntavg; //Counts nb of value samples
-    int   accavg; //Accumulate values
-    map<val_t,size_t> distribution; 
+    if( !BLZIsCompressed( bin.begin(), bin.size() ) )
+        return bin;
+
+    const size_t declen = BLZDecompressedSize( bin.begin(), bin.size() );
+    if( buffer.size() < declen )
+        buffer.resize( declen );
+    BLZDecompress( bin.begin(), bin.size(), buffer.data(), declen );
+    return ByteRange{ buffer.data(), buffer.data() + declen };
+}
 
-    LimitVal()
-        :min(0), avg(0), max(0), cntavg(0), accavg(0)
-    {}
+// ----------------------------------------------------------------------------------------
+/*
+    UnpackArm9 / UnpackOverlay
+        Returns the binary ready to be parsed, decompressing it into "decompbuf" if needed.
+        The buffer is the caller's, and must outlive the parsing of the binary.
+*/
+ByteRange UnpackArm9( const uint8_t * itbeg, const uint8_t * itend, uint32_t loadoffset, vector<uint8_t> & decompbuf )
+{
+    PMD2_PROF_TIME(Unpack);
+    return DecompressArm9IfNeeded( ByteRange{ itbeg, itend }, loadoffset, decompbuf );
+}
+
+ByteRange UnpackOverlay( const uint8_t * itbeg, const uint8_t * itend, vector<uint8_t> & decompbuf )
+{
+    PMD2_PROF_TIME(Unpack);
+    return DecompressOverlayIfNeeded( ByteRange{ itbeg, itend }, decompbuf );
+}
 
-    void Process(val_t anotherval )
+/*
+    WarnLUTFallbacks
+        Warns about each table that wasn't where the binary's build keeps it, and was replaced by
+        the closest table scanning the binary found.
+*/
+void WarnLUTFallbacks( const vector<LocatedLUT> & fallbacks )
+{
+    for( const LocatedLUT & fallback : fallbacks )
     {
-        if( anotherval < min )
-            min = anotherval;
-        else if( anotherval > max )
-            max = anotherval;
+        const string warning = "<!>- Warning: The " + fallback.tblname + " isn't at " + NumberToHexString(fallback.loc.expectedoffset)
+                             + ", using the table found at " + NumberToHexString(fallback.loc.offset) + " instead!\n";
+        cerr <<warning;
+    }
+}
 
-        ++cntavg;
-        accavg += anotherval;
-        avg = static_cast<val_t>(accavg / cntavg);
+/*
+    ParseArm9Tables / ParseOverlay0011Tables
+        Decodes the tables of an unpacked binary, loaded at "loadoffset", into any output sink.
+        With a pool, the tables are decoded in parallel when the sink supports it. Each table
+        only merges into its own member of "pstats". "pknown" lists where the binary's build
+        keeps the tables, if it's not known to keep them at the Explorers of Sky (NA) locations.
+        Tables found by scanning instead are warned about.
+*/
+template<typename _sinkTy>
+    void ParseArm9Tables( ByteRange bin, uint32_t loadoffset, _sinkTy & out, TablesStats * pstats, ThreadPool * ppool = nullptr, const vector<KnownLUT> * pknown = nullptr )
+{
+    LUTLocator                  locator( bin.begin(), bin.end(), loadoffset, pknown );
+    OrderedTableWriter<_sinkTy> tables( out, ppool );
+    tables.Add( [&]( auto & tblout )
+    {
+        auto entitysymstats = DumpEntitySymbolsEoS( bin.begin(), bin.end(), tblout, locator );
+        if( pstats != nullptr )
+            pstats->entitysymbols.Merge( entitysymstats );
+    });
+    tables.Add( [&]( auto & tblout )
+    {
+        auto eventsstats = DumpEventListEoS( bin.begin(), bin.end(), tblout, locator );
+        if( pstats != nullptr )
+            pstats->events.Merge( eventsstats );
+    });
+    tables.Finish();
+    WarnLUTFallbacks( locator.Fallbacks() );
+    if( pstats != nullptr )
+        ++(pstats->nbarm9);
+}
 
-        
-        auto result = distribution.try_emplace( anotherval, 1 );
-        if( !result.second && (result.first != distribution.end()) )
-        {
-            (result.first->second) += 1;
-        }
-    }
+template<typename _sinkTy>
+    void ParseOverlay0011Tables( ByteRange bin, uint32_t loadoffset, _sinkTy & out, TablesStats * pstats, ThreadPool * ppool = nullptr, const vector<KnownLUT> * pknown = nullptr )
+{
+    LUTLocator                  locator( bin.begin(), bin.end(), loadoffset, pknown );
+    OrderedTableWriter<_sinkTy> tables( out, ppool );
+    tables.Add( [&]( auto & tblout )
+    {
+        auto eventsubstats = DumpEventSubFileListEoS( bin.begin(), bin.end(), tblout, locator );
+        if( pstats != nullptr )
+            pstats->eventsubfiles.Merge( eventsubstats );
+    });
+    tables.Add( [&]( auto & tblout )
+    {
+        auto specialstats = DumpSpecialListEoS( bin.begin(), bin.end(), tblout, locator );
+        if( pstats != nullptr )
+            pstats->specials.Merge( specialstats );
+    });
+    tables.Finish();
+    WarnLUTFallbacks( locator.Fallbacks() );
+    if( pstats != nullptr )
+        ++(pstats->nboverlay11);
+}
+
+//The builds the binaries of a dump are identified against
+inline const BuildDatabase & Builds( const DumpOptions & opts )
+{
+    return (opts.pbuilds != nullptr)? *opts.pbuilds : BundledBuilds();
+}
 
-    std::string Print()const
+/*
+    ExtractedGameCode
+        The game code of an extracted binary, from the header.bin ndstool extracts next to arm9.bin.
+        Overlays are extracted into a sub-directory, so its parent is looked into too.
+        Returns an empty string if there's no header.
+*/
+string ExtractedGameCode( const string & binpath )
+{
+    const fs::path bindir = fs::path(binpath).parent_path();
+    for( const fs::path & hdrpath : { bindir / "header.bin", bindir.parent_path() / "header.bin" } )
     {
-        std::stringstream sstr;
-        sstr <<"(" << static_cast<int>( min ) <<" to " <<static_cast<int>( max ) <<" ) Avg : " <<avg <<"\n\tDistribution with more than one match:\n";
-        for( const auto distent : distribution )
-        {
-            if( distent.second > 1 )
-                sstr<<"\t\tVal: " <<setw(8) <<setfill(' ') <<distent.first <<" : " <<setw(8) <<setfill(' ') <<distent.second <<" times\n";
-        }
-        return std::move( sstr.str() );
+        std::error_code ec;
+        const uintmax_t hdrsize = fs::file_size( hdrpath, ec );
+        if( ec || hdrsize < NdsRom::HeaderLen )
+            continue;
+        ifstream hdr( hdrpath, std::ios::in | std::ios::binary );
+        char     gamecode[4];
+        if( hdr.seekg( NdsRom::OffsGameCode ) && hdr.read( gamecode, sizeof(gamecode) ) )
+            return string( gamecode, sizeof(gamecode) );
     }
+    return string();
+}
+
+/*
+    SelectBuild
+        Identifies the build a single unpacked binary comes from, to know where its tables are.
+*/
+const BuildProfile & SelectBuild( const BuildDatabase & builds, const string & gamecode, eBuildBinary binary, ByteRange bin, uint32_t loadoffset )
+{
+    return *( builds.Identify( gamecode, { BuildImage{ binary, bin, loadoffset } } ).pprofile );
+}
+
+/*
+    UnpackedBinary
+        A binary ready to be parsed, with the build it was identified as, and its load address.
+*/
+struct UnpackedBinary
+{
+    ByteRange            bin;
+    uint32_t             loadoffset = 0;
+    const BuildProfile * pbuild     = nullptr;
 };
 
+/*
+    UnpackArm9Binary / UnpackOverlay0011Binary
+        Unpacks a binary as it's stored, and identifies its build. "loadoffset" and "gamecode" come
+        from the ROM header, or are LoadOffsetOfBuild and the game code of header.bin, if any, for
+        extracted binaries, which are loaded at their build's address. Extracted arm9 binaries are
+        unpacked assuming the usual load address, since that's needed before the build is known.
+*/
+UnpackedBinary UnpackArm9Binary( ByteRange data, uint32_t loadoffset, const string & gamecode, const BuildDatabase & builds, vector<uint8_t> & decompbuf )
+{
+    const ByteRange      bin   = UnpackArm9( data.begin(), data.end(), (loadoffset != LoadOffsetOfBuild)? loadoffset : Arm9BinLoadOffset, decompbuf );
+    const BuildProfile & build = SelectBuild( builds, gamecode, eBuildBinary::Arm9, bin, loadoffset );
+    return UnpackedBinary{ bin, (loadoffset != LoadOffsetOfBuild)? loadoffset : build.arm9loadoffset, &build };
+}
 
-/*********************************************************************************************
-    ReadIntFromBytes
-        Tool to read integer values from a byte vector!
-        ** The iterator's passed as input, has its position changed !!
-*********************************************************************************************/
-template<class T, class _init> 
-    inline T ReadIntFromBytes( _init & itin, _init itend, bool basLittleEndian = true )
+UnpackedBinary UnpackOverlay0011Binary( ByteRange data, uint32_t loadoffset, const string & gamecode, const BuildDatabase & builds, vector<uint8_t> & decompbuf )
 {
-    static_assert( std::numeric_limits<T>::is_integer, "ReadIntFromBytes() : Type T is not an integer!" );
-    T out_val = 0;
+    const ByteRange      bin   = UnpackOverlay( data.begin(), data.end(), decompbuf );
+    const BuildProfile & build = SelectBuild( builds, gamecode, eBuildBinary::Overlay11, bin, loadoffset );
+    return UnpackedBinary{ bin, (loadoffset != LoadOffsetOfBuild)? loadoffset : build.overlay11loadoffset, &build };
+}
 
-    if( basLittleEndian )
-    {
-        unsigned int i = 0;
-        for( ; (itin != itend) && (i < sizeof(T)); ++i, ++itin )
-        {
-            T tmp = (*itin);
-            out_val |= ( tmp << (i * 8) ) & ( 0xFF << (i*8) );
-        }
+/*
+    ParseArm9Binary / ParseOverlay0011Binary
+        Unpacks a binary as it's stored, identifies its build, and decodes its tables at the build's
+        locations. "loadoffset" and "gamecode" are as for UnpackArm9Binary().
+*/
+template<typename _sinkTy>
+    void ParseArm9Binary( ByteRange data, uint32_t loadoffset, const string & gamecode, const BuildDatabase & builds, vector<uint8_t> & decompbuf,
+                          _sinkTy & out, TablesStats * pstats, ThreadPool * ppool = nullptr )
+{
+    const UnpackedBinary unpacked = UnpackArm9Binary( data, loadoffset, gamecode, builds, decompbuf );
+    ParseArm9Tables( unpacked.bin, unpacked.loadoffset, out, pstats, ppool, &unpacked.pbuild->arm9luts );
+}
 
-        if( i != sizeof(T) )
-        {
-#ifdef _DEBUG
-            assert(false);
-#endif
-            throw std::runtime_error( "ReadIntFromBytes(): Not enough bytes to read from the source container!" );
-        }
-    }
-    else
+template<typename _sinkTy>
+    void ParseOverlay0011Binary( ByteRange data, uint32_t loadoffset, const string & gamecode, const BuildDatabase & builds, vector<uint8_t> & decompbuf,
+                                 _sinkTy & out, TablesStats * pstats, ThreadPool * ppool = nullptr )
+{
+    const UnpackedBinary unpacked = UnpackOverlay0011Binary( data, loadoffset, gamecode, builds, decompbuf );
+    ParseOverlay0011Tables( unpacked.bin, unpacked.loadoffset, out, pstats, ppool, &unpacked.pbuild->overlay11luts );
+}
+
+/*
+    DumpCachePath / DumpFileHash
+        Where the dump cache of the "basename" binary is kept, and the hash of everything its
+        dump depends on, to compare against the cache's. With signature files loaded, the build
+        picked may change with them and with the game code, so they're part of the hash.
+*/
+inline string DumpCachePath( const string & targetdir, const string & basename )
+{
+    return targetdir + "/" + DumpCacheDir + "/" + basename + ".pmd2cache";
+}
+
+inline uint64_t DumpFileHash( const uint8_t * itbeg, const uint8_t * itend, uint32_t loadoffset, const string & gamecode, const BuildDatabase & builds )
+{
+    XXH64State filestate;
+    filestate.Update( itbeg, static_cast<size_t>(itend - itbeg) );
+    filestate.UpdateInt( loadoffset );
+    const uint64_t buildshash = builds.Fingerprint();
+    if( buildshash != 0 )
     {
-        int i = (sizeof(T)-1);
-        for( ; (itin != itend) && (i >= 0); --i, ++itin )
-        {
-            T tmp = (*itin);
-            out_val |= ( tmp << (i * 8) ) & ( 0xFF << (i*8) );
-        }
+        filestate.UpdateInt( buildshash );
+        filestate.Update( gamecode.data(), gamecode.size() );
+    }
+    return filestate.Digest();
+}
 
-        if( i != -1 )
-        {
-#ifdef _DEBUG
-            assert(false);
-#endif
-            throw std::runtime_error( "ReadIntFromBytes(): Not enough bytes to read from the source container!" );
-        }
+/*
+    DumpTablesCached
+        Writes the text dump of the "basename" binary through its dump cache in "targetdir".
+        If "filehash", from DumpFileHash(), is the same as last run, the cached output is
+        written back without calling "parse( sink )" at all.
+*/
+template<class _ParseFunTy>
+    void DumpTablesCached( uint64_t filehash, const string & targetdir, const string & basename, OutputFiles & files, _ParseFunTy && parse )
+{
+    const string   cachepath = DumpCachePath( targetdir, basename );
+
+    DumpCache oldcache;
+    const bool bunchanged = oldcache.Load(cachepath) && oldcache.FileHash() == filehash;
+    ostream &  out = files.Open( targetdir + "/" + basename + ".txt" );
+    if( bunchanged )
+    {
+        PMD2_PROF_TIME(Finish);
+        for( const auto & chunk : oldcache.Chunks() )
+            out << chunk.text;
+        PMD2_PROF_COUNT( BytesWritten, out.tellp() );
+        files.Close(out);
+        return;
     }
-    return out_val;
+
+    DumpCache      newcache(filehash);
+    CachedTextSink sink( out, oldcache, newcache );
+    parse(sink);
+    PMD2_PROF_TIME(Finish);
+    sink.Finish();
+    PMD2_PROF_COUNT( BytesWritten, out.tellp() );
+    files.Close(out);
+    newcache.Save(cachepath);
 }
 
-/*********************************************************************************************
-    ReadIntFromBytes
-        Tool to read integer values from a byte container!
-            
-        #NOTE :The iterator is passed by copy here !! And the incremented iterator is returned!
-*********************************************************************************************/
-template<class T, class _init> 
-    inline _init ReadIntFromBytes( T & dest, _init itin, _init itend, bool basLittleEndian = true ) 
+/*
+    DumpTablesStored
+        Writes the tables of the "basename" binary into the table store, and the manifest of the
+        tables its dump is made of into "targetdir". With "pstats", every table is decoded for its
+        stats, even those already stored.
+*/
+template<class _ParseFunTy>
+    void DumpTablesStored( TableStore & store, const string & targetdir, const string & basename, OutputFiles & files, const TablesStats * pstats, _ParseFunTy && parse )
 {
-    dest = ReadIntFromBytes<typename T, typename _init>( itin, itend, basLittleEndian );
-    return itin;
+    ostream &      out = files.Open( targetdir + "/" + basename + ".manifest" );
+    StoredTextSink sink( store, &out, pstats != nullptr );
+    parse(sink);
+    PMD2_PROF_TIME(Finish);
+    sink.Finish();
+    PMD2_PROF_COUNT( BytesWritten, out.tellp() );
+    files.Close(out);
 }
 
+void PrintStoreSummary( ostream & out, const TableStore & store )
+{
+    out <<"Dumped " <<store.NbReferences() <<" table(s) into " <<store.RootDir() <<", " <<store.NbWritten() <<" new, "
+        <<store.NbExisting() <<" stored before.\n";
+}
 
-/************************************************************************************
-    safestrlen
-        Count the length of a string, and has a iterator check
-        to ensure it won't loop into infinity if it can't find a 0.
-************************************************************************************/
-template<typename init_t>
-    inline size_t safestrlen( init_t beg, init_t pastend )
+//The cache only holds text, and skipped tables have no stats to contribute
+inline bool UseDumpCache( const DumpOptions & opts, const TablesStats * pstats )
 {
-    size_t cntchar = 0;
-    for(; beg != pastend && (*beg) != 0; ++cntchar, ++beg );
+    return opts.busecache && opts.fmt == eOutFmt::Text && pstats == nullptr;
+}
 
-    if( beg == pastend )
-        throw runtime_error("String went past expected end!");
+/*
+    DumpArm9Tables
+        Dumps the tables of an arm9 binary, loaded at "loadoffset", into "targetdir".
+        The binary is decompressed first if needed. "loadoffset" and "gamecode" are as for ParseArm9Binary().
+*/
+void DumpArm9Tables( const uint8_t * itbeg, const uint8_t * itend, uint32_t loadoffset, const string & gamecode, const string & targetdir, const DumpOptions & opts, TablesStats * pstats )
+{
+    PMD2_PROF_SCOPE("arm9");
+    BufferPool        ownbuffers;
+    BufferPool::Lease decomp    = ((opts.pbuffers != nullptr)? *opts.pbuffers : ownbuffers).Borrow();
+    vector<uint8_t> & decompbuf = decomp.Buffer();
+    auto lambdaParse = [&]( auto & out ){ ParseArm9Binary( ByteRange{ itbeg, itend }, loadoffset, gamecode, Builds(opts), decompbuf, out, pstats, opts.ptablepool ); };
+    OutputFiles   directfiles;
+    OutputFiles & files = (opts.pfiles != nullptr)? *opts.pfiles : directfiles;
+    if( opts.pstore != nullptr )
+        DumpTablesStored( *opts.pstore, targetdir, "arm9", files, pstats, lambdaParse );
+    else if( UseDumpCache( opts, pstats ) )
+        DumpTablesCached( DumpFileHash( itbeg, itend, loadoffset, gamecode, Builds(opts) ), targetdir, "arm9", files, lambdaParse );
+    else
+        WithOutputSink( opts.fmt, targetdir, "arm9", files, lambdaParse );
+}
 
-    return cntchar;
+/*
+    DumpOverlay0011Tables
+        Dumps the tables of overlay 11, loaded at "loadoffset", into "targetdir".
+        The binary is decompressed first if needed. "loadoffset" and "gamecode" are as for ParseOverlay0011Binary().
+*/
+void DumpOverlay0011Tables( const uint8_t * itbeg, const uint8_t * itend, uint32_t loadoffset, const string & gamecode, const string & targetdir, const DumpOptions & opts, TablesStats * pstats )
+{
+    PMD2_PROF_SCOPE("overlay_0011");
+    BufferPool        ownbuffers;
+    BufferPool::Lease decomp    = ((opts.pbuffers != nullptr)? *opts.pbuffers : ownbuffers).Borrow();
+    vector<uint8_t> & decompbuf = decomp.Buffer();
+    auto lambdaParse = [&]( auto & out ){ ParseOverlay0011Binary( ByteRange{ itbeg, itend }, loadoffset, gamecode, Builds(opts), decompbuf, out, pstats, opts.ptablepool ); };
+    OutputFiles   directfiles;
+    OutputFiles & files = (opts.pfiles != nullptr)? *opts.pfiles : directfiles;
+    if( opts.pstore != nullptr )
+        DumpTablesStored( *opts.pstore, targetdir, "overlay_0011", files, pstats, lambdaParse );
+    else if( UseDumpCache( opts, pstats ) )
+        DumpTablesCached( DumpFileHash( itbeg, itend, loadoffset, gamecode, Builds(opts) ), targetdir, "overlay_0011", files, lambdaParse );
+    else
+        WithOutputSink( opts.fmt, targetdir, "overlay_0011", files, lambdaParse );
 }
 
-/************************************************************************************
-    FetchString
-        Fetchs a null terminated C-String from a file offset.
-************************************************************************************/
-template<typename _init>
-    std::string FetchString( uint32_t fileoffset, _init itfbeg, _init itfend )
+void DumpArm9Stuff( const string & arm9path, const string & targetdir, const DumpOptions & opts = DumpOptions(), TablesStats * pstats = nullptr )
 {
-    auto    itstr = itfbeg;
-    std::advance( itstr,  fileoffset );
-    size_t  strlength = safestrlen(itstr, itfend);
-    string  dest;
-    dest.resize(strlength);
+    PMD2_PROF_SCOPE("arm9");
+    MappedFile fdat( LoadFile(arm9path) );
+    DumpArm9Tables( fdat.begin(), fdat.end(), LoadOffsetOfBuild, ExtractedGameCode(arm9path), targetdir, opts, pstats );
+}
 
-    for( size_t cntchar = 0; cntchar < strlength; ++cntchar, ++itstr )
-        dest[cntchar] = (*itstr);
 
-    return std::move(dest);
+void DumpOverlay0011Stuff( const string & overlay11path, const string & targetdir, const DumpOptions & opts = DumpOptions(), TablesStats * pstats = nullptr )
+{
+    PMD2_PROF_SCOPE("overlay_0011");
+    MappedFile fdat( LoadFile(overlay11path) );
+    DumpOverlay0011Tables( fdat.begin(), fdat.end(), LoadOffsetOfBuild, ExtractedGameCode(overlay11path), targetdir, opts, pstats );
 }
 
-
-/************************************************************************************
-    LoadFile
-        Load a file into a byte vector for easier parsing.
-************************************************************************************/
-std::vector<uint8_t> LoadFile( const std::string & fpath )
+/*
+    DumpNdsRomImage / DumpNdsRomStuff
+        Dumps the arm9 and overlay 11 tables straight from a NDS ROM image, either already
+        mapped, or loaded from "rompath".
+        The binaries are parsed in place inside the mapped ROM, and their load
+        addresses come from the ROM's header and overlay table.
+*/
+void DumpNdsRomImage( const MappedFile & fdat, const string & rompath, const string & targetdir, const DumpOptions & opts, TablesStats * pstats )
 {
-    ifstream fi( fpath, ios::binary );
-    if( fi.bad() || !(fi.is_open()) )
-        throw std::runtime_error("Couldn't open file " + fpath);
+    NdsRom         rom( fdat.begin(), fdat.end() );
+    ByteRange      arm9  = rom.Arm9();
+    NdsOverlayInfo ovl11 = rom.Overlay(11);
+
+    if( ovl11.bcompressed && !BLZIsCompressed( ovl11.data.begin(), ovl11.data.size() ) )
+        throw runtime_error("DumpNdsRomStuff(): Overlay 11 in " + rompath + " is flagged as compressed, but has no valid BLZ footer!");
+
+    const string gamecode = rom.GameCode();
+    TaskGroup    files( opts.ptablepool );
+    files.Run( [&](){ DumpArm9Tables       ( arm9.begin(),       arm9.end(),       rom.Arm9RamAddress(), gamecode, targetdir, opts, pstats ); } );
+    files.Run( [&](){ DumpOverlay0011Tables( ovl11.data.begin(), ovl11.data.end(), ovl11.ramaddr,        gamecode, targetdir, opts, pstats ); } );
+    files.Wait();
+}
 
-    return std::move( std::vector<uint8_t>( istreambuf_iterator<char>(fi), istreambuf_iterator<char>()) );
+void DumpNdsRomStuff( const string & rompath, const string & targetdir, const DumpOptions & opts = DumpOptions(), TablesStats * pstats = nullptr )
+{
+    PMD2_PROF_SCOPE("rom");
+    MappedFile fdat( LoadFile(rompath) );
+    DumpNdsRomImage( fdat, rompath, targetdir, opts, pstats );
 }
 
-//============================================================================================================
 
-template<typename _structType, typename _init, typename _outstrm>
-    void ParseAndDumpLUT( const uint32_t offset, const size_t nbentries, _init itbeg, _init itend, _outstrm & out, const string & headertext, const uint32_t ptrDiff )
+/*
+    ReportFoundLUTs
+        Prints every table the scanner finds in a binary, along with the time the scan took.
+*/
+void ReportFoundLUTs( const string & fpath, uint32_t loadoffset )
 {
-    typename _structType::Stats statisticslog;
-    auto                        itfbeg        = itbeg; //Save iterator before advancing it
-    std::advance( itbeg, offset );
+    MappedFile fdat( LoadFile(fpath) );
+    auto       tstart = chrono::steady_clock::now();
+    auto       luts   = ScanForLUTs( fdat.begin(), fdat.end(), loadoffset );
+    auto       tend   = chrono::steady_clock::now();
+
+    cout <<fpath <<" : " <<luts.size() <<" table(s) found in " 
+         <<chrono::duration_cast<chrono::microseconds>(tend - tstart).count() <<" us\n"
+         <<"    1st Pointer  Stride  Entries\n";
+    for( const FoundLUT & lut : luts )
+    {
+        cout <<"    0x" <<setfill('0') <<setw(8) <<right <<uppercase <<hex <<lut.ptrcolumn <<nouppercase <<dec
+             <<"  " <<setfill(' ') <<setw(6) <<lut.stride
+             <<"  " <<setfill(' ') <<setw(7) <<lut.nbentries <<"\n";
+    }
+}
 
-    out << "============================================================\n"
-        << headertext <<"\n"
-        << "============================================================\n"
-        << "\n"
-        << "Offset       ";
-    _structType::PrintHeader(out);
-    out << "\n--------------------------------------------------------------------------------------\n";
 
-    for( size_t cntentries = 0; cntentries < nbentries; ++cntentries )
+/*
+    BenchmarkBLZ
+        Measures how fast a binary decompresses. If the binary isn't compressed, it's
+        compressed in memory first, and the round trip is checked.
+*/
+void BenchmarkBLZ( const string & fpath )
+{
+    MappedFile      fdat( LoadFile(fpath) );
+    vector<uint8_t> compressed;
+    const uint8_t * psrc   = fdat.begin();
+    size_t          srclen = fdat.size();
+    if( !BLZIsCompressed( psrc, srclen ) )
     {
-        _structType curentry;
-        itbeg = curentry.Read( itbeg, itend );
-        out << "0x" <<setfill('0') <<setw(8) <<right <<uppercase <<hex <<((cntentries * _structType::Size) + offset) <<nouppercase <<" " <<dec;
-        curentry.Print( out, itfbeg, itend, ptrDiff );
-        statisticslog.LogStats(curentry);
+        compressed = BLZCompress( fdat.begin(), fdat.size() );
+        if( compressed.empty() )
+            throw runtime_error("BenchmarkBLZ(): " + fpath + " doesn't compress!");
+        psrc   = compressed.data();
+        srclen = compressed.size();
     }
-    out <<"\n"
-        <<"Stats:\n"
-        <<"------------\n"
-        <<statisticslog.Print()
-        <<"\n";
-}
 
+    vector<uint8_t> decompressed( BLZDecompressedSize( psrc, srclen ) );
+    BLZDecompress( psrc, srclen, decompressed.data(), decompressed.size() );
+    if( !compressed.empty() && !std::equal( decompressed.begin(), decompressed.end(), fdat.begin(), fdat.end() ) )
+        throw runtime_error("BenchmarkBLZ(): The decompressed data doesn't match the original!");
 
+    //Run for at least a second
+    size_t nbruns = 0;
+    auto   tstart = chrono::steady_clock::now();
+    auto   tcur   = tstart;
+    do
+    {
+        BLZDecompress( psrc, srclen, decompressed.data(), decompressed.size() );
+        ++nbruns;
+        tcur = chrono::steady_clock::now();
+    }while( (tcur - tstart) < chrono::seconds(1) );
+
+    const double secs = chrono::duration<double>(tcur - tstart).count();
+    cout <<fpath <<" : " <<srclen <<" -> " <<decompressed.size() <<" bytes, "
+         <<nbruns <<" runs, " <<fixed <<setprecision(1)
+         <<( (static_cast<double>(decompressed.size()) * nbruns) / (secs * 1024.0 * 1024.0) ) <<" MB/s decompressed\n";
+}
 
 
-// ----------------------------------------------------------------------------------------
+//=============================================================================================================
+//  Query Mode
+//=============================================================================================================
 /*
-    LevelEntry
-        Single entry in the level list
+    IndexSink
+        Output sink that adds every decoded row to a SymbolIndex instead of writing it out.
 */
-struct LevelEntry
+class IndexSink
 {
-    uint32_t ptrstring  = 0;
-    int16_t  unk1       = 0;
-    int16_t  unk2       = 0;
-    int16_t  unk3       = 0;
-    int16_t  unk4       = 0;
-
-    static const size_t Size = 12;
+public:
+    explicit IndexSink( SymbolIndex & index )
+        :m_index(index), m_curtable(0)
+    {}
 
-    template<typename _init>
-        _init Read( _init itbeg, _init itend )
+    template<class _EntryTy>
+        void BeginTable( const string & headertext, uint32_t, size_t )
     {
-        itbeg = ReadIntFromBytes( ptrstring,    itbeg, itend );
-        itbeg = ReadIntFromBytes( unk1,         itbeg, itend );
-        itbeg = ReadIntFromBytes( unk2,         itbeg, itend );
-        itbeg = ReadIntFromBytes( unk3,         itbeg, itend );
-        itbeg = ReadIntFromBytes( unk4,         itbeg, itend );
-        return itbeg;
+        vector<string> colnames;
+        ForEachField<_EntryTy>( [&colnames]( const auto & field, size_t ){ if( field.format != eFieldFmt::Symbol ) colnames.push_back( field.name ); } );
+        m_curtable = m_index.AddTable( MakeTableId(headertext), colnames );
     }
 
-    template<typename _outstrm, typename _init >
-        void Print( _outstrm & out, _init itfbeg, _init itfend, const uint32_t ptrDiff )
+    template<class _EntryTy>
+        void WriteRow( uint32_t rowoffset, const _EntryTy & entry, std::optional<std::string_view> symbol )
     {
-        string fetchedstr = "NULL";
-        if( ptrstring != 0 )
-            fetchedstr = FetchString( ptrstring - ptrDiff, itfbeg, itfend );
-
-        out << "-> " <<setfill(' ') <<setw(5) <<unk1
-            << ", "  <<setfill(' ') <<setw(5) <<unk2
-            << ", "  <<setfill(' ') <<setw(5) <<unk3         
-            << ", "  <<setfill(' ') <<setw(5) <<unk4
-            << ", \""  <<fetchedstr <<"\""
-            <<"\n";
+        m_values.clear();
+        ForEachField<_EntryTy>( [&]( const auto & field, size_t ){ if( field.format != eFieldFmt::Symbol ) m_values.push_back( static_cast<int64_t>( entry.*(field.member) ) ); } );
+        m_index.AddRow( m_curtable, rowoffset, m_values.data(), symbol );
     }
 
-    template<typename _outstrm>
-        static void PrintHeader( _outstrm & out )
+    template<class _EntryTy>
+        void EndTable( typename _EntryTy::Stats & )
+    {}
+
+    void Finish()
+    {}
+
+private:
+    SymbolIndex &   m_index;
+    uint32_t        m_curtable;
+    vector<int64_t> m_values;
+};
+
+/*
+    BuildSymbolIndex
+        Indexes the tables of a NDS ROM image if "ndspath" isn't empty, or of the extracted
+        arm9 and overlay 11 binaries otherwise. The binaries' build is identified against "builds".
+*/
+SymbolIndex BuildSymbolIndex( const string & ndspath, const string & arm9path, const string & overlay11path, const BuildDatabase & builds = BundledBuilds() )
+{
+    SymbolIndex     index;
+    IndexSink       sink(index);
+    vector<uint8_t> arm9buf;
+    vector<uint8_t> ovl11buf;
+    if( !ndspath.empty() )
+    {
+        MappedFile     fdat( LoadFile(ndspath) );
+        NdsRom         rom( fdat.begin(), fdat.end() );
+        ByteRange      arm9  = rom.Arm9();
+        NdsOverlayInfo ovl11 = rom.Overlay(11);
+        const string   gamecode = rom.GameCode();
+        ParseArm9Binary       ( arm9,       rom.Arm9RamAddress(), gamecode, builds, arm9buf,  sink, nullptr );
+        ParseOverlay0011Binary( ovl11.data, ovl11.ramaddr,        gamecode, builds, ovl11buf, sink, nullptr );
+    }
+    else
     {
-        out <<"Unk1   "
-            //"     5,"
-            <<"unk2   "
-            //"   342,"
-            <<"SomeId "
-            //"     0,"
-            <<"Unk4   "
-            //"   258,"
-            <<"Symbol "
-            ;
+        MappedFile arm9( LoadFile(arm9path) );
+        MappedFile ovl11( LoadFile(overlay11path) );
+        ParseArm9Binary       ( ByteRange{ arm9.begin(),  arm9.end() },  LoadOffsetOfBuild, ExtractedGameCode(arm9path),      builds, arm9buf,  sink, nullptr );
+        ParseOverlay0011Binary( ByteRange{ ovl11.begin(), ovl11.end() }, LoadOffsetOfBuild, ExtractedGameCode(overlay11path), builds, ovl11buf, sink, nullptr );
     }
+    return index;
+}
+
+/*
+    PrintIndexedRow
+        Ex: entity_symbol_list_table[12] @0xA8080 : type=0, entityid=12, unk3=47605, unk4=0, "E012"
+*/
+void PrintIndexedRow( ostream & out, const SymbolIndex & index, SymbolIndex::RowRef ref )
+{
+    const SymbolIndex::Table & tbl = index.Tables()[ref.table];
+    out <<tbl.name <<"[" <<ref.row <<"] @" <<NumberToHexString( tbl.offsets[ref.row] ) <<" :";
+    for( size_t i = 0; i < tbl.columns.size(); ++i )
+        out <<( (i == 0)? " " : ", " ) <<index.ColumnName( tbl.columns[i] ) <<"=" <<tbl.values[(ref.row * tbl.columns.size()) + i];
+
+    const uint32_t symid = tbl.symbols[ref.row];
+    if( symid == SymbolIndex::NoSymbol )
+        out <<", NULL\n";
+    else
+        out <<", \"" <<index.Symbol(symid) <<"\"\n";
+}
 
-    struct Stats
+/*
+    RunQueryLoop
+        Reads one query per line, until the end of the input or "quit":
+            <field>=<value>     Rows whose integer field has the value. Ex: entityid=12
+            <symbol>            Rows pointing at the symbol. Ex: D01P11A
+*/
+void RunQueryLoop( const SymbolIndex & index, istream & in, ostream & out )
+{
+    size_t nbrows = 0;
+    for( const auto & tbl : index.Tables() )
+        nbrows += tbl.NbRows();
+    out <<"Indexed " <<nbrows <<" rows and " <<index.NbSymbols() <<" distinct symbols from " <<index.Tables().size() <<" tables.\n"
+        <<"Queries: <field>=<value>, <symbol>, quit\n";
+
+    string line;
+    while( getline( in, line ) )
     {
-        void LogStats( const LevelEntry & entry )
+        if( !line.empty() && line.back() == '\r' )
+            line.pop_back();
+        if( line.empty() )
+            continue;
+        if( line == "quit" || line == "exit" )
+            break;
+
+        vector<SymbolIndex::RowRef> found;
+        auto         tstart = chrono::steady_clock::now();
+        const size_t eqpos  = line.find('=');
+        if( eqpos != string::npos )
         {
-            unk1stat.Process(entry.unk1);
-            unk2stat.Process(entry.unk2);
-            unk3stat.Process(entry.unk3);
-            unk4stat.Process(entry.unk4);
+            int64_t value = 0;
+            try
+            {
+                value = std::stoll( line.substr(eqpos + 1), nullptr, 0 );
+            }
+            catch( const std::exception & )
+            {
+                out <<"<!>- Invalid value in \"" <<line <<"\"\n";
+                continue;
+            }
+            found = index.FindValue( string_view(line).substr(0, eqpos), value );
         }
+        else
+            found = index.FindSymbol( line );
+        auto tend = chrono::steady_clock::now();
 
-        string Print()
-        {
-            stringstream sstr;
-            sstr<<"unk1   :" << unk1stat.Print() <<"\n"
-                <<"unk2   :" << unk2stat.Print() <<"\n"
-                <<"SomeId :" << unk3stat.Print() <<"\n"
-                <<"unk4   :" << unk4stat.Print() <<"\n"
-                ;
-            return std::move(sstr.str());
-        }
+        for( const auto & ref : found )
+            PrintIndexedRow( out, index, ref );
+        out <<found.size() <<" row(s) in " <<chrono::duration_cast<chrono::microseconds>(tend - tstart).count() <<" us\n";
+    }
+}
 
-        LimitVal<decltype(LevelEntry::unk1)> unk1stat;
-        LimitVal<decltype(LevelEntry::unk2)> unk2stat;
-        LimitVal<decltype(LevelEntry::unk3)> unk3stat;
-        LimitVal<decltype(LevelEntry::unk4)> unk4stat;
-    };
-};
 
-template<typename _init, typename _outstrm>
-    void DumpEventListEoS( _init itbeg, _init itend, _outstrm & out )
+//=============================================================================================================
+//  Batch Mode
+//=============================================================================================================
+/*
+    RomJob
+        Where to find the binaries of a single ROM, and where to dump them.
+        Either "ndspath" is set for a NDS ROM image, or the paths to the extracted binaries are.
+*/
+struct RomJob
 {
-    //arm9
-    //0x000A46EC -> Start of strings
-    //0x000A5490 -> Start of LUT. 12 bytes entries. 1 pointer, 4 shorts.
-    //0x000A68C4 -> One past end of LUT. 431 entries.
-    static const size_t   NbEntries = 431;
-    static const uint32_t LUTBeg    = 0xA5490;
+    string ndspath;
+    string arm9path;
+    string overlay11path;
+    string targetdir;
+};
 
-    ParseAndDumpLUT<LevelEntry>( LUTBeg, NbEntries, itbeg, itend, out, "Event List Table", Arm9BinLoadOffset );
+/*
+    IsNdsRomPath
+        Whether the path is a file with the ".nds" extension.
+*/
+bool IsNdsRomPath( const fs::path & fpath )
+{
+    string ext = fpath.extension().string();
+    std::transform( ext.begin(), ext.end(), ext.begin(), []( unsigned char c ){ return static_cast<char>( tolower(c) ); } );
+    std::error_code ec;
+    return ext == ".nds" && fs::is_regular_file( fpath, ec );
 }
 
+/*
+    FindOverlay11
+        Looks for overlay 11 next to arm9.bin, or in the "overlay" sub-directory ndstool extracts to.
+        Returns an empty string if there's none.
+*/
+string FindOverlay11( const fs::path & romdir )
+{
+    static const char * Overlay11FName = "overlay_0011.bin";
+    std::error_code ec;
+    if( fs::is_regular_file( romdir / Overlay11FName, ec ) )
+        return (romdir / Overlay11FName).string();
+    if( fs::is_regular_file( romdir / "overlay" / Overlay11FName, ec ) )
+        return (romdir / "overlay" / Overlay11FName).string();
+    return string();
+}
 
-// ----------------------------------------------------------------------------------------
 /*
-    SpecListEntry
-        Single entry in the level list
+    MakeRomJob
+        Builds the job for the NDS ROM image or extracted ROM directory "romsrc", dumping into "outdir"/"outname".
+        Makes the output name unique if another ROM already uses it.
 */
-struct SpecListEntry
+RomJob MakeRomJob( const fs::path & romsrc, const fs::path & outdir, fs::path outname, map<string,size_t> & usednames )
 {
-    int16_t  id         = 0;
-    int16_t  unk2       = 0;
-    uint32_t ptrstring  = 0;
+    const bool bisnds = IsNdsRomPath(romsrc);
+    if( outname.empty() || outname == "." )
+        outname = romsrc.filename().empty()? fs::path("rom") : romsrc.filename();
+    if( bisnds )
+        outname.replace_extension();
+
+    string uniquename = outname.generic_string();
+    size_t & cntuse   = usednames[uniquename];
+    if( cntuse++ != 0 )
+        uniquename += "_" + to_string(cntuse);
+
+    RomJob job;
+    if( bisnds )
+        job.ndspath = romsrc.string();
+    else
+    {
+        job.arm9path      = (romsrc / "arm9.bin").string();
+        job.overlay11path = FindOverlay11(romsrc);
+    }
+    job.targetdir = (outdir / uniquename).string();
+    return job;
+}
 
-    static const size_t Size = 8;
+/*
+    ListRomsInTree
+        Walks a directory tree, and makes a job for every NDS ROM image, and every directory containing an arm9.bin.
+        Doesn't descend into the ROM directories themselves, since extracted ROMs contain
+        thousands of files that aren't relevant.
+*/
+vector<RomJob> ListRomsInTree( const fs::path & rootdir, const fs::path & outdir )
+{
+    vector<RomJob>     jobs;
+    map<string,size_t> usednames;
 
-    template<typename _init>
-        _init Read( _init itbeg, _init itend )
+    if( fs::is_regular_file( rootdir / "arm9.bin" ) )
+        jobs.push_back( MakeRomJob( rootdir, outdir, fs::path(), usednames ) );
+    else
     {
-        itbeg = ReadIntFromBytes( id,           itbeg, itend );
-        itbeg = ReadIntFromBytes( unk2,         itbeg, itend );
-        itbeg = ReadIntFromBytes( ptrstring,    itbeg, itend );
-        return itbeg;
+        for( fs::recursive_directory_iterator itdir(rootdir, fs::directory_options::skip_permission_denied), itend; itdir != itend; ++itdir )
+        {
+            std::error_code ec;
+            if( IsNdsRomPath( itdir->path() ) )
+            {
+                jobs.push_back( MakeRomJob( itdir->path(), outdir, itdir->path().lexically_relative(rootdir), usednames ) );
+                continue;
+            }
+            if( !itdir->is_directory(ec) || !fs::is_regular_file( itdir->path() / "arm9.bin", ec ) )
+                continue;
+            jobs.push_back( MakeRomJob( itdir->path(), outdir, itdir->path().lexically_relative(rootdir), usednames ) );
+            itdir.disable_recursion_pending();
+        }
     }
+    return jobs;
+}
 
-    template<typename _outstrm, typename _init >
-        void Print( _outstrm & out, _init itfbeg, _init itfend, const uint32_t ptrDiff  )
+/*
+    LoadRomManifest
+        Reads a text file listing one NDS ROM image or extracted ROM directory per line.
+        Relative paths are relative to the manifest's directory. Lines starting with '#' are ignored.
+*/
+vector<RomJob> LoadRomManifest( const fs::path & manifestpath, const fs::path & outdir )
+{
+    ifstream manifest( manifestpath );
+    if( manifest.bad() || !(manifest.is_open()) )
+        throw std::runtime_error("Couldn't open manifest " + manifestpath.string());
+
+    vector<RomJob>     jobs;
+    map<string,size_t> usednames;
+    string             line;
+    while( getline( manifest, line ) )
     {
-        string fetchedstr = "NULL";
-        if( ptrstring != 0 )
-            fetchedstr = FetchString( ptrstring - ptrDiff, itfbeg, itfend );
+        while( !line.empty() && isspace( static_cast<unsigned char>(line.back()) ) )
+            line.pop_back();
+        if( line.empty() || line.front() == '#' )
+            continue;
+
+        fs::path romsrc( line );
+        fs::path outname = romsrc.is_relative()? romsrc.lexically_normal() : romsrc.filename();
+        if( romsrc.is_relative() )
+            romsrc = manifestpath.parent_path() / romsrc;
+        jobs.push_back( MakeRomJob( romsrc, outdir, outname, usednames ) );
+    }
+    return jobs;
+}
 
-        out << "-> " <<setfill(' ') <<setw(5) <<id
-            << ", "  <<setfill(' ') <<setw(5) <<unk2     
-            << ", \""  <<fetchedstr <<"\""
-            <<"\n";
+/*
+    LoadBatchJobs
+        The jobs of a batch, from a directory tree to search for ROMs, or from a manifest file.
+*/
+vector<RomJob> LoadBatchJobs( const fs::path & batchsrc, const fs::path & outdir )
+{
+    return fs::is_directory(batchsrc)? ListRomsInTree( batchsrc, outdir ) : LoadRomManifest( batchsrc, outdir );
+}
+
+/*
+    MakeSingleJob / JobDisplayName
+        The job for the NDS ROM image "rompath", or for arm9.bin and overlay_0011.bin in the working
+        directory if it's empty, and the name its results are reported under.
+*/
+RomJob MakeSingleJob( const string & rompath )
+{
+    RomJob job;
+    if( !rompath.empty() )
+        job.ndspath = rompath;
+    else
+    {
+        job.arm9path      = "arm9.bin";
+        job.overlay11path = "overlay_0011.bin";
     }
+    return job;
+}
+
+inline string JobDisplayName( const string & rompath )
+{
+    return rompath.empty()? string("arm9.bin/overlay_0011.bin") : rompath;
+}
 
-    template<typename _outstrm>
-        static void PrintHeader( _outstrm & out )
+/*
+    ForEachRomJob
+        Runs "perjob( job, jobidx, name, logmtx )" for every ROM in the list, on a thread pool, where
+        "name" is the ROM's path. Jobs lock "logmtx" to print, or to merge their results. A job that
+        throws is reported as "<!>- Error <verb> <name>", and counts as failed.
+        Ex: ForEachRomJob( jobs, nbthreads, "diffing", ... ) prints "Diffing 12 ROM(s) using 8 thread(s)..".
+        Returns the number of jobs that failed.
+*/
+template<class _FunTy>
+    size_t ForEachRomJob( const vector<RomJob> & jobs, size_t nbthreads, const char * verb, _FunTy && perjob )
+{
+    ThreadPool          pool(nbthreads);
+    mutex               logmtx;
+    std::atomic<size_t> nbfailed {0};
+
+    string title(verb);
+    if( !title.empty() )
+        title.front() = static_cast<char>( toupper( static_cast<unsigned char>(title.front()) ) );
+    cout <<title <<" " <<jobs.size() <<" ROM(s) using " <<pool.NbThreads() <<" thread(s)..\n";
+    for( size_t i = 0; i < jobs.size(); ++i )
     {
-        out <<"Id     "
-            //"     5,"
-            <<"Unk2   "
-            //"   342,"
-            <<"Symbol "
-            ;
+        pool.Submit( [&, i]()
+        {
+            const RomJob & job  = jobs[i];
+            const string & name = job.ndspath.empty()? job.arm9path : job.ndspath;
+            try
+            {
+                perjob( job, i, name, logmtx );
+            }
+            catch( const std::exception & e )
+            {
+                ++nbfailed;
+                lock_guard<mutex> lk(logmtx);
+                cerr <<"<!>- Error " <<verb <<" " <<name <<" : " <<e.what() <<"\n";
+            }
+        });
     }
+    pool.WaitIdle();
+    return nbfailed;
+}
 
-    struct Stats
+/*
+    RunBatch
+        Dumps every ROM in the list on a thread pool. For extracted ROMs, the arm9 and
+        overlay 11 dumps are queued as separate jobs, and the tables of each file are dumped as tasks
+        on the same pool. Each job only keeps its own input files mapped while it runs, so memory use
+        and open files grow with the number of threads rather than the number of ROMs. A thread
+        waiting on its tables only helps with those, and never starts another job meanwhile.
+        If "pcorpusstats" isn't null, the stats of every dumped file are merged into it.
+        Returns the number of jobs that failed.
+*/
+size_t RunBatch( const vector<RomJob> & jobs, size_t nbthreads, const DumpOptions & opts, TablesStats * pcorpusstats = nullptr )
+{
+    ThreadPool          pool(nbthreads);
+    mutex               logmtx;
+    mutex               statsmtx;
+    std::atomic<size_t> nbfailed {0};
+    DumpOptions         jobopts = opts;
+    jobopts.ptablepool = &pool;
+
+    auto lambdaRunJob = [&]( const RomJob & job, const string & fname, auto && dumpfun )
     {
-        void LogStats( const SpecListEntry & entry )
+        try
+        {
+            std::error_code ec;
+            fs::create_directories( job.targetdir, ec );
+            if( !fs::is_directory( job.targetdir ) )
+                throw std::runtime_error("Couldn't create output directory " + job.targetdir);
+            if( pcorpusstats == nullptr )
+            {
+                dumpfun( fname, job.targetdir, jobopts, nullptr );
+                return;
+            }
+            TablesStats filestats;
+            dumpfun( fname, job.targetdir, jobopts, &filestats );
+            lock_guard<mutex> lk(statsmtx);
+            pcorpusstats->Merge(filestats);
+        }
+        catch( const std::exception & e )
         {
-            idstat.Process(entry.id);
-            unk2stat.Process(entry.unk2);
+            ++nbfailed;
+            lock_guard<mutex> lk(logmtx);
+            cerr <<"<!>- Error dumping " <<fname <<" : " <<e.what() <<"\n";
         }
+    };
 
-        string Print()
+    cout <<"Dumping " <<jobs.size() <<" ROM(s) using " <<pool.NbThreads() <<" thread(s)..\n";
+    for( const RomJob & job : jobs )
+    {
+        if( !job.ndspath.empty() )
+        {
+            pool.Submit( [&lambdaRunJob, &job](){ lambdaRunJob( job, job.ndspath, DumpNdsRomStuff ); } );
+            continue;
+        }
+        pool.Submit( [&lambdaRunJob, &job](){ lambdaRunJob( job, job.arm9path, DumpArm9Stuff ); } );
+        if( !job.overlay11path.empty() )
+            pool.Submit( [&lambdaRunJob, &job](){ lambdaRunJob( job, job.overlay11path, DumpOverlay0011Stuff ); } );
+        else
         {
-            stringstream sstr;
-            sstr<<"Id   :" << idstat.Print()   <<"\n"
-                <<"unk2 :" << unk2stat.Print() <<"\n"
-                ;
-            return std::move(sstr.str());
+            ++nbfailed;
+            lock_guard<mutex> lk(logmtx);
+            cerr <<"<!>- Couldn't find overlay_0011.bin next to " <<job.arm9path <<"\n";
         }
+    }
+    pool.WaitIdle();
+    return nbfailed;
+}
 
-        LimitVal<decltype(SpecListEntry::id)>   idstat;
-        LimitVal<decltype(SpecListEntry::unk2)> unk2stat;
+/*
+    BatchFile
+        A single input file of a batch, as it goes through the stages of RunBatchPipelined.
+*/
+struct BatchFile
+{
+    enum struct eKind
+    {
+        NdsRom,
+        Arm9,
+        Overlay11,
     };
+
+    eKind                             kind = eKind::NdsRom;
+    const RomJob *                    pjob = nullptr;
+    string                            path;
+    MappedFile                        fdat;
+    std::exception_ptr                perror;     //Set when the file couldn't be loaded
+    vector<OutputFiles::DeferredFile> outputs;
 };
 
+/*
+    RunBatchPipelined
+        Same as RunBatch, but keeps the disk and the CPU busy at the same time, with three stages
+        connected by bounded queues:
+            - A prefetch thread maps the upcoming input files, and reads the parts that get parsed
+              into memory. For NDS ROM images, that's only the arm9 and overlay 11.
+            - Worker threads dump the files into memory.
+            - A writer thread writes the dumps to disk.
+        At most "nbthreads" files wait in each queue, so memory use stays bounded however large
+        the batch is. Meant for corpora on slow or network storage, where RunBatch's threads
+        spend most of their time waiting on reads.
+*/
+size_t RunBatchPipelined( const vector<RomJob> & jobs, size_t nbthreads, const DumpOptions & opts, TablesStats * pcorpusstats = nullptr )
+{
+    if( nbthreads == 0 )
+        nbthreads = 1;
+    BoundedQueue<unique_ptr<BatchFile>> loadedq(nbthreads);
+    BoundedQueue<unique_ptr<BatchFile>> dumpedq(nbthreads);
+    mutex                               logmtx;
+    mutex                               statsmtx;
+    std::atomic<size_t>                 nbfailed {0};
+
+    auto lambdaLogError = [&]( const string & what, const string & fname, const std::exception & e )
+    {
+        ++nbfailed;
+        lock_guard<mutex> lk(logmtx);
+        cerr <<"<!>- Error " <<what <<" " <<fname <<" : " <<e.what() <<"\n";
+    };
+
+    cout <<"Dumping " <<jobs.size() <<" ROM(s) using " <<nbthreads <<" thread(s), pipelined..\n";
 
+    //Stage 1: Map and read ahead
+    auto lambdaPrefetch = [&]( BatchFile & file )
+    {
+        PMD2_PROF_SCOPE( (file.kind == BatchFile::eKind::NdsRom)? "rom" : (file.kind == BatchFile::eKind::Arm9)? "arm9" : "overlay_0011" );
+        file.fdat = LoadFile( file.path );
+        PMD2_PROF_TIME(LoadFile);
+        if( file.kind != BatchFile::eKind::NdsRom )
+        {
+            file.fdat.Prefetch();
+            return;
+        }
+        try
+        {
+            NdsRom         rom( file.fdat.begin(), file.fdat.end() );
+            ByteRange      arm9  = rom.Arm9();
+            NdsOverlayInfo ovl11 = rom.Overlay(11);
+            file.fdat.Prefetch( arm9.begin(),       arm9.end() );
+            file.fdat.Prefetch( ovl11.data.begin(), ovl11.data.end() );
+        }
+        catch( const std::exception & )
+        {}  //A bad ROM is reported when it's dumped
+    };
 
-template<typename _init, typename _outstrm>
-    void DumpSpecialListEoS( _init itbeg, _init itend, _outstrm & out )
+    std::thread prefetcher( [&]()
+    {
+        auto lambdaQueue = [&]( BatchFile::eKind kind, const RomJob & job, const string & path )
+        {
+            auto pfile  = make_unique<BatchFile>();
+            pfile->kind = kind;
+            pfile->pjob = &job;
+            pfile->path = path;
+            try
+            {
+                lambdaPrefetch(*pfile);
+            }
+            catch( const std::exception & )
+            {
+                pfile->perror = std::current_exception();
+            }
+            loadedq.Push( std::move(pfile) );
+        };
+
+        for( const RomJob & job : jobs )
+        {
+            if( !job.ndspath.empty() )
+            {
+                lambdaQueue( BatchFile::eKind::NdsRom, job, job.ndspath );
+                continue;
+            }
+            lambdaQueue( BatchFile::eKind::Arm9, job, job.arm9path );
+            if( !job.overlay11path.empty() )
+                lambdaQueue( BatchFile::eKind::Overlay11, job, job.overlay11path );
+            else
+            {
+                ++nbfailed;
+                lock_guard<mutex> lk(logmtx);
+                cerr <<"<!>- Couldn't find overlay_0011.bin next to " <<job.arm9path <<"\n";
+            }
+        }
+        loadedq.Close();
+    });
+
+    //Stage 2: Dump into memory
+    auto lambdaDump = [&]( BatchFile & file )
+    {
+        if( file.perror )
+            std::rethrow_exception( file.perror );
+        const string &  targetdir = file.pjob->targetdir;
+        std::error_code ec;
+        fs::create_directories( targetdir, ec );
+        if( !fs::is_directory( targetdir ) )
+            throw std::runtime_error("Couldn't create output directory " + targetdir);
+
+        OutputFiles outputs(true);
+        DumpOptions fileopts = opts;
+        fileopts.pfiles      = &outputs;
+        TablesStats filestats;
+        TablesStats * pstats = (pcorpusstats != nullptr)? &filestats : nullptr;
+        switch( file.kind )
+        {
+            case BatchFile::eKind::NdsRom:
+                DumpNdsRomImage( file.fdat, file.path, targetdir, fileopts, pstats );
+                break;
+            case BatchFile::eKind::Arm9:
+                DumpArm9Tables( file.fdat.begin(), file.fdat.end(), LoadOffsetOfBuild, ExtractedGameCode(file.path), targetdir, fileopts, pstats );
+                break;
+            case BatchFile::eKind::Overlay11:
+                DumpOverlay0011Tables( file.fdat.begin(), file.fdat.end(), LoadOffsetOfBuild, ExtractedGameCode(file.path), targetdir, fileopts, pstats );
+                break;
+        };
+        file.outputs = outputs.TakeDeferred();
+        if( pstats != nullptr )
+        {
+            lock_guard<mutex> lk(statsmtx);
+            pcorpusstats->Merge(filestats);
+        }
+    };
+
+    vector<std::thread> workers;
+    for( size_t i = 0; i < nbthreads; ++i )
+    {
+        workers.emplace_back( [&]()
+        {
+            unique_ptr<BatchFile> pfile;
+            while( loadedq.Pop(pfile) )
+            {
+                try
+                {
+                    lambdaDump(*pfile);
+                    pfile->fdat = MappedFile();   //Unmap as soon as possible
+                    dumpedq.Push( std::move(pfile) );
+                }
+                catch( const std::exception & e )
+                {
+                    lambdaLogError( "dumping", pfile->path, e );
+                }
+            }
+        });
+    }
+
+    //Stage 3: Write to disk
+    std::thread writer( [&]()
+    {
+        PMD2_PROF_SCOPE("writer");
+        unique_ptr<BatchFile> pfile;
+        while( dumpedq.Pop(pfile) )
+        {
+            for( const OutputFiles::DeferredFile & out : pfile->outputs )
+            {
+                try
+                {
+                    PMD2_PROF_TIME(Finish);
+                    ofstream fout( out.path, out.bbinary? (std::ios::out | std::ios::binary) : std::ios::out );
+                    fout.write( out.data.data(), static_cast<std::streamsize>( out.data.size() ) );
+                    if( !fout )
+                        throw std::runtime_error("Couldn't write " + out.path + "!");
+                }
+                catch( const std::exception & e )
+                {
+                    lambdaLogError( "writing the output of", pfile->path, e );
+                    break;
+                }
+            }
+        }
+    });
+
+    prefetcher.join();
+    for( std::thread & th : workers )
+        th.join();
+    dumpedq.Close();
+    writer.join();
+    return nbfailed;
+}
+
+
+//=============================================================================================================
+//  Diff Mode
+//=============================================================================================================
+/*
+    IndexRomSource
+        Decodes every table of a NDS ROM image or extracted ROM directory.
+*/
+SymbolIndex IndexRomSource( const string & romsrc, const BuildDatabase & builds )
 {
-    //overlay_0011
-    //0x0003D8AC -> start strings
-    //0x000405E8 -> Start LUT. 8 bytes entries, 2 shorts, one pointer.
-    //0x00041BD0 -> One past end of LUT. 701 entries.
-    static const size_t   NbEntries = 701;
-    static const uint32_t LUTBeg    = 0x405E8;
+    std::error_code ec;
+    if( !IsNdsRomPath(romsrc) && !fs::is_directory( romsrc, ec ) )
+        throw runtime_error("IndexRomSource(): " + romsrc + " is neither a .nds file nor a directory!");
+    map<string,size_t> usednames;
+    RomJob             job = MakeRomJob( romsrc, fs::path(), fs::path(), usednames );
+    if( job.ndspath.empty() && job.overlay11path.empty() )
+        throw runtime_error("IndexRomSource(): Couldn't find overlay_0011.bin in " + romsrc + "!");
+    return BuildSymbolIndex( job.ndspath, job.arm9path, job.overlay11path, builds );
+}
 
-    ParseAndDumpLUT<SpecListEntry>( LUTBeg, NbEntries, itbeg, itend, out, "Special List Table", Overlay_0011LoadOffset );
+void PrintDiffSummary( ostream & out, const string & name, const DiffSummary & summary )
+{
+    out <<name <<" : " <<summary.nbadded <<" added, " <<summary.nbremoved <<" removed, " <<summary.nbchanged <<" changed\n";
 }
 
-// ----------------------------------------------------------------------------------------
 /*
-    EventSubFileListEntry
-        Single entry in the level list
+    RunBatchDiff
+        Diffs every ROM in the list against the already decoded base, on a thread pool.
+        Each ROM's diff goes to "diff.txt" in its output directory.
+        Returns the number of jobs that failed.
 */
-struct EventSubFileListEntry
+size_t RunBatchDiff( const vector<RomJob> & jobs, size_t nbthreads, const SymbolIndex & base, const BuildDatabase & builds )
 {
-    int16_t  unk1       = 0;
-    int16_t  unk2       = 0;
-    uint32_t ptrstring  = 0;
-    uint32_t unk3       = 0;
+    return ForEachRomJob( jobs, nbthreads, "diffing", [&]( const RomJob & job, size_t, const string & name, mutex & logmtx )
+    {
+        if( job.ndspath.empty() && job.overlay11path.empty() )
+            throw runtime_error("No overlay_0011.bin next to the arm9!");
+        SymbolIndex     other = BuildSymbolIndex( job.ndspath, job.arm9path, job.overlay11path, builds );
+        std::error_code ec;
+        fs::create_directories( job.targetdir, ec );
+        ofstream        out( job.targetdir + "/diff.txt" );
+        DiffSummary     summary = DiffTableSets( base, other, out );
+        lock_guard<mutex> lk(logmtx);
+        PrintDiffSummary( cout, name, summary );
+    });
+}
 
-    static const size_t Size = 12;
 
-    template<typename _init>
-        _init Read( _init itbeg, _init itend )
+//=============================================================================================================
+//  Patch Mode
+//=============================================================================================================
+/*
+    OpenPatchableBinary
+        Maps an extracted arm9 or overlay 11 for writing. Compressed binaries can't be edited in
+        place, so they're refused.
+*/
+MappedFile OpenPatchableBinary( const string & fpath, bool barm9 )
+{
+    MappedFile      fdat( fpath, true );
+    const uint8_t * pbeg        = fdat.begin();
+    const bool      bcompressed = barm9? (BLZFindArm9CompressedEnd( pbeg, fdat.size(), Arm9BinLoadOffset ) != 0) : BLZIsCompressed( pbeg, fdat.size() );
+    if( bcompressed )
+        throw runtime_error("OpenPatchableBinary(): " + fpath + " is compressed, and can't be patched in place!");
+    return fdat;
+}
+
+/*
+    PatchNdsRomFile
+        Applies the patches to the arm9 and overlay 11 inside a NDS ROM image, in place, at the
+        table locations of the build they're identified as. Only the binaries that have patches
+        need to be uncompressed.
+*/
+PatchResult PatchNdsRomFile( const string & rompath, const vector<TablePatch> & patches, const string & patchpath, const BuildDatabase & builds )
+{
+    MappedFile      fdat( rompath, true );
+    NdsRom          rom( fdat.begin(), fdat.end() );
+    uint8_t *       pbase   = fdat.WritableData();
+    const bool      barm9   = HasTablePatches( patches, Arm9PatchTables );
+    const bool      bovl11  = HasTablePatches( patches, Overlay11PatchTables );
+    PreparedPatches arm9patches;
+    PreparedPatches ovl11patches;
+    auto lambdaWritable = [&]( const uint8_t * p ){ return pbase + (p - fdat.begin()); };
+
+    if( barm9 )
     {
-        itbeg = ReadIntFromBytes( unk1,         itbeg, itend );
-        itbeg = ReadIntFromBytes( unk2,         itbeg, itend );
-        itbeg = ReadIntFromBytes( ptrstring,    itbeg, itend );
-        itbeg = ReadIntFromBytes( unk3,         itbeg, itend );
-        return itbeg;
+        ByteRange arm9 = rom.Arm9();
+        if( BLZFindArm9CompressedEnd( arm9.begin(), arm9.size(), rom.Arm9RamAddress() ) != 0 )
+            throw runtime_error("PatchNdsRomFile(): The arm9 in " + rompath + " is compressed, and can't be patched in place!");
     }
-
-    template<typename _outstrm, typename _init >
-        void Print( _outstrm & out, _init itfbeg, _init itfend, const uint32_t ptrDiff  )
+    if( bovl11 )
+    {
+        NdsOverlayInfo ovl11 = rom.Overlay(11);
+        if( ovl11.bcompressed || BLZIsCompressed( ovl11.data.begin(), ovl11.data.size() ) )
+            throw runtime_error("PatchNdsRomFile(): Overlay 11 in " + rompath + " is compressed, and can't be patched in place!");
+    }
+    if( barm9 )
+    {
+        ByteRange            arm9  = rom.Arm9();
+        const BuildProfile & build = SelectBuild( builds, rom.GameCode(), eBuildBinary::Arm9, arm9, rom.Arm9RamAddress() );
+        arm9patches = PrepareArm9Patches( lambdaWritable(arm9.begin()), lambdaWritable(arm9.end()), rom.Arm9RamAddress(), patches, patchpath, &build.arm9luts );
+    }
+    if( bovl11 )
     {
-        string fetchedstr = "NULL";
-        if( ptrstring != 0 )
-            fetchedstr = FetchString( ptrstring - ptrDiff, itfbeg, itfend );
+        NdsOverlayInfo       ovl11 = rom.Overlay(11);
+        const BuildProfile & build = SelectBuild( builds, rom.GameCode(), eBuildBinary::Overlay11, ovl11.data, ovl11.ramaddr );
+        ovl11patches = PrepareOverlay0011Patches( lambdaWritable(ovl11.data.begin()), lambdaWritable(ovl11.data.end()), ovl11.ramaddr, patches, patchpath, &build.overlay11luts );
+    }
+
+    //Nothing is written until both binaries' patches were validated
+    WarnLUTFallbacks( arm9patches.fallbacks );
+    WarnLUTFallbacks( ovl11patches.fallbacks );
+    PatchResult result;
+    if( barm9 )
+        WritePreparedPatches( arm9patches, result );
+    if( bovl11 )
+        WritePreparedPatches( ovl11patches, result );
+    fdat.Flush();
+    return result;
+}
 
-        out << "-> " <<setfill(' ') <<setw(5) <<unk1
-            << ", "  <<setfill(' ') <<setw(5) <<unk2
-            << ", "  <<setfill(' ') <<setw(8) <<unk3         
-            << ", \""  <<fetchedstr <<"\""
-            <<"\n";
+/*
+    PatchRomJob
+        Applies the patches to a NDS ROM image, or to the binaries of an extracted ROM that have patches.
+        Both binaries' patches are validated before either file is written to. The tables are patched
+        where the build each binary is identified as keeps them, like they're dumped.
+*/
+PatchResult PatchRomJob( const RomJob & job, const vector<TablePatch> & patches, const string & patchpath, const BuildDatabase & builds )
+{
+    if( !job.ndspath.empty() )
+        return PatchNdsRomFile( job.ndspath, patches, patchpath, builds );
+
+    const bool barm9  = HasTablePatches( patches, Arm9PatchTables );
+    const bool bovl11 = HasTablePatches( patches, Overlay11PatchTables );
+    if( bovl11 && job.overlay11path.empty() )
+        throw runtime_error("PatchRomJob(): Couldn't find overlay_0011.bin next to " + job.arm9path + "!");
+
+    MappedFile      arm9file;
+    MappedFile      ovl11file;
+    PreparedPatches arm9patches;
+    PreparedPatches ovl11patches;
+    if( barm9 )
+    {
+        arm9file = OpenPatchableBinary( job.arm9path, true );
+        const BuildProfile & build = SelectBuild( builds, ExtractedGameCode(job.arm9path), eBuildBinary::Arm9, ByteRange{ arm9file.begin(), arm9file.end() }, LoadOffsetOfBuild );
+        arm9patches = PrepareArm9Patches( arm9file.WritableData(), arm9file.WritableData() + arm9file.size(), build.arm9loadoffset, patches, patchpath, &build.arm9luts );
+    }
+    if( bovl11 )
+    {
+        ovl11file = OpenPatchableBinary( job.overlay11path, false );
+        const BuildProfile & build = SelectBuild( builds, ExtractedGameCode(job.overlay11path), eBuildBinary::Overlay11, ByteRange{ ovl11file.begin(), ovl11file.end() }, LoadOffsetOfBuild );
+        ovl11patches = PrepareOverlay0011Patches( ovl11file.WritableData(), ovl11file.WritableData() + ovl11file.size(), build.overlay11loadoffset, patches, patchpath, &build.overlay11luts );
     }
 
-    template<typename _outstrm>
-        static void PrintHeader( _outstrm & out )
+    //Nothing is written until both binaries' patches were validated
+    WarnLUTFallbacks( arm9patches.fallbacks );
+    WarnLUTFallbacks( ovl11patches.fallbacks );
+    PatchResult result;
+    if( barm9 )
+    {
+        WritePreparedPatches( arm9patches, result );
+        arm9file.Flush();
+    }
+    if( bovl11 )
     {
-        out <<"Unk1   "
-            //"     5,"
-            <<"Unk2   "
-            //"   342,"
-            <<"Unk3      "
-            //"        0,"
-            <<"Symbol "
-            ;
+        WritePreparedPatches( ovl11patches, result );
+        ovl11file.Flush();
     }
+    return result;
+}
+
+void PrintPatchResult( ostream & out, const string & name, const PatchResult & result )
+{
+    out <<name <<" : " <<result.nbpatches <<" change(s), " <<result.nbrowschanged <<" row(s) and " <<result.nbbyteschanged <<" byte(s) modified\n";
+}
 
-    struct Stats
+/*
+    RunBatchPatch
+        Applies the same patches to every ROM in the list, on a thread pool.
+        Returns the number of jobs that failed.
+*/
+size_t RunBatchPatch( const vector<RomJob> & jobs, size_t nbthreads, const vector<TablePatch> & patches, const string & patchpath, const BuildDatabase & builds )
+{
+    return ForEachRomJob( jobs, nbthreads, "patching", [&]( const RomJob & job, size_t, const string & name, mutex & logmtx )
+    {
+        PatchResult       result = PatchRomJob( job, patches, patchpath, builds );
+        lock_guard<mutex> lk(logmtx);
+        PrintPatchResult( cout, name, result );
+    });
+}
+
+//=============================================================================================================
+//  Scripts Mode
+//=============================================================================================================
+/*
+    FindScriptDir
+        Looks for the SCRIPT directory next to arm9.bin, or in the "data" sub-directory ndstool
+        extracts the file system to. Returns an empty string if there's none.
+*/
+string FindScriptDir( const fs::path & romdir )
+{
+    std::error_code ec;
+    if( fs::is_directory( romdir / "SCRIPT", ec ) )
+        return (romdir / "SCRIPT").string();
+    if( fs::is_directory( romdir / "data" / "SCRIPT", ec ) )
+        return (romdir / "data" / "SCRIPT").string();
+    return string();
+}
+
+void PrintScriptFile( ostream & out, const ScriptFile & file )
+{
+    out <<"SCRIPT/" <<file.path <<", " <<file.size <<" bytes, xxh64 " <<setfill('0') <<setw(16) <<right <<hex <<file.hash <<dec <<setfill(' ') <<"\n";
+}
+
+/*
+    PrintScriptReport
+        Lists the files of each event sub-file list row, the number of files in the directory of
+        each event list row, and the files none of them link to.
+*/
+void PrintScriptReport( ostream & out, const ScriptIndex & scripts, const ScriptLinks & links )
+{
+    out <<"Script files        : " <<scripts.Files().size() <<" in " <<scripts.NbDirectories() <<" directories, " <<scripts.TotalSize() <<" bytes\n"
+        <<"Event sub-file rows : " <<(links.events.size() - links.nbeventsmissing) <<" with files, " <<links.nbeventsmissing <<" missing\n"
+        <<"Event list rows     : " <<(links.levels.size() - links.nblevelsmissing) <<" with a directory, " <<links.nblevelsmissing <<" missing\n"
+        <<"Unused script files : " <<links.unused.size() <<"\n";
+
+    out <<"\nEvent Sub File List Table\n"
+        <<"============================================================\n";
+    for( const ScriptLink & link : links.events )
     {
-        void LogStats( const EventSubFileListEntry & entry )
+        out <<NumberToHexString(link.rowoffset) <<" \"" <<link.symbol <<"\" : ";
+        if( link.pfiles == nullptr )
         {
-            unk1stat.Process(entry.unk1);
-            unk2stat.Process(entry.unk2);
-            unk3stat.Process(entry.unk3);
+            out <<"missing\n";
+            continue;
         }
+        for( size_t i = 0; i < link.pfiles->size(); ++i )
+        {
+            if( i != 0 )
+                out <<string( NumberToHexString(link.rowoffset).size() + link.symbol.size() + 6, ' ' );
+            PrintScriptFile( out, scripts.Files()[(*link.pfiles)[i]] );
+        }
+    }
+
+    out <<"\nEvent List Table\n"
+        <<"============================================================\n";
+    for( const ScriptLink & link : links.levels )
+    {
+        out <<NumberToHexString(link.rowoffset) <<" \"" <<link.symbol <<"\" : ";
+        if( link.pfiles == nullptr )
+            out <<"missing\n";
+        else
+            out <<"SCRIPT/" <<scripts.Files()[link.pfiles->front()].dir <<", " <<link.pfiles->size() <<" files\n";
+    }
+
+    out <<"\nUnused Script Files\n"
+        <<"============================================================\n";
+    for( uint32_t fileidx : links.unused )
+        PrintScriptFile( out, scripts.Files()[fileidx] );
+}
+
+/*
+    ReportScripts
+        Indexes the SCRIPT directory of a NDS ROM image if "ndspath" isn't empty, or "scriptdir"
+        otherwise, and links the script files to the rows of the event tables, read where the build
+        each binary is identified as keeps them. The files are hashed on the pool while the binaries
+        are unpacked.
+*/
+void ReportScripts( const string & ndspath, const string & arm9path, const string & overlay11path, const string & scriptdir, const BuildDatabase & builds,
+                    size_t nbthreads, ostream & out )
+{
+    unique_ptr<ThreadPool> ppool;
+    if( nbthreads > 1 )
+        ppool = make_unique<ThreadPool>(nbthreads);
+
+    ScriptIndex      scripts;
+    vector<uint8_t>  arm9buf;
+    vector<uint8_t>  ovl11buf;
+    MappedFile       fdat;
+    MappedFile       arm9file;
+    MappedFile       ovl11file;
+    optional<NdsRom> rom;
+    UnpackedBinary   arm9;
+    UnpackedBinary   ovl11;
+    TaskGroup        scan( ppool.get() );
+    if( !ndspath.empty() )
+    {
+        fdat = LoadFile(ndspath);
+        rom.emplace( fdat.begin(), fdat.end() );
+        scan.Run( [&](){ scripts = ScanScriptRom( *rom, ppool.get() ); } );
+        NdsOverlayInfo ovlinfo  = rom->Overlay(11);
+        const string   gamecode = rom->GameCode();
+        arm9  = UnpackArm9Binary( rom->Arm9(), rom->Arm9RamAddress(), gamecode, builds, arm9buf );
+        ovl11 = UnpackOverlay0011Binary( ovlinfo.data, ovlinfo.ramaddr, gamecode, builds, ovl11buf );
+    }
+    else
+    {
+        scan.Run( [&](){ scripts = ScanScriptTree( scriptdir, ppool.get() ); } );
+        arm9file  = LoadFile(arm9path);
+        ovl11file = LoadFile(overlay11path);
+        arm9  = UnpackArm9Binary( ByteRange{ arm9file.begin(), arm9file.end() }, LoadOffsetOfBuild, ExtractedGameCode(arm9path), builds, arm9buf );
+        ovl11 = UnpackOverlay0011Binary( ByteRange{ ovl11file.begin(), ovl11file.end() }, LoadOffsetOfBuild, ExtractedGameCode(overlay11path), builds, ovl11buf );
+    }
+    LUTLocator arm9locator ( arm9.bin.begin(),  arm9.bin.end(),  arm9.loadoffset,  &arm9.pbuild->arm9luts );
+    LUTLocator ovl11locator( ovl11.bin.begin(), ovl11.bin.end(), ovl11.loadoffset, &ovl11.pbuild->overlay11luts );
+    TableView<LevelEntry>            levels = ViewEventList( arm9locator );
+    TableView<EventSubFileListEntry> events = ViewEventSubFileList( ovl11locator );
+    WarnLUTFallbacks( arm9locator.Fallbacks() );
+    WarnLUTFallbacks( ovl11locator.Fallbacks() );
+    scan.Wait();
+
+    PrintScriptReport( out, scripts, LinkScripts( scripts, events, levels ) );
+}
+
+//=============================================================================================================
+//  Join Mode
+//=============================================================================================================
+/*
+    RunJoins
+        Runs every join over the tables of a single ROM. Returns the summary of each join, in order.
+*/
+vector<JoinSummary> RunJoins( const SymbolIndex & index, const vector<JoinSpec> & joins, ostream & out )
+{
+    vector<JoinSummary> summaries;
+    for( const JoinSpec & join : joins )
+    {
+        summaries.push_back( RunJoin( index, join, out ) );
+        out <<"\n";
+    }
+    return summaries;
+}
+
+void PrintJoinSummary( ostream & out, const string & name, const JoinSummary & summary )
+{
+    out <<name <<" : " <<summary.nbmatches <<" match(es), " <<summary.nbdangling <<" dangling, " <<summary.nbunused <<" unused\n";
+}
 
-        string Print()
+/*
+    RunBatchJoin
+        Runs the joins over every ROM in the list, on a thread pool. Each ROM's results go to
+        "joins.txt" in its output directory, and the totals over the whole batch are printed per join.
+        Returns the number of jobs that failed.
+*/
+size_t RunBatchJoin( const vector<RomJob> & jobs, size_t nbthreads, const vector<JoinSpec> & joins, const BuildDatabase & builds )
+{
+    vector<JoinSummary> totals( joins.size() );
+    const size_t nbfailed = ForEachRomJob( jobs, nbthreads, "joining the tables of", [&]( const RomJob & job, size_t, const string & name, mutex & logmtx )
+    {
+        if( job.ndspath.empty() && job.overlay11path.empty() )
+            throw runtime_error("No overlay_0011.bin next to the arm9!");
+        SymbolIndex     index = BuildSymbolIndex( job.ndspath, job.arm9path, job.overlay11path, builds );
+        std::error_code ec;
+        fs::create_directories( job.targetdir, ec );
+        ofstream            out( job.targetdir + "/joins.txt" );
+        vector<JoinSummary> summaries = RunJoins( index, joins, out );
+        lock_guard<mutex> lk(logmtx);
+        for( size_t i = 0; i < joins.size(); ++i )
+            totals[i].Merge( summaries[i] );
+        cout <<name <<" : " <<job.targetdir <<"/joins.txt\n";
+    });
+
+    for( size_t i = 0; i < joins.size(); ++i )
+        PrintJoinSummary( cout, joins[i].left.table + "." + joins[i].left.column + " = " + joins[i].right.table + "." + joins[i].right.column, totals[i] );
+    return nbfailed;
+}
+
+//=============================================================================================================
+//  Identify Mode
+//=============================================================================================================
+/*
+    RomIdentity
+        The build a ROM was identified as, and the game code in its header, if it has one.
+*/
+struct RomIdentity
+{
+    string     gamecode;
+    BuildMatch match;
+};
+
+/*
+    IdentifyRom
+        Identifies the build of a ROM from its header and both its binaries, which are unpacked first.
+*/
+RomIdentity IdentifyRom( const RomJob & job, const BuildDatabase & builds )
+{
+    RomIdentity        id;
+    vector<uint8_t>    arm9buf;
+    vector<uint8_t>    ovl11buf;
+    vector<BuildImage> images;
+    MappedFile         fdat;
+    MappedFile         ovl11file;
+    if( !job.ndspath.empty() )
+    {
+        fdat = LoadFile(job.ndspath);
+        NdsRom rom( fdat.begin(), fdat.end() );
+        id.gamecode = rom.GameCode();
+        images.push_back( BuildImage{ eBuildBinary::Arm9, UnpackArm9( rom.Arm9().begin(), rom.Arm9().end(), rom.Arm9RamAddress(), arm9buf ), rom.Arm9RamAddress() } );
+        //Not every build has an overlay 11
+        if( rom.NbOverlays() > 11 )
         {
-            stringstream sstr;
-            sstr<<"unk1 :" << unk1stat.Print() <<"\n"
-                <<"unk2 :" << unk2stat.Print() <<"\n"
-                <<"unk3 :" << unk3stat.Print() <<"\n"
-                ;
-            return std::move( sstr.str() );
+            NdsOverlayInfo ovl11 = rom.Overlay(11);
+            images.push_back( BuildImage{ eBuildBinary::Overlay11, UnpackOverlay( ovl11.data.begin(), ovl11.data.end(), ovl11buf ), ovl11.ramaddr } );
         }
+    }
+    else
+    {
+        id.gamecode = ExtractedGameCode(job.arm9path);
+        fdat        = LoadFile(job.arm9path);
+        images.push_back( BuildImage{ eBuildBinary::Arm9, UnpackArm9( fdat.begin(), fdat.end(), Arm9BinLoadOffset, arm9buf ), LoadOffsetOfBuild } );
+        if( !job.overlay11path.empty() )
+        {
+            ovl11file = LoadFile(job.overlay11path);
+            images.push_back( BuildImage{ eBuildBinary::Overlay11, UnpackOverlay( ovl11file.begin(), ovl11file.end(), ovl11buf ), LoadOffsetOfBuild } );
+        }
+    }
+    id.match = builds.Identify( id.gamecode, images );
+    return id;
+}
 
-        LimitVal<decltype(EventSubFileListEntry::unk1)> unk1stat;
-        LimitVal<decltype(EventSubFileListEntry::unk2)> unk2stat;
-        LimitVal<decltype(EventSubFileListEntry::unk3)> unk3stat;
-    };
+/*
+    PrintRomIdentity
+        Ex: roms/sky.nds : C2SE Explorers of Sky (NA) (game code, table layout)
+*/
+void PrintRomIdentity( ostream & out, const string & name, const RomIdentity & id )
+{
+    out <<name <<" : " <<( id.gamecode.empty()? string("----") : id.gamecode ) <<" ";
+    if( !id.match.bidentified )
+    {
+        out <<"unidentified\n";
+        return;
+    }
+    string evidence;
+    auto lambdaAdd = [&evidence]( const string & what ){ evidence += (evidence.empty()? "" : ", ") + what; };
+    if( id.match.bgamecode )
+        lambdaAdd("game code");
+    if( id.match.nbpatterns != 0 )
+        lambdaAdd( to_string(id.match.nbpatterns) + " pattern(s)" );
+    if( id.match.blayout )
+        lambdaAdd("table layout");
+    out <<id.match.pprofile->name <<" (" <<evidence <<")\n";
+}
+
+/*
+    RunBatchIdentify
+        Identifies every ROM in the list on a thread pool, prints them in order, then the number of
+        ROMs of each build. Returns the number of jobs that failed.
+*/
+size_t RunBatchIdentify( const vector<RomJob> & jobs, size_t nbthreads, const BuildDatabase & builds )
+{
+    vector<RomIdentity> ids( jobs.size() );
+    vector<bool>        bdone( jobs.size(), false );
+    const size_t nbfailed = ForEachRomJob( jobs, nbthreads, "identifying", [&]( const RomJob & job, size_t jobidx, const string &, mutex & logmtx )
+    {
+        RomIdentity id = IdentifyRom( job, builds );
+        lock_guard<mutex> lk(logmtx);
+        ids[jobidx]   = std::move(id);
+        bdone[jobidx] = true;
+    });
+
+    map<string,size_t> nbperbuild;
+    for( size_t i = 0; i < jobs.size(); ++i )
+    {
+        if( !bdone[i] )
+            continue;
+        PrintRomIdentity( cout, jobs[i].ndspath.empty()? jobs[i].arm9path : jobs[i].ndspath, ids[i] );
+        ++nbperbuild[ ids[i].match.bidentified? ids[i].match.pprofile->name : string("unidentified") ];
+    }
+    for( const auto & build : nbperbuild )
+        cout <<setw(8) <<right <<build.second <<"  " <<build.first <<"\n";
+    return nbfailed;
+}
+
+//=============================================================================================================
+//  Coverage Mode
+//=============================================================================================================
+/*
+    RomCoverage
+        Which bytes of each binary of a ROM its tables explain.
+*/
+struct RomCoverage
+{
+    CoverageMap arm9;
+    CoverageMap overlay11;
 };
 
+/*
+    CoverArm9Binary / CoverOverlay0011Binary
+        Decodes the tables of a binary as stored, and marks the bytes of the tables and their strings
+        in a map of the unpacked binary. "loadoffset" and "gamecode" are as for UnpackArm9Binary().
+*/
+CoverageMap CoverArm9Binary( ByteRange data, uint32_t loadoffset, const string & gamecode, const BuildDatabase & builds )
+{
+    vector<uint8_t>      decompbuf;
+    const UnpackedBinary unpacked = UnpackArm9Binary( data, loadoffset, gamecode, builds, decompbuf );
+    CoverageMap          map( unpacked.bin.size() );
+    CoverageSink         sink( map, unpacked.bin.begin() );
+    ParseArm9Tables( unpacked.bin, unpacked.loadoffset, sink, nullptr, nullptr, &unpacked.pbuild->arm9luts );
+    return map;
+}
 
+CoverageMap CoverOverlay0011Binary( ByteRange data, uint32_t loadoffset, const string & gamecode, const BuildDatabase & builds )
+{
+    vector<uint8_t>      decompbuf;
+    const UnpackedBinary unpacked = UnpackOverlay0011Binary( data, loadoffset, gamecode, builds, decompbuf );
+    CoverageMap          map( unpacked.bin.size() );
+    CoverageSink         sink( map, unpacked.bin.begin() );
+    ParseOverlay0011Tables( unpacked.bin, unpacked.loadoffset, sink, nullptr, nullptr, &unpacked.pbuild->overlay11luts );
+    return map;
+}
 
-template<typename _init, typename _outstrm>
-    void DumpEventSubFileListEoS( _init itbeg, _init itend, _outstrm & out )
+RomCoverage CoverRom( const RomJob & job, const BuildDatabase & builds )
 {
-    //overlay_0011
-    //0x00041C00 -> Start strings.
-    //0x00042C14 -> Start LUT. 12 bytes entries. 2 shorts, 1 pointer, 1 int32
-    //0x00044610 -> One past the end of LUT. 555 entries, some were null.
-    static const size_t   NbEntries = 555;
-    static const uint32_t LUTBeg    = 0x42C14;
+    RomCoverage cover;
+    if( !job.ndspath.empty() )
+    {
+        MappedFile     fdat( LoadFile(job.ndspath) );
+        NdsRom         rom( fdat.begin(), fdat.end() );
+        NdsOverlayInfo ovl11    = rom.Overlay(11);
+        const string   gamecode = rom.GameCode();
+        cover.arm9      = CoverArm9Binary       ( rom.Arm9(), rom.Arm9RamAddress(), gamecode, builds );
+        cover.overlay11 = CoverOverlay0011Binary( ovl11.data, ovl11.ramaddr,        gamecode, builds );
+        return cover;
+    }
+    if( job.overlay11path.empty() )
+        throw runtime_error("No overlay_0011.bin next to the arm9!");
+    MappedFile arm9( LoadFile(job.arm9path) );
+    MappedFile ovl11( LoadFile(job.overlay11path) );
+    cover.arm9      = CoverArm9Binary       ( ByteRange{ arm9.begin(),  arm9.end() },  LoadOffsetOfBuild, ExtractedGameCode(job.arm9path),      builds );
+    cover.overlay11 = CoverOverlay0011Binary( ByteRange{ ovl11.begin(), ovl11.end() }, LoadOffsetOfBuild, ExtractedGameCode(job.overlay11path), builds );
+    return cover;
+}
 
-    ParseAndDumpLUT<EventSubFileListEntry>( LUTBeg, NbEntries, itbeg, itend, out, "Event Sub File List Table", Overlay_0011LoadOffset );
+/*
+    WriteRomCoverage
+        Writes the coverage and gaps of both binaries of a ROM into "targetdir", and prints a summary line.
+        Ex: roms/sky.nds : arm9 1.23%, overlay_0011 4.56%
+*/
+void WriteRomCoverage( ostream & out, const string & name, const RomCoverage & cover, const string & targetdir )
+{
+    {
+        ofstream arm9out( targetdir + "/arm9.coverage.txt" );
+        WriteCoverage( arm9out, "arm9", cover.arm9 );
+        ofstream ovl11out( targetdir + "/overlay_0011.coverage.txt" );
+        WriteCoverage( ovl11out, "overlay_0011", cover.overlay11 );
+        if( !arm9out || !ovl11out )
+            throw runtime_error("Couldn't write the coverage files in " + targetdir + "!");
+    }
+    out <<name <<" : " <<fixed <<setprecision(2)
+        <<"arm9 "          <<coverage::Percent( cover.arm9.NbCovered(),      cover.arm9.NbBytes() )      <<"%, "
+        <<"overlay_0011 "  <<coverage::Percent( cover.overlay11.NbCovered(), cover.overlay11.NbBytes() ) <<"%\n";
+    out.unsetf( ios::floatfield );
 }
-// ----------------------------------------------------------------------------------------
+
 /*
-    EntitySymbolListEntry
-        Single entry in the level list
+    RunBatchCoverage
+        Maps the coverage of every ROM in the list on a thread pool, into each ROM's output directory.
+        Then writes the coverage of the whole corpus and the gaps its ROMs share into "outdir".
+        Returns the number of jobs that failed.
 */
-struct EntitySymbolListEntry
+size_t RunBatchCoverage( const vector<RomJob> & jobs, size_t nbthreads, const BuildDatabase & builds, const string & outdir )
 {
-    int16_t  type       = 0;
-    int16_t  entityid   = 0;
-    uint32_t ptrstring  = 0;
-    uint16_t unk3       = 0;
-    uint16_t unk4       = 0;
+    CoverageSummary arm9total;
+    CoverageSummary ovl11total;
+    const size_t nbfailed = ForEachRomJob( jobs, nbthreads, "mapping the coverage of", [&]( const RomJob & job, size_t, const string & name, mutex & logmtx )
+    {
+        const RomCoverage cover = CoverRom( job, builds );
+        std::error_code   ec;
+        fs::create_directories( job.targetdir, ec );
+        CoverageSummary arm9sum;
+        CoverageSummary ovl11sum;
+        arm9sum.Add( cover.arm9 );
+        ovl11sum.Add( cover.overlay11 );
+        stringstream line;
+        WriteRomCoverage( line, name, cover, job.targetdir );
+        lock_guard<mutex> lk(logmtx);
+        arm9total.Merge(arm9sum);
+        ovl11total.Merge(ovl11sum);
+        cout <<line.str();
+    });
+
+    std::error_code ec;
+    fs::create_directories( outdir, ec );
+    const string corpuspath = outdir + "/coverage.txt";
+    ofstream     corpusout( corpuspath );
+    WriteCorpusCoverage( corpusout, "arm9",         arm9total );
+    corpusout <<"\n";
+    WriteCorpusCoverage( corpusout, "overlay_0011", ovl11total );
+    if( !corpusout )
+        throw runtime_error("Couldn't write " + corpuspath + "!");
+    cout <<fixed <<setprecision(2)
+         <<"arm9 "         <<coverage::Percent( arm9total.nbcovered,  arm9total.nbbytes )  <<"% covered, " <<arm9total.gaps.size()  <<" distinct gap(s)\n"
+         <<"overlay_0011 " <<coverage::Percent( ovl11total.nbcovered, ovl11total.nbbytes ) <<"% covered, " <<ovl11total.gaps.size() <<" distinct gap(s)\n"
+         <<"Shared gaps written to " <<corpuspath <<"\n";
+    cout.unsetf( ios::floatfield );
+    return nbfailed;
+}
 
-    static const size_t Size = 12;
+//=============================================================================================================
+//  Watch Mode
+//=============================================================================================================
+/*
+    WatchedBinary
+        A binary the watch mode keeps dumping, with the text of each of its tables as of the last dump.
+*/
+struct WatchedBinary
+{
+    string    basename;
+    bool      barm9     = false;
+    DumpCache tables;
+    size_t    nbdecoded = 0;    //Tables decoded again by the last dump, the others were reused
+};
 
-    template<typename _init>
-        _init Read( _init itbeg, _init itend )
+/*
+    RedumpWatchedBinary
+        Rewrites the text dump of a binary, decoding only the tables whose records or strings changed
+        since the last dump, and reusing the others' text. Returns false and writes nothing if none
+        of the tables changed, unless "bforce" is set.
+        The whole file isn't hashed, only each table's records and the strings they point to, as
+        they're located. So saving a binary where only code or unrelated data changed costs no more
+        than locating and hashing the tables.
+*/
+bool RedumpWatchedBinary( WatchedBinary & bin, ByteRange data, uint32_t loadoffset, const string & gamecode, const BuildDatabase & builds,
+                          const string & targetdir, ThreadPool * ppool, bool bforce )
+{
+    //Rendered in memory, since whether anything changed is only known once every table was located
+    vector<uint8_t> decompbuf;
+    DumpCache       newcache;
+    CachedTextSink  sink( bin.tables, newcache );
+    if( bin.barm9 )
+        ParseArm9Binary( data, loadoffset, gamecode, builds, decompbuf, sink, nullptr, ppool );
+    else
+        ParseOverlay0011Binary( data, loadoffset, gamecode, builds, decompbuf, sink, nullptr, ppool );
+
+    const vector<DumpCache::Chunk> & oldchunks = bin.tables.Chunks();
+    const vector<DumpCache::Chunk> & newchunks = newcache.Chunks();
+    const bool bunchanged = !bin.tables.empty() && std::equal( oldchunks.begin(), oldchunks.end(), newchunks.begin(), newchunks.end(),
+                                                               []( const DumpCache::Chunk & a, const DumpCache::Chunk & b ){ return a.key == b.key; } );
+    if( bunchanged && !bforce )
+        return false;
+
+    OutputFiles files;
+    ostream &   out = files.Open( targetdir + "/" + bin.basename + ".txt" );
+    sink.Buffer().WriteTo(out);
+    files.Close(out);
+    //Keep the cache on disk up to date, so a normal run afterward can reuse its tables too
+    newcache.Save( DumpCachePath( targetdir, bin.basename ) );
+
+    bin.nbdecoded = 0;
+    for( const DumpCache::Chunk & chunk : newcache.Chunks() )
     {
-        itbeg = ReadIntFromBytes( type,         itbeg, itend );
-        itbeg = ReadIntFromBytes( entityid,     itbeg, itend );
-        itbeg = ReadIntFromBytes( ptrstring,    itbeg, itend );
-        itbeg = ReadIntFromBytes( unk3,         itbeg, itend );
-        itbeg = ReadIntFromBytes( unk4,         itbeg, itend );
-        return itbeg;
+        if( bin.tables.Find(chunk.key) == nullptr )
+            ++bin.nbdecoded;
     }
+    bin.tables = std::move(newcache);
+    return true;
+}
 
-    template<typename _outstrm, typename _init >
-        void Print( _outstrm & out, _init itfbeg, _init itfend, const uint32_t ptrDiff  )
+/*
+    WatchSession
+        Dumps arm9 and overlay 11 from a NDS ROM image, or from the extracted binaries, and dumps
+        them again whenever the files change. Keeps the text of every table in memory in between.
+*/
+class WatchSession
+{
+public:
+    WatchSession( const string & ndspath, const string & arm9path, const string & overlay11path, const string & targetdir, const BuildDatabase & builds, ThreadPool * ppool )
+        :m_ndspath(ndspath), m_arm9path(arm9path), m_overlay11path(overlay11path), m_targetdir(targetdir), m_builds(builds), m_ppool(ppool)
     {
-        string fetchedstr = "NULL";
-        if( ptrstring != 0 )
-            fetchedstr = FetchString( ptrstring - ptrDiff, itfbeg, itfend );
-
-        out << "-> " <<setfill(' ') <<setw(5) <<type
-            << ", "  <<setfill(' ') <<setw(9) <<entityid
-            <<hex <<uppercase
-            << ", 0x"  <<setfill('0') <<setw(4) <<(unk3)
-            << ", 0x"  <<setfill('0') <<setw(4) <<(unk4)
-            <<dec <<nouppercase
-            << ", \""  <<fetchedstr <<"\""
-            <<"\n";
+        m_arm9.basename      = "arm9";
+        m_arm9.barm9         = true;
+        m_overlay11.basename = "overlay_0011";
+        m_arm9.tables.Load     ( DumpCachePath( targetdir, m_arm9.basename ) );
+        m_overlay11.tables.Load( DumpCachePath( targetdir, m_overlay11.basename ) );
     }
 
-    template<typename _outstrm>
-        static void PrintHeader( _outstrm & out )
+    //The files to watch, indices are the ones Redump() takes
+    vector<string> WatchedFiles()const
     {
-        out <<"Type   "
-            //"     5,"
-            <<"Entity Id "
-            //"   342,"
-            <<"Unk3   "
-            //"     0,"
-            <<"Unk4   "
-            //"   258,"
-            <<"Symbol "
-            ;
+        if( !m_ndspath.empty() )
+            return vector<string>{ m_ndspath };
+        return vector<string>{ m_arm9path, m_overlay11path };
     }
 
-    // ----------------------------------
-    struct Stats
+    /*
+        Redump
+            Dumps the binaries in the watched file "fileidx" again, and reports what changed.
+            Errors are reported without stopping, since the file may be caught halfway through being written.
+    */
+    void Redump( size_t fileidx, bool bforce, ostream & out )
     {
-        void LogStats( const EntitySymbolListEntry & entry )
+        const auto tstart = chrono::steady_clock::now();
+        try
+        {
+            if( !m_ndspath.empty() )
+            {
+                MappedFile     fdat( LoadFile(m_ndspath) );
+                NdsRom         rom( fdat.begin(), fdat.end() );
+                NdsOverlayInfo ovl11    = rom.Overlay(11);
+                const string   gamecode = rom.GameCode();
+                Report( out, m_arm9,      RedumpWatchedBinary( m_arm9,      rom.Arm9(), rom.Arm9RamAddress(), gamecode, m_builds, m_targetdir, m_ppool, bforce ), tstart );
+                Report( out, m_overlay11, RedumpWatchedBinary( m_overlay11, ovl11.data, ovl11.ramaddr,        gamecode, m_builds, m_targetdir, m_ppool, bforce ), tstart );
+            }
+            else if( fileidx == 0 )
+            {
+                MappedFile fdat( LoadFile(m_arm9path) );
+                Report( out, m_arm9,      RedumpWatchedBinary( m_arm9, ByteRange{ fdat.begin(), fdat.end() }, LoadOffsetOfBuild, ExtractedGameCode(m_arm9path), m_builds, m_targetdir, m_ppool, bforce ), tstart );
+            }
+            else
+            {
+                MappedFile fdat( LoadFile(m_overlay11path) );
+                Report( out, m_overlay11, RedumpWatchedBinary( m_overlay11, ByteRange{ fdat.begin(), fdat.end() }, LoadOffsetOfBuild, ExtractedGameCode(m_overlay11path), m_builds, m_targetdir, m_ppool, bforce ), tstart );
+            }
+        }
+        catch( const std::exception & e )
         {
-            typestat    .Process(entry.type);
-            entityidstat.Process(entry.entityid);
-            unk3stat    .Process(entry.unk3);
-            unk4stat    .Process(entry.unk4);
+            cerr <<"<!>- Error dumping " <<WatchedFiles()[fileidx] <<" : " <<e.what() <<"\n";
         }
+    }
 
-        string Print()
+private:
+    static void Report( ostream & out, const WatchedBinary & bin, bool bredumped, chrono::steady_clock::time_point tstart )
+    {
+        const double elapsedms = chrono::duration<double, milli>( chrono::steady_clock::now() - tstart ).count();
+        if( bredumped )
         {
-            stringstream sstr;
-            sstr<<"Type      :" << typestat.Print()     <<"\n"
-                <<"Entity ID :" << entityidstat.Print() <<"\n"
-                <<"unk3      :" << unk3stat.Print()     <<"\n"
-                <<"unk4      :" << unk4stat.Print()     <<"\n"
-                ;
-            return std::move(sstr.str());
+            //Formatted apart, so "out" keeps its own float format
+            ostringstream elapsed;
+            elapsed <<fixed <<setprecision(1) <<elapsedms;
+            out <<bin.basename <<" : " <<bin.nbdecoded <<" of " <<bin.tables.Chunks().size() <<" table(s) decoded, " <<elapsed.str() <<" ms\n";
         }
+        else
+            out <<bin.basename <<" : unchanged\n";
+        out.flush();
+    }
 
-        LimitVal<decltype(EntitySymbolListEntry::type)>     typestat;
-        LimitVal<decltype(EntitySymbolListEntry::entityid)> entityidstat;
-        LimitVal<decltype(EntitySymbolListEntry::unk3)>     unk3stat;
-        LimitVal<decltype(EntitySymbolListEntry::unk4)>     unk4stat;
-    };
+private:
+    string                m_ndspath;
+    string                m_arm9path;
+    string                m_overlay11path;
+    string                m_targetdir;
+    const BuildDatabase & m_builds;
+    ThreadPool *          m_ppool;
+    WatchedBinary         m_arm9;
+    WatchedBinary         m_overlay11;
 };
 
+/*
+    RunWatch
+        Dumps the binaries once, then again each time they change, until the process is stopped.
+*/
+void RunWatch( const string & ndspath, const string & arm9path, const string & overlay11path, const string & targetdir, const BuildDatabase & builds, size_t nbthreads, bool bforcepolling )
+{
+    fs::create_directories(targetdir);
+    unique_ptr<ThreadPool> ppool;
+    if( nbthreads > 1 )
+        ppool = make_unique<ThreadPool>(nbthreads);
+
+    WatchSession   session( ndspath, arm9path, overlay11path, targetdir, builds, ppool.get() );
+    vector<string> fpaths = session.WatchedFiles();
+    FileWatcher    watcher( fpaths, bforcepolling );
+    for( size_t i = 0; i < fpaths.size(); ++i )
+        session.Redump( i, true, cout );
+
+    cout <<"Watching ";
+    for( size_t i = 0; i < fpaths.size(); ++i )
+        cout <<( (i == 0)? "" : ", " ) <<fpaths[i];
+    cout <<" (" <<( watcher.UsesInotify()? "inotify" : "polling" ) <<"). Press Ctrl+C to stop.\n" <<flush;
+    for(;;)
+    {
+        for( size_t fileidx : watcher.WaitForChanges() )
+            session.Redump( fileidx, false, cout );
+    }
+}
 
 
-template<typename _init, typename _outstrm>
-    void DumpEntitySymbolsEoS( _init itbeg, _init itend, _outstrm & out )
+//=============================================================================================================
+//  Profiling
+//=============================================================================================================
+/*
+    ProfileReport
+        Prints what the profiler recorded when it goes out of scope, so the report is made on every
+        way out of main, once the worker threads are done.
+*/
+class ProfileReport
 {
-    //arm9
-    //0x000A6910 -> Start Strings
-    //0x000A7FF0 -> Start of LUT. 12 bytes entries. 2 shorts, 1 pointer, 2 shorts.
-    //0x000A9208 -> One past end of LUT. 386 entries.
-    static const size_t   NbEntries = 386;
-    static const uint32_t LUTBeg    = 0xA7FF0;
+public:
+    ProfileReport( bool btable, const string & jsonpath )
+        :m_btable(btable), m_jsonpath(jsonpath)
+    {
+        prof::Profiler::Instance().Enable( m_btable || !m_jsonpath.empty() );
+#if !PMD2_PROFILING
+        if( prof::IsEnabled() )
+            cerr <<"<!>- Warning: This build was made with PMD2_PROFILING=0, the profile will be empty!\n";
+#endif
+    }
 
-    ParseAndDumpLUT<EntitySymbolListEntry>( LUTBeg, NbEntries, itbeg, itend, out, "Entity Symbol List Table", Arm9BinLoadOffset );
-}
+    ~ProfileReport()
+    {
+        if( !prof::IsEnabled() )
+            return;
+        const prof::scoperecords_t scopes = prof::Profiler::Instance().Collect();
+        if( m_btable )
+            prof::PrintReport( cerr, scopes );
+        if( !m_jsonpath.empty() )
+        {
+            ofstream jsonout( m_jsonpath );
+            prof::PrintReportJson( jsonout, scopes );
+            if( !jsonout )
+                cerr <<"<!>- Error: Couldn't write the profile to " <<m_jsonpath <<"!\n";
+        }
+    }
 
+private:
+    bool   m_btable;
+    string m_jsonpath;
+};
 
+//=============================================================================================================
 
-// ----------------------------------------------------------------------------------------
-void DumpArm9Stuff( const string & arm9path, const string & targetdir )
+void PrintUsage()
 {
-    vector<uint8_t> fdat( LoadFile(arm9path) );
-    auto            itbeg = fdat.begin();
-    auto            itend = fdat.end();
-    ofstream        out( targetdir + "/" + "arm9.txt" );
-
-    DumpEntitySymbolsEoS( itbeg, itend, out );
-    DumpEventListEoS    ( itbeg, itend, out );
+    cout <<"Usage:\n"
+         <<"  pmd2_eventTableLister\n"
+         <<"      Dumps arm9.bin and overlay_0011.bin from the working directory into \"Dumped\".\n"
+         <<"  pmd2_eventTableLister --rom <game.nds> [--out <dir>]\n"
+         <<"      Dumps arm9 and overlay 11 straight from a NDS ROM image.\n"
+         <<"  pmd2_eventTableLister --batch <romsdir|manifest.txt> [--out <dir>] [--jobs <n>] [--corpus-stats <file>] [--pipeline]\n"
+         <<"      Dumps every NDS ROM image and extracted ROM found under romsdir, or listed in the manifest,\n"
+         <<"      into its own sub-directory of the output directory.\n"
+         <<"      --corpus-stats also writes the value distributions of every field over the whole batch.\n"
+         <<"      --pipeline reads the next files ahead, and writes the output on a background thread, while\n"
+         <<"      the current files are parsed. Faster on slow or network storage.\n"
+         <<"  pmd2_eventTableLister --scan\n"
+         <<"      Lists the symbol tables found by scanning arm9.bin and overlay_0011.bin in the working directory.\n"
+         <<"  pmd2_eventTableLister --query [--rom <game.nds>]\n"
+         <<"      Indexes every table, then answers queries read from the standard input, one per line:\n"
+         <<"      \"<field>=<value>\" finds rows by field value, anything else finds rows by symbol.\n"
+         <<"  pmd2_eventTableLister --diff <base> <other>\n"
+         <<"      Lists the rows added, removed and changed between two ROMs. Each one is either a NDS ROM\n"
+         <<"      image or an extracted ROM directory. Rows are matched by symbol.\n"
+         <<"  pmd2_eventTableLister --batch <romsdir|manifest.txt> --diff-against <base> [--out <dir>] [--jobs <n>]\n"
+         <<"      Diffs every ROM of the batch against the base, into a diff.txt in each ROM's output directory.\n"
+         <<"  pmd2_eventTableLister --patch <patch.csv|patch.jsonl> [--rom <game.nds> | --batch <romsdir|manifest.txt> [--jobs <n>]]\n"
+         <<"      Edits table fields in place, in arm9.bin and overlay_0011.bin in the working directory, in a NDS\n"
+         <<"      ROM image, or in every ROM of a batch. Each line of the patch is a change, with a \"table\" id,\n"
+         <<"      a \"row\" index or row \"offset\", a \"field\" name and a \"value\", named as in the csv and jsonl\n"
+         <<"      outputs. Every change is validated before anything is written. Compressed binaries are refused.\n"
+         <<"  pmd2_eventTableLister --watch [--rom <game.nds>] [--out <dir>] [--poll]\n"
+         <<"      Dumps the tables as text, then dumps them again each time the input files are saved, until\n"
+         <<"      stopped. Only the tables whose records or strings changed are decoded again. Changes are\n"
+         <<"      detected with inotify where available, or by polling the files, which --poll forces.\n"
+         <<"  pmd2_eventTableLister --join <table>.<column>=<table>.<column> [--join ..] [--rom <game.nds> | --batch <romsdir|manifest.txt> [--out <dir>] [--jobs <n>]]\n"
+         <<"      Matches the rows of the left table to the rows of the right table with the same value in the\n"
+         <<"      given columns, and lists the matches, the left rows matching nothing (dangling), and the right\n"
+         <<"      rows nothing matches (unused). Tables and columns are named as in the csv and jsonl outputs, and\n"
+         <<"      the \"symbol\" column is the string of the row. Ex: --join event_list_table.unk3=entity_symbol_list_table.entityid\n"
+         <<"      In batch mode, each ROM's results go to joins.txt in its output directory, and the totals are printed.\n"
+         <<"  pmd2_eventTableLister --scripts [--rom <game.nds> | --script-dir <dir>]\n"
+         <<"      Lists the script files each row of the event sub-file list and event list tables links to, with\n"
+         <<"      their size and hash, the rows with no files, and the files no row links to. Sub-file list rows\n"
+         <<"      link to the files named after their symbol, event list rows to the directory named after theirs.\n"
+         <<"      The SCRIPT directory is looked for in the working directory and its \"data\" sub-directory.\n"
+         <<"  pmd2_eventTableLister --identify [--rom <game.nds> | --batch <romsdir|manifest.txt> [--jobs <n>]]\n"
+         <<"      Tells which game, region and build each ROM is, from the game code in its header, the byte\n"
+         <<"      patterns of the signature files found in its binaries, and whether its tables are where a\n"
+         <<"      build keeps them. In batch mode, also counts the ROMs of each build. Every dump and index\n"
+         <<"      picks the table locations and load addresses of the build it identified the same way.\n"
+         <<"  pmd2_eventTableLister --coverage [--rom <game.nds> | --batch <romsdir|manifest.txt> [--jobs <n>]] [--out <dir>]\n"
+         <<"      Maps which bytes of the unpacked arm9 and overlay 11 the tables and their strings account for,\n"
+         <<"      and writes the ranges nothing accounts for to arm9.coverage.txt and overlay_0011.coverage.txt.\n"
+         <<"      In batch mode, also writes coverage.txt in the output directory, with every gap and the number\n"
+         <<"      of ROMs that have it, the most shared first, to find the next table to document.\n"
+         <<"  pmd2_eventTableLister --bench-blz <file>\n"
+         <<"      Measures BLZ decompression throughput on a binary. Uncompressed binaries are compressed first.\n"
+         <<"Options:\n"
+         <<"  --format <text|csv|jsonl|bin>\n"
+         <<"      Output format of the dumps. Defaults to text.\n"
+         <<"  --jobs <n>\n"
+         <<"      Number of threads to dump files and tables on. Defaults to the number of hardware threads.\n"
+         <<"  --signatures <file>\n"
+         <<"      Loads more builds to identify, with their table locations, from a signature file. Can be\n"
+         <<"      repeated. Only Explorers of Sky (NA)'s table locations are bundled.\n"
+         <<"  --store <dir>\n"
+         <<"      Keeps the text of each table once in a shared store, named after the hash of its content, and\n"
+         <<"      writes arm9.manifest and overlay_0011.manifest listing the stored tables of each binary instead\n"
+         <<"      of arm9.txt and overlay_0011.txt. Tables already stored aren't decoded or written again, so a\n"
+         <<"      batch of mostly identical ROMs only writes the tables that differ. The text dump of a binary is\n"
+         <<"      its stored tables concatenated in order: cd <dir> && xargs cat < <out>/arm9.manifest\n"
+         <<"  --no-cache\n"
+         <<"      Don't reuse the text output of unchanged tables from the previous run.\n"
+         <<"  --profile\n"
+         <<"      Prints the time spent in each stage, and the bytes and records processed, per file and per table.\n"
+         <<"  --profile-json <file>\n"
+         <<"      Writes the same profile as JSON.\n"
+         ;
 }
 
-
-void DumpOverlay0011Stuff( const string & overlay11path, const string & targetdir )
+int main( int argc, const char * argv[] )
 {
-    vector<uint8_t> fdat( LoadFile(overlay11path) );
-    auto            itbeg = fdat.begin();
-    auto            itend = fdat.end();
-    ofstream        out( targetdir + "/" + "overlay_0011.txt" );
+    string batchsrc;
+    string rompath;
+    string outdir    = "Dumped";
+    string corpusstatspath;
+    string diffbase;
+    string diffother;
+    DumpOptions opts;
+    size_t nbthreads = std::thread::hardware_concurrency();
+    bool   bscanonly = false;
+    bool   bquery    = false;
+    bool   bprofile  = false;
+    bool   bpipeline = false;
+    string blzbenchpath;
+    string profilejsonpath;
+    string patchpath;
+    bool   bscripts  = false;
+    string scriptdir;
+    vector<JoinSpec> joins;
+    bool   bwatch    = false;
+    bool   bpollonly = false;
+    bool   bidentify = false;
+    bool   bcoverage = false;
+    string storedir;
+    BuildDatabase builds;
+    unique_ptr<TableStore> pstore;
+
+    try
+    {
+        for( int i = 1; i < argc; ++i )
+        {
+            const string arg     = argv[i];
+            const bool   hasnext = (i + 1) < argc;
+            if( arg == "--batch" && hasnext )
+                batchsrc = argv[++i];
+            else if( arg == "--rom" && hasnext )
+                rompath = argv[++i];
+            else if( arg == "--out" && hasnext )
+                outdir = argv[++i];
+            else if( arg == "--corpus-stats" && hasnext )
+                corpusstatspath = argv[++i];
+            else if( arg == "--jobs" && hasnext )
+                nbthreads = std::stoul( argv[++i] );
+            else if( arg == "--format" && hasnext )
+                opts.fmt = ParseOutFmt( argv[++i] );
+            else if( arg == "--patch" && hasnext )
+                patchpath = argv[++i];
+            else if( arg == "--bench-blz" && hasnext )
+                blzbenchpath = argv[++i];
+            else if( arg == "--diff" && (i + 2) < argc )
+            {
+                diffbase  = argv[++i];
+                diffother = argv[++i];
+            }
+            else if( arg == "--diff-against" && hasnext )
+                diffbase = argv[++i];
+            else if( arg == "--no-cache" )
+                opts.busecache = false;
+            else if( arg == "--pipeline" )
+                bpipeline = true;
+            else if( arg == "--profile" )
+                bprofile = true;
+            else if( arg == "--profile-json" && hasnext )
+                profilejsonpath = argv[++i];
+            else if( arg == "--join" && hasnext )
+                joins.push_back( ParseJoinSpec( argv[++i] ) );
+            else if( arg == "--script-dir" && hasnext )
+                scriptdir = argv[++i];
+            else if( arg == "--scripts" )
+                bscripts = true;
+            else if( arg == "--watch" )
+                bwatch = true;
+            else if( arg == "--poll" )
+                bpollonly = true;
+            else if( arg == "--signatures" && hasnext )
+                builds.LoadSignatureFile( argv[++i] );
+            else if( arg == "--identify" )
+                bidentify = true;
+            else if( arg == "--coverage" )
+                bcoverage = true;
+            else if( arg == "--store" && hasnext )
+                storedir = argv[++i];
+            else if( arg == "--query" )
+                bquery = true;
+            else if( arg == "--scan" )
+                bscanonly = true;
+            else
+            {
+                PrintUsage();
+                return (arg == "--help" || arg == "-h")? 0 : 1;
+            }
+        }
+        ProfileReport profilereport( bprofile, profilejsonpath );
+        opts.pbuilds = &builds;
+        BufferPool decompbuffers;
+        opts.pbuffers = &decompbuffers;
+        if( !storedir.empty() )
+        {
+            if( opts.fmt != eOutFmt::Text )
+                throw runtime_error("--store only works with the text format!");
+            pstore      = make_unique<TableStore>(storedir);
+            opts.pstore = pstore.get();
+        }
 
-    DumpEventSubFileListEoS( itbeg, itend, out );
-    DumpSpecialListEoS     ( itbeg, itend, out );
-}
+        if( bidentify )
+        {
+            if( !batchsrc.empty() )
+            {
+                vector<RomJob> jobs     = LoadBatchJobs( batchsrc, outdir );
+                size_t         nbfailed = RunBatchIdentify( jobs, nbthreads, builds );
+                cout <<"Done! " <<nbfailed <<" job(s) failed.\n";
+                return (nbfailed == 0)? 0 : 1;
+            }
+            PrintRomIdentity( cout, JobDisplayName(rompath), IdentifyRom( MakeSingleJob(rompath), builds ) );
+            return 0;
+        }
 
+        if( bcoverage )
+        {
+            if( !batchsrc.empty() )
+            {
+                vector<RomJob> jobs     = LoadBatchJobs( batchsrc, outdir );
+                size_t         nbfailed = RunBatchCoverage( jobs, nbthreads, builds, outdir );
+                cout <<"Done! " <<nbfailed <<" job(s) failed.\n";
+                return (nbfailed == 0)? 0 : 1;
+            }
+            fs::create_directories(outdir);
+            WriteRomCoverage( cout, JobDisplayName(rompath), CoverRom( MakeSingleJob(rompath), builds ), outdir );
+            return 0;
+        }
 
-//=============================================================================================================
+        if( !patchpath.empty() )
+        {
+            vector<TablePatch> patches = LoadTablePatches( patchpath );
+            CheckPatchTables( patches, patchpath );
+            if( !batchsrc.empty() )
+            {
+                vector<RomJob> jobs     = LoadBatchJobs( batchsrc, outdir );
+                size_t         nbfailed = RunBatchPatch( jobs, nbthreads, patches, patchpath, builds );
+                cout <<"Done! " <<nbfailed <<" job(s) failed.\n";
+                return (nbfailed == 0)? 0 : 1;
+            }
+            PrintPatchResult( cout, JobDisplayName(rompath), PatchRomJob( MakeSingleJob(rompath), patches, patchpath, builds ) );
+            return 0;
+        }
 
-int main( int argc, const char * argv[] )
-{
-    system("mkdir \"Dumped\"");
-    cout <<"Dumping arm9.bin constants..\n";
-    DumpArm9Stuff       ( "arm9.bin",         "Dumped" );
-    cout <<"Dumping overlay_0011.bin constants..\n";
-    DumpOverlay0011Stuff( "overlay_0011.bin", "Dumped" );
-    cout <<"Done!\n";
+        if( !joins.empty() )
+        {
+            if( !batchsrc.empty() )
+            {
+                vector<RomJob> jobs     = LoadBatchJobs( batchsrc, outdir );
+                size_t         nbfailed = RunBatchJoin( jobs, nbthreads, joins, builds );
+                cout <<"Done! " <<nbfailed <<" job(s) failed.\n";
+                return (nbfailed == 0)? 0 : 1;
+            }
+            SymbolIndex index = BuildSymbolIndex( rompath, "arm9.bin", "overlay_0011.bin", builds );
+            RunJoins( index, joins, cout );
+            return 0;
+        }
+
+        if( !batchsrc.empty() && !diffbase.empty() )
+        {
+            vector<RomJob> jobs     = LoadBatchJobs( batchsrc, outdir );
+            SymbolIndex    base     = IndexRomSource( diffbase, builds );
+            size_t         nbfailed = RunBatchDiff( jobs, nbthreads, base, builds );
+            cout <<"Done! " <<nbfailed <<" job(s) failed.\n";
+            return (nbfailed == 0)? 0 : 1;
+        }
+
+        if( !diffother.empty() )
+        {
+            SymbolIndex base  = IndexRomSource( diffbase, builds );
+            SymbolIndex other = IndexRomSource( diffother, builds );
+            DiffSummary summary = DiffTableSets( base, other, cout );
+            PrintDiffSummary( cerr, diffother, summary );
+            return 0;
+        }
+
+        if( !batchsrc.empty() )
+        {
+            vector<RomJob> jobs = LoadBatchJobs( batchsrc, outdir );
+            TablesStats    corpusstats;
+            TablesStats *  pstats   = corpusstatspath.empty()? nullptr : &corpusstats;
+            size_t         nbfailed = bpipeline? RunBatchPipelined( jobs, nbthreads, opts, pstats ) : RunBatch( jobs, nbthreads, opts, pstats );
+            if( !corpusstatspath.empty() )
+            {
+                ofstream statsout( corpusstatspath );
+                statsout << corpusstats.Print();
+            }
+            if( pstore != nullptr )
+                PrintStoreSummary( cout, *pstore );
+            cout <<"Done! " <<nbfailed <<" job(s) failed.\n";
+            return (nbfailed == 0)? 0 : 1;
+        }
+
+        if( !blzbenchpath.empty() )
+        {
+            BenchmarkBLZ( blzbenchpath );
+            return 0;
+        }
+
+        if( bwatch )
+        {
+            RunWatch( rompath, "arm9.bin", "overlay_0011.bin", outdir, builds, nbthreads, bpollonly );
+            return 0;
+        }
+
+        if( bscripts )
+        {
+            if( rompath.empty() && scriptdir.empty() )
+                scriptdir = FindScriptDir( fs::current_path() );
+            if( rompath.empty() && scriptdir.empty() )
+                throw runtime_error("Couldn't find the SCRIPT directory in the working directory! Use --script-dir to point to it.");
+            ReportScripts( rompath, "arm9.bin", "overlay_0011.bin", scriptdir, builds, nbthreads, cout );
+            return 0;
+        }
+
+        if( bquery )
+        {
+            SymbolIndex index = BuildSymbolIndex( rompath, "arm9.bin", "overlay_0011.bin", builds );
+            RunQueryLoop( index, cin, cout );
+            return 0;
+        }
+
+        if( bscanonly )
+        {
+            ReportFoundLUTs( "arm9.bin",         Arm9BinLoadOffset );
+            ReportFoundLUTs( "overlay_0011.bin", Overlay_0011LoadOffset );
+            return 0;
+        }
+
+        fs::create_directories(outdir);
+        //The files and their tables are dumped in parallel, the output is the same as a sequential run
+        unique_ptr<ThreadPool> ppool;
+        if( nbthreads > 1 )
+        {
+            ppool = make_unique<ThreadPool>(nbthreads);
+            opts.ptablepool = ppool.get();
+        }
+        if( !rompath.empty() )
+        {
+            cout <<"Dumping " <<rompath <<" constants..\n";
+            DumpNdsRomStuff( rompath, outdir, opts );
+            if( pstore != nullptr )
+                PrintStoreSummary( cout, *pstore );
+            cout <<"Done!\n";
+            return 0;
+        }
+
+        TaskGroup files( opts.ptablepool );
+        cout <<"Dumping arm9.bin and overlay_0011.bin constants..\n";
+        files.Run( [&](){ DumpArm9Stuff       ( "arm9.bin",         outdir, opts ); } );
+        files.Run( [&](){ DumpOverlay0011Stuff( "overlay_0011.bin", outdir, opts ); } );
+        files.Wait();
+        if( pstore != nullptr )
+            PrintStoreSummary( cout, *pstore );
+        cout <<"Done!\n";
+    }
+    catch( const std::exception & e )
+    {
+        cerr <<"<!>- Error: " <<e.what() <<"\n";
+        return 1;
+    }
     return 0;
-}
\ No newline at end of file
+}
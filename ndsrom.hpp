@@ -0,0 +1,254 @@
+#ifndef NDSROM_HPP
+#define NDSROM_HPP
+/*
+ndsrom.hpp
+    Minimal read-only access to the content of a NDS ROM image, without extracting anything.
+
+    Parses the cartridge header, the ARM9 overlay table (y9), the file allocation table (FAT),
+    and the file name table (FNT). Every file is returned as a range of bytes inside the image.
+*/
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*
+    ByteRange
+        A range of bytes inside an image. Doesn't own anything.
+*/
+struct ByteRange
+{
+    const uint8_t * pbeg = nullptr;
+    const uint8_t * pend = nullptr;
+
+    inline const uint8_t * begin()const { return pbeg; }
+    inline const uint8_t * end  ()const { return pend; }
+    inline size_t          size ()const { return static_cast<size_t>(pend - pbeg); }
+    inline bool            empty()const { return pbeg == pend; }
+};
+
+/*
+    NdsOverlayInfo
+        An entry of the ARM9 overlay table.
+*/
+struct NdsOverlayInfo
+{
+    uint32_t  ovlid       = 0;
+    uint32_t  ramaddr     = 0;  //Address the overlay is loaded at
+    uint32_t  ramsize     = 0;
+    uint32_t  bsssize     = 0;
+    uint32_t  fileid      = 0;
+    uint32_t  compsize    = 0;  //Size of the overlay file when compressed
+    bool      bcompressed = false;
+    ByteRange data;
+};
+
+/*
+    NdsRom
+        View over a whole NDS ROM image. The image must outlive the NdsRom.
+*/
+class NdsRom
+{
+public:
+    //Offsets in the cartridge header
+    static constexpr size_t   HeaderLen          = 0x200;
+    static constexpr size_t   OffsGameCode       = 0x0C;
+    static constexpr size_t   OffsArm9RomOffset  = 0x20;
+    static constexpr size_t   OffsArm9RamAddr    = 0x28;
+    static constexpr size_t   OffsArm9Size       = 0x2C;
+    static constexpr size_t   OffsFNTOffset      = 0x40;
+    static constexpr size_t   OffsFNTSize        = 0x44;
+    static constexpr size_t   OffsFATOffset      = 0x48;
+    static constexpr size_t   OffsFATSize        = 0x4C;
+    static constexpr size_t   OffsOvT9Offset     = 0x50;
+    static constexpr size_t   OffsOvT9Size       = 0x54;
+    static constexpr size_t   OverlayEntryLen    = 32;
+    static constexpr size_t   FATEntryLen        = 8;
+    static constexpr size_t   FNTDirEntryLen     = 8;
+    static constexpr uint16_t FNTRootDirId       = 0xF000;
+    static constexpr uint32_t OvlFlagCompressed  = 0x01000000;
+
+    NdsRom( const uint8_t * beg, const uint8_t * end )
+        :m_beg(beg), m_end(end)
+    {
+        if( Size() < HeaderLen )
+            throw std::runtime_error("NdsRom::NdsRom(): The image is too small to be a NDS ROM!");
+    }
+
+    //The 4 characters game code. Ex: "C2SE"
+    std::string GameCode()const
+    {
+        return std::string( reinterpret_cast<const char*>(m_beg + OffsGameCode), 4 );
+    }
+
+    uint32_t Arm9RamAddress()const
+    {
+        return ReadU32(OffsArm9RamAddr);
+    }
+
+    ByteRange Arm9()const
+    {
+        return Range( ReadU32(OffsArm9RomOffset), ReadU32(OffsArm9Size), "arm9" );
+    }
+
+    size_t NbOverlays()const
+    {
+        return ReadU32(OffsOvT9Size) / OverlayEntryLen;
+    }
+
+    NdsOverlayInfo Overlay( uint32_t ovlid )const
+    {
+        if( ovlid >= NbOverlays() )
+            throw std::runtime_error("NdsRom::Overlay(): The ROM has no overlay " + std::to_string(ovlid) + "!");
+
+        ByteRange      ovt = Range( ReadU32(OffsOvT9Offset), ReadU32(OffsOvT9Size), "overlay table" );
+        const size_t   entoff = static_cast<size_t>(ovt.begin() - m_beg) + (ovlid * OverlayEntryLen);
+        NdsOverlayInfo ovl;
+        ovl.ovlid       = ReadU32( entoff );
+        ovl.ramaddr     = ReadU32( entoff + 0x04 );
+        ovl.ramsize     = ReadU32( entoff + 0x08 );
+        ovl.bsssize     = ReadU32( entoff + 0x0C );
+        ovl.fileid      = ReadU32( entoff + 0x18 );
+        const uint32_t sizeandflags = ReadU32( entoff + 0x1C );
+        ovl.compsize    = sizeandflags & 0x00FFFFFF;
+        ovl.bcompressed = (sizeandflags & OvlFlagCompressed) != 0;
+        ovl.data        = File( ovl.fileid );
+        return ovl;
+    }
+
+    size_t NbFiles()const
+    {
+        return ReadU32(OffsFATSize) / FATEntryLen;
+    }
+
+    //The content of a file, from its FAT entry
+    ByteRange File( uint32_t fileid )const
+    {
+        if( fileid >= NbFiles() )
+            throw std::runtime_error("NdsRom::File(): File id " + std::to_string(fileid) + " is past the end of the FAT!");
+        const size_t   entoff  = ReadU32(OffsFATOffset) + (fileid * FATEntryLen);
+        const uint32_t filebeg = ReadU32( entoff );
+        const uint32_t fileend = ReadU32( entoff + 4 );
+        if( fileend < filebeg )
+            throw std::runtime_error("NdsRom::File(): File id " + std::to_string(fileid) + " has a negative size!");
+        return Range( filebeg, fileend - filebeg, "file " + std::to_string(fileid) );
+    }
+
+    /*
+        ForEachFile
+            Walks the file name table, and calls "fun( path, fileid )" for every file.
+            Paths use '/' as separator and have no leading slash. Ex: "SCRIPT/COMMON/unionall.ssb"
+    */
+    void ForEachFile( const std::function<void(const std::string &, uint16_t)> & fun )const
+    {
+        const ByteRange fnt = Range( ReadU32(OffsFNTOffset), ReadU32(OffsFNTSize), "FNT" );
+        if( fnt.size() < FNTDirEntryLen )
+            throw std::runtime_error("NdsRom::ForEachFile(): The FNT is too small!");
+
+        const size_t fntoff = static_cast<size_t>(fnt.begin() - m_beg);
+        const size_t nbdirs = ReadU16( fntoff + 6 );
+        if( nbdirs == 0 || (nbdirs * FNTDirEntryLen) > fnt.size() )
+            throw std::runtime_error("NdsRom::ForEachFile(): The FNT has an invalid number of directories!");
+
+        std::vector<std::pair<uint16_t, std::string>> dirstack { { FNTRootDirId, std::string() } };
+        size_t nbvisited = 0;
+        while( !dirstack.empty() )
+        {
+            auto [dirid, dirpath] = std::move(dirstack.back());
+            dirstack.pop_back();
+
+            const size_t diridx = dirid - FNTRootDirId;
+            if( dirid < FNTRootDirId || diridx >= nbdirs || ++nbvisited > nbdirs )
+                throw std::runtime_error("NdsRom::ForEachFile(): Invalid directory id in the FNT!");
+
+            size_t   curoff = fntoff + ReadU32( fntoff + (diridx * FNTDirEntryLen) );
+            uint16_t fileid = ReadU16( fntoff + (diridx * FNTDirEntryLen) + 4 );
+            for(;;)
+            {
+                const uint8_t lenandtype = ReadU8( curoff++ );
+                if( lenandtype == 0 )
+                    break;
+                const size_t namelen = lenandtype & 0x7F;
+                std::string  name    = dirpath + ReadName( curoff, namelen );
+                curoff += namelen;
+
+                if( lenandtype & 0x80 )
+                {
+                    dirstack.emplace_back( ReadU16(curoff), name + "/" );
+                    curoff += 2;
+                }
+                else
+                    fun( name, fileid++ );
+            }
+        }
+    }
+
+    /*
+        FindFile
+            Returns the file id of the file at "path", or -1 if there's none.
+    */
+    int FindFile( const std::string & path )const
+    {
+        int found = -1;
+        ForEachFile( [&]( const std::string & curpath, uint16_t fileid )
+        {
+            if( found == -1 && curpath == path )
+                found = fileid;
+        });
+        return found;
+    }
+
+    inline const uint8_t * begin()const { return m_beg; }
+    inline const uint8_t * end  ()const { return m_end; }
+    inline size_t          Size ()const { return static_cast<size_t>(m_end - m_beg); }
+
+private:
+    ByteRange Range( size_t offset, size_t len, const std::string & what )const
+    {
+        if( offset > Size() || len > (Size() - offset) )
+            throw std::runtime_error("NdsRom: The " + what + " goes past the end of the ROM!");
+        ByteRange rng;
+        rng.pbeg = m_beg + offset;
+        rng.pend = rng.pbeg + len;
+        return rng;
+    }
+
+    inline void CheckRead( size_t offset, size_t len )const
+    {
+        if( offset > Size() || len > (Size() - offset) )
+            throw std::runtime_error("NdsRom: Tried to read past the end of the ROM!");
+    }
+
+    inline uint8_t ReadU8( size_t offset )const
+    {
+        CheckRead(offset, 1);
+        return m_beg[offset];
+    }
+
+    inline uint16_t ReadU16( size_t offset )const
+    {
+        CheckRead(offset, 2);
+        return static_cast<uint16_t>( m_beg[offset] | (m_beg[offset + 1] << 8) );
+    }
+
+    inline uint32_t ReadU32( size_t offset )const
+    {
+        CheckRead(offset, 4);
+        return static_cast<uint32_t>(m_beg[offset]) | (static_cast<uint32_t>(m_beg[offset + 1]) << 8) |
+              (static_cast<uint32_t>(m_beg[offset + 2]) << 16) | (static_cast<uint32_t>(m_beg[offset + 3]) << 24);
+    }
+
+    inline std::string ReadName( size_t offset, size_t len )const
+    {
+        CheckRead(offset, len);
+        return std::string( reinterpret_cast<const char*>(m_beg + offset), len );
+    }
+
+private:
+    const uint8_t * m_beg;
+    const uint8_t * m_end;
+};
+
+#endif
@@ -0,0 +1,339 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+/*
+profiler.hpp
+    Per-stage timers and counters, enabled at runtime with --profile.
+
+    Timings and counts are attributed to the current scope, usually a file ("arm9") or a table
+    ("Event List Table"). Each thread accumulates into its own records without locking, and the
+    records of every thread are merged by scope name for the report, so a batch run shows the
+    totals over every file.
+
+    Build with PMD2_PROFILING=0 to compile all the instrumentation out.
+*/
+#ifndef PMD2_PROFILING
+    #define PMD2_PROFILING 1
+#endif
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace prof
+{
+    enum struct eStage : uint8_t
+    {
+        LoadFile,       //Opening and mapping input files
+        Unpack,         //BLZ decompression
+        Locate,         //Validating or scanning for table locations
+        Decode,         //Decoding records
+        FetchString,    //Fetching the symbols
+        Stats,          //Gathering field statistics
+        Format,         //Formatting rows in the output sink
+        Finish,         //Writing and flushing the output
+        NbStages,
+    };
+
+    enum struct eCounter : uint8_t
+    {
+        BytesRead,
+        RecordsDecoded,
+        StringsFetched,
+        BytesWritten,
+        NbCounters,
+    };
+
+    const size_t NbStages   = static_cast<size_t>(eStage::NbStages);
+    const size_t NbCounters = static_cast<size_t>(eCounter::NbCounters);
+
+    inline const char * StageName( size_t stage )
+    {
+        static const char * Names[NbStages] = { "load_file", "unpack", "locate", "decode", "fetch_string", "stats", "format", "finish" };
+        return Names[stage];
+    }
+
+    inline const char * CounterName( size_t counter )
+    {
+        static const char * Names[NbCounters] = { "bytes_read", "records_decoded", "strings_fetched", "bytes_written" };
+        return Names[counter];
+    }
+
+    struct Record
+    {
+        std::array<uint64_t, NbStages>   ns       {};
+        std::array<uint64_t, NbCounters> counters {};
+
+        void Merge( const Record & other )
+        {
+            for( size_t i = 0; i < NbStages; ++i )
+                ns[i] += other.ns[i];
+            for( size_t i = 0; i < NbCounters; ++i )
+                counters[i] += other.counters[i];
+        }
+    };
+
+    typedef std::vector<std::pair<std::string, Record>> scoperecords_t;
+
+    /*
+        Profiler
+            Owns the records of every thread that ever profiled something, so they outlive the threads.
+            The report must only be made once the profiled threads are done.
+    */
+    class Profiler
+    {
+    public:
+        static Profiler & Instance()
+        {
+            static Profiler s_instance;
+            return s_instance;
+        }
+
+        inline void Enable( bool benable )  { m_benabled.store( benable, std::memory_order_relaxed ); }
+        inline bool IsEnabled()const        { return m_benabled.load( std::memory_order_relaxed ); }
+
+        //The calling thread's record for the current scope
+        Record & Current()
+        {
+            ThreadData & data = Local();
+            return data.scopes[data.curscope].second;
+        }
+
+        //Makes "name" the calling thread's current scope, and returns the previous one
+        size_t EnterScope( const std::string & name )
+        {
+            ThreadData & data = Local();
+            const size_t prev = data.curscope;
+            for( size_t i = 0; i < data.scopes.size(); ++i )
+            {
+                if( data.scopes[i].first == name )
+                {
+                    data.curscope = i;
+                    return prev;
+                }
+            }
+            data.scopes.emplace_back( name, Record() );
+            data.curscope = data.scopes.size() - 1;
+            return prev;
+        }
+
+        inline void LeaveScope( size_t prev ) { Local().curscope = prev; }
+
+        //Name of the calling thread's current scope, so tasks it hands off can record into the same one
+        const std::string & CurrentScope()
+        {
+            ThreadData & data = Local();
+            return data.scopes[data.curscope].first;
+        }
+
+        //The records of all threads, merged by scope, in the order the scopes were first seen
+        scoperecords_t Collect()
+        {
+            std::lock_guard<std::mutex> lk(m_threadsmtx);
+            scoperecords_t merged;
+            for( const auto & pdata : m_threads )
+            {
+                for( const auto & scope : pdata->scopes )
+                {
+                    auto itfound = merged.begin();
+                    for( ; itfound != merged.end() && itfound->first != scope.first; ++itfound );
+                    if( itfound == merged.end() )
+                        merged.push_back(scope);
+                    else
+                        itfound->second.Merge(scope.second);
+                }
+            }
+            //Drop scopes where nothing was recorded
+            scoperecords_t kept;
+            for( auto & scope : merged )
+            {
+                bool bempty = true;
+                for( uint64_t v : scope.second.ns )       bempty = bempty && (v == 0);
+                for( uint64_t v : scope.second.counters ) bempty = bempty && (v == 0);
+                if( !bempty )
+                    kept.push_back( std::move(scope) );
+            }
+            return kept;
+        }
+
+    private:
+        struct ThreadData
+        {
+            scoperecords_t scopes { { "(other)", Record() } };
+            size_t         curscope = 0;
+        };
+
+        ThreadData & Local()
+        {
+            static thread_local ThreadData * t_pdata = nullptr;
+            if( t_pdata == nullptr )
+            {
+                std::lock_guard<std::mutex> lk(m_threadsmtx);
+                m_threads.push_back( std::make_unique<ThreadData>() );
+                t_pdata = m_threads.back().get();
+            }
+            return *t_pdata;
+        }
+
+        std::atomic<bool>                        m_benabled {false};
+        std::mutex                               m_threadsmtx;
+        std::vector<std::unique_ptr<ThreadData>> m_threads;
+    };
+
+    inline bool IsEnabled() { return Profiler::Instance().IsEnabled(); }
+
+    inline std::string CurrentScopeName()
+    {
+        return IsEnabled()? Profiler::Instance().CurrentScope() : std::string();
+    }
+
+    inline void AddCount( eCounter counter, uint64_t n )
+    {
+        if( IsEnabled() )
+            Profiler::Instance().Current().counters[static_cast<size_t>(counter)] += n;
+    }
+
+    /*
+        ScopedContext
+            Attributes everything recorded on this thread to "name" until it goes out of scope.
+    */
+    class ScopedContext
+    {
+    public:
+        explicit ScopedContext( const std::string & name )
+            :m_benabled( IsEnabled() ), m_prev(0)
+        {
+            if( m_benabled )
+                m_prev = Profiler::Instance().EnterScope(name);
+        }
+
+        ~ScopedContext()
+        {
+            if( m_benabled )
+                Profiler::Instance().LeaveScope(m_prev);
+        }
+
+        ScopedContext( const ScopedContext & )             = delete;
+        ScopedContext & operator=( const ScopedContext & ) = delete;
+
+    private:
+        bool   m_benabled;
+        size_t m_prev;
+    };
+
+    /*
+        ScopedTimer
+            Adds the time until it goes out of scope to a stage of the current scope.
+            Loops can check IsEnabled() once and pass the result, to keep the disabled case cheap.
+    */
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer( eStage stage, bool benabled = IsEnabled() )
+            :m_precord(nullptr), m_stage(stage)
+        {
+            if( benabled )
+            {
+                m_precord = &Profiler::Instance().Current();
+                m_start   = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~ScopedTimer()
+        {
+            if( m_precord != nullptr )
+                m_precord->ns[static_cast<size_t>(m_stage)] += static_cast<uint64_t>( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - m_start ).count() );
+        }
+
+        ScopedTimer( const ScopedTimer & )             = delete;
+        ScopedTimer & operator=( const ScopedTimer & ) = delete;
+
+    private:
+        Record *                              m_precord;
+        eStage                                m_stage;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    // ----------------------------------------------------------------------------------------
+    /*
+        PrintReport
+            Table of the time spent in each stage in milliseconds, and of the counters, for each scope.
+    */
+    inline void PrintReport( std::ostream & out, const scoperecords_t & scopes )
+    {
+        const int namew  = 28;
+        const int stagew = 13;
+        Record    total;
+        auto lambdaPrintRow = [&]( const std::string & name, const Record & rec )
+        {
+            out <<std::left <<std::setw(namew) <<name <<std::right <<std::fixed <<std::setprecision(3);
+            for( size_t i = 0; i < NbStages; ++i )
+                out <<std::setw(stagew) <<( static_cast<double>(rec.ns[i]) / 1e6 );
+            for( size_t i = 0; i < NbCounters; ++i )
+                out <<std::setw(stagew + 4) <<rec.counters[i];
+            out <<"\n";
+        };
+
+        out <<"Profile (times in ms)\n" <<std::left <<std::setw(namew) <<"scope" <<std::right;
+        for( size_t i = 0; i < NbStages; ++i )
+            out <<std::setw(stagew) <<StageName(i);
+        for( size_t i = 0; i < NbCounters; ++i )
+            out <<std::setw(stagew + 4) <<CounterName(i);
+        out <<"\n" <<std::string( namew + (NbStages * stagew) + (NbCounters * (stagew + 4)), '-' ) <<"\n";
+        for( const auto & scope : scopes )
+        {
+            lambdaPrintRow( scope.first, scope.second );
+            total.Merge( scope.second );
+        }
+        lambdaPrintRow( "total", total );
+    }
+
+    //Same as PrintReport, as a JSON object
+    inline void PrintReportJson( std::ostream & out, const scoperecords_t & scopes )
+    {
+        out <<"{\n  \"times_ns\": \"per stage\",\n  \"scopes\": [\n";
+        for( size_t s = 0; s < scopes.size(); ++s )
+        {
+            out <<"    { \"scope\": \"";
+            for( char c : scopes[s].first )
+            {
+                if( c == '"' || c == '\\' )
+                    out <<'\\';
+                out <<c;
+            }
+            out <<"\"";
+            for( size_t i = 0; i < NbStages; ++i )
+                out <<", \"" <<StageName(i) <<"_ns\": " <<scopes[s].second.ns[i];
+            for( size_t i = 0; i < NbCounters; ++i )
+                out <<", \"" <<CounterName(i) <<"\": " <<scopes[s].second.counters[i];
+            out <<" }" <<( (s + 1) < scopes.size()? "," : "" ) <<"\n";
+        }
+        out <<"  ]\n}\n";
+    }
+}
+
+#if PMD2_PROFILING
+    #define PMD2_PROF_CONCAT_IMPL(a, b) a##b
+    #define PMD2_PROF_CONCAT(a, b)      PMD2_PROF_CONCAT_IMPL(a, b)
+    //Attribute what follows in the enclosing block to the named scope
+    #define PMD2_PROF_SCOPE(name)       prof::ScopedContext PMD2_PROF_CONCAT(profscope_, __LINE__)( name )
+    //Time the rest of the enclosing block as the given stage
+    #define PMD2_PROF_TIME(stage)       prof::ScopedTimer   PMD2_PROF_CONCAT(proftimer_, __LINE__)( prof::eStage::stage )
+    //Same, but only if "benabled" is true
+    #define PMD2_PROF_TIME_IF(benabled, stage) prof::ScopedTimer PMD2_PROF_CONCAT(proftimer_, __LINE__)( prof::eStage::stage, benabled )
+    #define PMD2_PROF_COUNT(counter, n) prof::AddCount( prof::eCounter::counter, static_cast<uint64_t>(n) )
+#else
+    #define PMD2_PROF_SCOPE(name)       ((void)0)
+    #define PMD2_PROF_TIME(stage)       ((void)0)
+    #define PMD2_PROF_TIME_IF(benabled, stage) ((void)0)
+    #define PMD2_PROF_COUNT(counter, n) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,298 @@
+#ifndef SCRIPTINDEX_HPP
+#define SCRIPTINDEX_HPP
+/*
+scriptindex.hpp
+    Index of the files in the SCRIPT directory of a ROM, and links between them and the table rows.
+
+    The tree is scanned one top level directory per task, from an extracted ROM on disk or straight
+    from a NDS ROM image. Every file is mapped and hashed, so two ROMs can be compared by content.
+    Event sub-file list rows are linked to the files named after their symbol, and event list rows
+    to the directory named after theirs. Names are compared ignoring case, since the game's symbols
+    and the file system don't agree on it.
+*/
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "eventtables.hpp"
+#include "ndsrom.hpp"
+#include "tableview.hpp"
+#include "threadpool.hpp"
+#include "xxh64.hpp"
+
+/*
+    ScriptFile
+        A file under the SCRIPT directory.
+*/
+struct ScriptFile
+{
+    std::string path;       //Relative to the SCRIPT directory, '/' separated. Ex: "D01P11A/enter.sse"
+    std::string dir;        //Top level directory, empty for files right in SCRIPT. Ex: "D01P11A"
+    std::string stem;       //File name without its extension. Ex: "enter"
+    uint64_t    size = 0;
+    uint64_t    hash = 0;   //XXH64 of the content
+};
+
+/*
+    ScriptIndex
+        The files of a SCRIPT directory, sorted by path, with lookups by name and by directory.
+*/
+class ScriptIndex
+{
+public:
+    ScriptIndex() = default;
+
+    explicit ScriptIndex( std::vector<ScriptFile> files )
+        :m_files(std::move(files))
+    {
+        std::sort( m_files.begin(), m_files.end(), []( const ScriptFile & a, const ScriptFile & b ){ return a.path < b.path; } );
+        for( uint32_t i = 0; i < m_files.size(); ++i )
+        {
+            const ScriptFile & file = m_files[i];
+            m_bystem[Key(file.stem)].push_back(i);
+            if( !file.dir.empty() )
+                m_bydir[Key(file.dir)].push_back(i);
+            m_totalsize += file.size;
+        }
+    }
+
+    inline const std::vector<ScriptFile> & Files()const         { return m_files; }
+    inline size_t                          NbDirectories()const { return m_bydir.size(); }
+    inline uint64_t                        TotalSize()const     { return m_totalsize; }
+
+    //Indices of the files named "stem", or null if there are none
+    const std::vector<uint32_t> * FindStem( std::string_view stem )const
+    {
+        auto itf = m_bystem.find( Key(stem) );
+        return (itf != m_bystem.end())? &(itf->second) : nullptr;
+    }
+
+    //Indices of the files under the top level directory "dir", or null if there's no such directory
+    const std::vector<uint32_t> * FindDirectory( std::string_view dir )const
+    {
+        auto itf = m_bydir.find( Key(dir) );
+        return (itf != m_bydir.end())? &(itf->second) : nullptr;
+    }
+
+private:
+    static std::string Key( std::string_view name )
+    {
+        std::string key(name);
+        std::transform( key.begin(), key.end(), key.begin(), []( unsigned char c ){ return static_cast<char>( std::tolower(c) ); } );
+        return key;
+    }
+
+private:
+    std::vector<ScriptFile>                                 m_files;
+    std::unordered_map<std::string, std::vector<uint32_t>> m_bystem;
+    std::unordered_map<std::string, std::vector<uint32_t>> m_bydir;
+    uint64_t                                                m_totalsize = 0;
+};
+
+namespace scriptindex
+{
+    /*
+        MakeScriptFile
+            Fills in a file's names from its path relative to the SCRIPT directory, and hashes its content.
+    */
+    inline ScriptFile MakeScriptFile( std::string relpath, const uint8_t * pbeg, const uint8_t * pend )
+    {
+        ScriptFile      file;
+        const size_t    dirend  = relpath.find('/');
+        const size_t    namebeg = relpath.rfind('/');
+        const size_t    nameoff = (namebeg == std::string::npos)? 0 : (namebeg + 1);
+        const size_t    extbeg  = relpath.rfind('.');
+        if( dirend != std::string::npos )
+            file.dir = relpath.substr( 0, dirend );
+        file.stem = relpath.substr( nameoff, (extbeg == std::string::npos || extbeg < nameoff)? std::string::npos : (extbeg - nameoff) );
+        file.size = static_cast<uint64_t>(pend - pbeg);
+        file.hash = XXH64( pbeg, file.size );
+        file.path = std::move(relpath);
+        PMD2_PROF_COUNT( BytesRead, file.size );
+        return file;
+    }
+
+    inline ScriptFile LoadScriptFile( const std::filesystem::path & fpath, const std::filesystem::path & scriptdir )
+    {
+        MappedFile fdat(fpath.string());
+        return MakeScriptFile( fpath.lexically_relative(scriptdir).generic_string(), fdat.begin(), fdat.end() );
+    }
+
+    inline std::vector<ScriptFile> Concat( std::vector<std::vector<ScriptFile>> & groups )
+    {
+        std::vector<ScriptFile> files;
+        for( auto & group : groups )
+            std::move( group.begin(), group.end(), std::back_inserter(files) );
+        return files;
+    }
+}
+
+/*
+    ScanScriptTree
+        Indexes a SCRIPT directory on disk. Each top level directory is scanned and hashed on its own
+        task on the pool, or on the calling thread if there's no pool.
+*/
+inline ScriptIndex ScanScriptTree( const std::string & scriptdir, ThreadPool * ppool )
+{
+    namespace fs = std::filesystem;
+    const fs::path rootdir(scriptdir);
+    if( !fs::is_directory(rootdir) )
+        throw std::runtime_error("ScanScriptTree(): " + scriptdir + " isn't a directory!");
+
+    //The files right in the root are one more group, scanned on this thread
+    std::vector<fs::path> subdirs;
+    std::vector<fs::path> rootfiles;
+    for( const fs::directory_entry & entry : fs::directory_iterator(rootdir) )
+    {
+        if( entry.is_directory() )
+            subdirs.push_back( entry.path() );
+        else if( entry.is_regular_file() )
+            rootfiles.push_back( entry.path() );
+    }
+
+    std::vector<std::vector<ScriptFile>> groups( subdirs.size() + 1 );
+    TaskGroup                            tasks(ppool);
+    for( size_t i = 0; i < subdirs.size(); ++i )
+    {
+        tasks.Run( [&, i]()
+        {
+            for( const fs::directory_entry & entry : fs::recursive_directory_iterator(subdirs[i]) )
+            {
+                if( entry.is_regular_file() )
+                    groups[i].push_back( scriptindex::LoadScriptFile( entry.path(), rootdir ) );
+            }
+        });
+    }
+    for( const fs::path & fpath : rootfiles )
+        groups.back().push_back( scriptindex::LoadScriptFile( fpath, rootdir ) );
+    tasks.Wait();
+    return ScriptIndex( scriptindex::Concat(groups) );
+}
+
+/*
+    ScanScriptRom
+        Indexes the SCRIPT directory of a NDS ROM image, hashing each top level directory on its own task.
+*/
+inline ScriptIndex ScanScriptRom( const NdsRom & rom, ThreadPool * ppool )
+{
+    static const std::string_view ScriptDirPrefix = "SCRIPT/";
+
+    //Each run of files from the same top level directory is a group
+    std::vector<std::vector<std::pair<std::string,uint16_t>>> groupfiles;
+    std::string                                               curdir;
+    rom.ForEachFile( [&]( const std::string & path, uint16_t fileid )
+    {
+        if( path.compare( 0, ScriptDirPrefix.size(), ScriptDirPrefix ) != 0 )
+            return;
+        std::string  relpath = path.substr( ScriptDirPrefix.size() );
+        const size_t dirend  = relpath.find('/');
+        std::string  dir     = (dirend == std::string::npos)? std::string() : relpath.substr( 0, dirend );
+        if( groupfiles.empty() || dir != curdir )
+        {
+            groupfiles.emplace_back();
+            curdir = std::move(dir);
+        }
+        groupfiles.back().emplace_back( std::move(relpath), fileid );
+    });
+    if( groupfiles.empty() )
+        throw std::runtime_error("ScanScriptRom(): The ROM has no SCRIPT directory!");
+
+    std::vector<std::vector<ScriptFile>> groups( groupfiles.size() );
+    TaskGroup                            tasks(ppool);
+    for( size_t i = 0; i < groupfiles.size(); ++i )
+    {
+        tasks.Run( [&, i]()
+        {
+            for( auto & fileref : groupfiles[i] )
+            {
+                ByteRange fdat = rom.File(fileref.second);
+                groups[i].push_back( scriptindex::MakeScriptFile( std::move(fileref.first), fdat.begin(), fdat.end() ) );
+            }
+        });
+    }
+    tasks.Wait();
+    return ScriptIndex( scriptindex::Concat(groups) );
+}
+
+/*
+    ScriptLink
+        A table row, and the script files its symbol names. "pfiles" is null when there are none.
+*/
+struct ScriptLink
+{
+    uint32_t                      rowoffset = 0;
+    std::string                   symbol;
+    const std::vector<uint32_t> * pfiles    = nullptr;
+};
+
+/*
+    ScriptLinks
+        The rows of the event sub-file list and event list tables, linked to the script files.
+*/
+struct ScriptLinks
+{
+    std::vector<ScriptLink> events;         //Event sub-file list rows, linked by file name
+    std::vector<ScriptLink> levels;         //Event list rows, linked by directory
+    std::vector<uint32_t>   unused;         //Files no row links to
+    size_t                  nbeventsmissing = 0;
+    size_t                  nblevelsmissing = 0;
+};
+
+namespace scriptindex
+{
+    //Rows with a null symbol don't name anything, and are left out
+    template<class _EntryTy, class _FindFun>
+        size_t LinkRows( const TableView<_EntryTy> & view, _FindFun && findfun, std::vector<ScriptLink> & links, std::vector<bool> & used )
+    {
+        size_t nbmissing = 0;
+        links.reserve( view.size() );
+        for( const auto & row : view )
+        {
+            std::optional<std::string_view> symbol = row.Symbol();
+            if( !symbol )
+                continue;
+            ScriptLink link;
+            link.rowoffset = row.Offset();
+            link.symbol    = std::string(*symbol);
+            link.pfiles    = findfun(*symbol);
+            if( link.pfiles == nullptr )
+                ++nbmissing;
+            else
+            {
+                for( uint32_t fileidx : *link.pfiles )
+                    used[fileidx] = true;
+            }
+            links.push_back( std::move(link) );
+        }
+        return nbmissing;
+    }
+}
+
+/*
+    LinkScripts
+        Links the rows of both tables to the files of the index. The index must outlive the result.
+*/
+inline ScriptLinks LinkScripts( const ScriptIndex & scripts, const TableView<EventSubFileListEntry> & events, const TableView<LevelEntry> & levels )
+{
+    ScriptLinks       links;
+    std::vector<bool> used( scripts.Files().size(), false );
+    links.nbeventsmissing = scriptindex::LinkRows( events, [&scripts]( std::string_view symbol ){ return scripts.FindStem(symbol); },      links.events, used );
+    links.nblevelsmissing = scriptindex::LinkRows( levels, [&scripts]( std::string_view symbol ){ return scripts.FindDirectory(symbol); }, links.levels, used );
+    for( uint32_t i = 0; i < used.size(); ++i )
+    {
+        if( !used[i] )
+            links.unused.push_back(i);
+    }
+    return links;
+}
+
+#endif
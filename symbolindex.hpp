@@ -0,0 +1,286 @@
+#ifndef SYMBOLINDEX_HPP
+#define SYMBOLINDEX_HPP
+/*
+symbolindex.hpp
+    In-memory index over the rows of several decoded tables.
+
+    Rows can be looked up by the symbol string they point to, or by the value of any of their
+    integer fields, through open addressing hash tables. Every key maps to the list of rows that
+    have it, in the order the rows were added.
+*/
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+    SymbolIndex
+        Holds a copy of the indexed rows, so it doesn't depend on the lifetime of the source images.
+*/
+class SymbolIndex
+{
+public:
+    static constexpr uint32_t NoSymbol = 0xFFFFFFFF;
+
+    struct RowRef
+    {
+        uint32_t table = 0;
+        uint32_t row   = 0;
+    };
+
+    struct Table
+    {
+        std::string              name;
+        std::vector<uint32_t>    columns;   //Column name ids, in record order, without the symbol
+        std::vector<int64_t>     values;    //columns.size() values per row
+        std::vector<uint32_t>    offsets;   //File offset of each row
+        std::vector<uint32_t>    symbols;   //Symbol id of each row, or NoSymbol
+
+        inline size_t NbRows()const { return offsets.size(); }
+    };
+
+    //Adds an empty table, and returns its id
+    uint32_t AddTable( const std::string & name, const std::vector<std::string> & columnnames )
+    {
+        Table tbl;
+        tbl.name = name;
+        for( const std::string & colname : columnnames )
+            tbl.columns.push_back( ColumnId(colname) );
+        m_tables.push_back( std::move(tbl) );
+        return static_cast<uint32_t>( m_tables.size() - 1 );
+    }
+
+    /*
+        AddRow
+            Appends a row to a table, and indexes its symbol and every one of its values.
+            "values" must have one value per column of the table.
+    */
+    void AddRow( uint32_t tableid, uint32_t rowoffset, const int64_t * values, std::optional<std::string_view> symbol )
+    {
+        Table &        tbl = m_tables.at(tableid);
+        const RowRef   ref { tableid, static_cast<uint32_t>( tbl.NbRows() ) };
+        tbl.offsets.push_back( rowoffset );
+        tbl.values.insert( tbl.values.end(), values, values + tbl.columns.size() );
+
+        uint32_t symid = NoSymbol;
+        if( symbol )
+        {
+            const uint64_t hash = HashBytes( symbol->data(), symbol->size() );
+            symid = m_symslots.Find( hash, [&]( uint32_t idx ){ return m_symbols[idx].text == *symbol; } );
+            if( symid == Slots::Empty )
+            {
+                symid = static_cast<uint32_t>( m_symbols.size() );
+                m_symbols.push_back( SymbolKey{ std::string(*symbol), hash, PostingList() } );
+                m_symslots.Insert( hash, symid, [this]( uint32_t idx ){ return m_symbols[idx].hash; } );
+            }
+            AddPosting( m_symbols[symid].rows, ref );
+        }
+        tbl.symbols.push_back( symid );
+
+        for( size_t i = 0; i < tbl.columns.size(); ++i )
+        {
+            const uint32_t colid = tbl.columns[i];
+            const int64_t  value = values[i];
+            const uint64_t hash  = HashIntKey( colid, value );
+            uint32_t       keyid = m_intslots.Find( hash, [&]( uint32_t idx ){ return m_intkeys[idx].column == colid && m_intkeys[idx].value == value; } );
+            if( keyid == Slots::Empty )
+            {
+                keyid = static_cast<uint32_t>( m_intkeys.size() );
+                m_intkeys.push_back( IntKey{ colid, value, hash, PostingList() } );
+                m_intslots.Insert( hash, keyid, [this]( uint32_t idx ){ return m_intkeys[idx].hash; } );
+            }
+            AddPosting( m_intkeys[keyid].rows, ref );
+        }
+    }
+
+    //Every row pointing at the symbol
+    std::vector<RowRef> FindSymbol( std::string_view symbol )const
+    {
+        const uint32_t symid = m_symslots.Find( HashBytes( symbol.data(), symbol.size() ), [&]( uint32_t idx ){ return m_symbols[idx].text == symbol; } );
+        if( symid == Slots::Empty )
+            return std::vector<RowRef>();
+        return CollectPostings( m_symbols[symid].rows );
+    }
+
+    //Every row whose field "column" has the value "value"
+    std::vector<RowRef> FindValue( std::string_view column, int64_t value )const
+    {
+        const uint32_t colid = FindColumnId(column);
+        if( colid == Slots::Empty )
+            return std::vector<RowRef>();
+        const uint32_t keyid = m_intslots.Find( HashIntKey( colid, value ), [&]( uint32_t idx ){ return m_intkeys[idx].column == colid && m_intkeys[idx].value == value; } );
+        if( keyid == Slots::Empty )
+            return std::vector<RowRef>();
+        return CollectPostings( m_intkeys[keyid].rows );
+    }
+
+    inline const std::vector<Table> & Tables()const                  { return m_tables; }
+    inline const std::string        & ColumnName( uint32_t id )const { return m_colnames[id]; }
+    inline size_t                     NbSymbols()const               { return m_symbols.size(); }
+
+    inline std::string_view Symbol( uint32_t symid )const
+    {
+        return (symid == NoSymbol)? std::string_view() : std::string_view( m_symbols[symid].text );
+    }
+
+    //FNV-1a
+    static uint64_t HashBytes( const char * p, size_t len )
+    {
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for( size_t i = 0; i < len; ++i )
+        {
+            hash ^= static_cast<uint8_t>(p[i]);
+            hash *= 0x100000001B3ull;
+        }
+        return hash;
+    }
+
+private:
+    /*
+        Slots
+            Open addressing with linear probing over entry indices. The hashes are kept in the entries,
+            so growing only needs to ask for them back.
+    */
+    class Slots
+    {
+    public:
+        static constexpr uint32_t Empty    = 0xFFFFFFFF;
+        static constexpr size_t   MinSlots = 64;
+
+        template<class _EqFun>
+            uint32_t Find( uint64_t hash, _EqFun && eq )const
+        {
+            if( m_slots.empty() )
+                return Empty;
+            const size_t mask = m_slots.size() - 1;
+            for( size_t i = static_cast<size_t>(hash) & mask; m_slots[i] != Empty; i = (i + 1) & mask )
+            {
+                if( eq(m_slots[i]) )
+                    return m_slots[i];
+            }
+            return Empty;
+        }
+
+        //"hashof( entryidx )" returns the hash of an entry already in the table
+        template<class _HashFun>
+            void Insert( uint64_t hash, uint32_t entryidx, _HashFun && hashof )
+        {
+            //Keep the load factor under 1/2
+            if( (m_nbused + 1) * 2 > m_slots.size() )
+            {
+                std::vector<uint32_t> old( std::max<size_t>( MinSlots, m_slots.size() * 2 ), Empty );
+                old.swap(m_slots);
+                for( uint32_t idx : old )
+                {
+                    if( idx != Empty )
+                        Place( hashof(idx), idx );
+                }
+            }
+            Place( hash, entryidx );
+            ++m_nbused;
+        }
+
+    private:
+        void Place( uint64_t hash, uint32_t entryidx )
+        {
+            const size_t mask = m_slots.size() - 1;
+            size_t       i    = static_cast<size_t>(hash) & mask;
+            while( m_slots[i] != Empty )
+                i = (i + 1) & mask;
+            m_slots[i] = entryidx;
+        }
+
+        std::vector<uint32_t> m_slots;
+        size_t                m_nbused = 0;
+    };
+
+    //Singly linked list of rows, stored in m_postings
+    struct PostingList
+    {
+        uint32_t first = Slots::Empty;
+        uint32_t last  = Slots::Empty;
+    };
+
+    struct Posting
+    {
+        RowRef   ref;
+        uint32_t next = Slots::Empty;
+    };
+
+    struct SymbolKey
+    {
+        std::string text;
+        uint64_t    hash;
+        PostingList rows;
+    };
+
+    struct IntKey
+    {
+        uint32_t    column;
+        int64_t     value;
+        uint64_t    hash;
+        PostingList rows;
+    };
+
+    static uint64_t HashIntKey( uint32_t colid, int64_t value )
+    {
+        //splitmix64 finalizer
+        uint64_t x = static_cast<uint64_t>(value) ^ (static_cast<uint64_t>(colid) << 48) ^ 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    void AddPosting( PostingList & list, RowRef ref )
+    {
+        const uint32_t idx = static_cast<uint32_t>( m_postings.size() );
+        m_postings.push_back( Posting{ ref, Slots::Empty } );
+        if( list.last != Slots::Empty )
+            m_postings[list.last].next = idx;
+        else
+            list.first = idx;
+        list.last = idx;
+    }
+
+    std::vector<RowRef> CollectPostings( const PostingList & list )const
+    {
+        std::vector<RowRef> refs;
+        for( uint32_t idx = list.first; idx != Slots::Empty; idx = m_postings[idx].next )
+            refs.push_back( m_postings[idx].ref );
+        return refs;
+    }
+
+    uint32_t FindColumnId( std::string_view colname )const
+    {
+        for( size_t i = 0; i < m_colnames.size(); ++i )
+        {
+            if( m_colnames[i] == colname )
+                return static_cast<uint32_t>(i);
+        }
+        return Slots::Empty;
+    }
+
+    uint32_t ColumnId( const std::string & colname )
+    {
+        uint32_t colid = FindColumnId(colname);
+        if( colid != Slots::Empty )
+            return colid;
+        m_colnames.push_back(colname);
+        return static_cast<uint32_t>( m_colnames.size() - 1 );
+    }
+
+private:
+    std::vector<Table>       m_tables;
+    std::vector<std::string> m_colnames;
+    std::vector<SymbolKey>   m_symbols;
+    std::vector<IntKey>      m_intkeys;
+    std::vector<Posting>     m_postings;
+    Slots                    m_symslots;
+    Slots                    m_intslots;
+};
+
+#endif
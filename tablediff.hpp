@@ -0,0 +1,228 @@
+#ifndef TABLEDIFF_HPP
+#define TABLEDIFF_HPP
+/*
+tablediff.hpp
+    Compares the tables of two builds, decoded into SymbolIndex objects.
+
+    Rows are matched by key instead of by position, so an entry inserted in the middle of a table
+    doesn't make every row after it show up as changed. A row's key is its symbol, plus how many
+    rows before it in the same table have the same symbol, so duplicates and NULL symbols still
+    pair up in order. Matching is a single hash lookup per row.
+*/
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "symbolindex.hpp"
+
+struct DiffSummary
+{
+    size_t nbadded   = 0;
+    size_t nbremoved = 0;
+    size_t nbchanged = 0;
+
+    inline bool empty()const { return (nbadded + nbremoved + nbchanged) == 0; }
+
+    void Merge( const DiffSummary & other )
+    {
+        nbadded   += other.nbadded;
+        nbremoved += other.nbremoved;
+        nbchanged += other.nbchanged;
+    }
+};
+
+namespace tablediff
+{
+    struct RowKey
+    {
+        std::string_view symbol;
+        bool             bnull      = false;
+        uint32_t         occurrence = 0;
+
+        inline bool operator==( const RowKey & other )const
+        {
+            return bnull == other.bnull && occurrence == other.occurrence && symbol == other.symbol;
+        }
+    };
+
+    struct RowKeyHash
+    {
+        inline size_t operator()( const RowKey & key )const
+        {
+            uint64_t hash = SymbolIndex::HashBytes( key.symbol.data(), key.symbol.size() );
+            hash ^= (static_cast<uint64_t>(key.occurrence) << 1) | (key.bnull? 1 : 0);
+            hash *= 0x9E3779B97F4A7C15ull;
+            return static_cast<size_t>( hash ^ (hash >> 32) );
+        }
+    };
+
+    //The key of every row of a table, in row order
+    inline std::vector<RowKey> MakeRowKeys( const SymbolIndex & index, const SymbolIndex::Table & tbl )
+    {
+        std::vector<RowKey>                            keys( tbl.NbRows() );
+        std::unordered_map<std::string_view, uint32_t> nbseen;
+        uint32_t                                       nbnullseen = 0;
+        for( size_t i = 0; i < tbl.NbRows(); ++i )
+        {
+            RowKey & key = keys[i];
+            if( tbl.symbols[i] == SymbolIndex::NoSymbol )
+            {
+                key.bnull      = true;
+                key.occurrence = nbnullseen++;
+            }
+            else
+            {
+                key.symbol     = index.Symbol( tbl.symbols[i] );
+                key.occurrence = nbseen[key.symbol]++;
+            }
+        }
+        return keys;
+    }
+
+    inline void PrintKey( std::ostream & out, const RowKey & key )
+    {
+        if( key.bnull )
+            out <<"NULL";
+        else
+            out <<"\"" <<key.symbol <<"\"";
+        if( key.occurrence != 0 )
+            out <<"#" <<key.occurrence;
+    }
+
+    inline void PrintRow( std::ostream & out, const SymbolIndex & index, const SymbolIndex::Table & tbl, size_t row )
+    {
+        const size_t nbcols = tbl.columns.size();
+        out <<"[" <<row <<"]";
+        for( size_t c = 0; c < nbcols; ++c )
+            out <<( (c == 0)? " " : ", " ) <<index.ColumnName( tbl.columns[c] ) <<"=" <<tbl.values[(row * nbcols) + c];
+    }
+
+    inline const SymbolIndex::Table * FindTable( const SymbolIndex & index, const std::string & name )
+    {
+        for( const auto & tbl : index.Tables() )
+        {
+            if( tbl.name == name )
+                return &tbl;
+        }
+        return nullptr;
+    }
+
+    /*
+        DiffTable
+            Writes the added, removed and changed rows of a single table.
+            Lines start with '+' for added rows, '-' for removed rows, and '~' for changed rows.
+    */
+    inline DiffSummary DiffTable( const SymbolIndex & base, const SymbolIndex::Table & btbl, const SymbolIndex & other, const SymbolIndex::Table & otbl, std::ostream & out )
+    {
+        DiffSummary               summary;
+        const std::vector<RowKey> bkeys  = MakeRowKeys( base,  btbl );
+        const std::vector<RowKey> okeys  = MakeRowKeys( other, otbl );
+        const size_t              nbcols = btbl.columns.size();
+        if( otbl.columns.size() != nbcols )
+            throw std::runtime_error("DiffTable(): The " + btbl.name + " tables don't have the same columns!");
+
+        std::unordered_map<RowKey, uint32_t, RowKeyHash> baserows( bkeys.size() * 2 );
+        for( size_t i = 0; i < bkeys.size(); ++i )
+            baserows.emplace( bkeys[i], static_cast<uint32_t>(i) );
+
+        std::vector<bool> bmatched( bkeys.size(), false );
+        for( size_t orow = 0; orow < okeys.size(); ++orow )
+        {
+            auto found = baserows.find( okeys[orow] );
+            if( found == baserows.end() )
+            {
+                out <<"+ ";
+                PrintKey( out, okeys[orow] );
+                out <<" ";
+                PrintRow( out, other, otbl, orow );
+                out <<"\n";
+                ++summary.nbadded;
+                continue;
+            }
+
+            const size_t brow = found->second;
+            bmatched[brow] = true;
+            const int64_t * bvals = btbl.values.data() + (brow * nbcols);
+            const int64_t * ovals = otbl.values.data() + (orow * nbcols);
+            bool bchanged = false;
+            for( size_t c = 0; c < nbcols; ++c )
+            {
+                if( bvals[c] == ovals[c] )
+                    continue;
+                if( !bchanged )
+                {
+                    out <<"~ ";
+                    PrintKey( out, okeys[orow] );
+                    out <<" [" <<brow <<"]->[" <<orow <<"]:";
+                    bchanged = true;
+                }
+                else
+                    out <<",";
+                out <<" " <<base.ColumnName( btbl.columns[c] ) <<" " <<bvals[c] <<" -> " <<ovals[c];
+            }
+            if( bchanged )
+            {
+                out <<"\n";
+                ++summary.nbchanged;
+            }
+        }
+
+        for( size_t brow = 0; brow < bkeys.size(); ++brow )
+        {
+            if( bmatched[brow] )
+                continue;
+            out <<"- ";
+            PrintKey( out, bkeys[brow] );
+            out <<" ";
+            PrintRow( out, base, btbl, brow );
+            out <<"\n";
+            ++summary.nbremoved;
+        }
+        return summary;
+    }
+}
+
+/*
+    DiffTableSets
+        Writes the differences between every table of "base" and the table with the same name in
+        "other". Tables that only exist on one side count as entirely added or removed.
+*/
+inline DiffSummary DiffTableSets( const SymbolIndex & base, const SymbolIndex & other, std::ostream & out )
+{
+    using namespace tablediff;
+    DiffSummary total;
+    auto lambdaTableHeader = [&out]( const std::string & name, size_t nbbase, size_t nbother )
+    {
+        out <<"=== " <<name <<" (" <<nbbase <<" -> " <<nbother <<" rows)\n";
+    };
+
+    for( const auto & btbl : base.Tables() )
+    {
+        const SymbolIndex::Table * potbl = FindTable( other, btbl.name );
+        if( potbl == nullptr )
+        {
+            lambdaTableHeader( btbl.name, btbl.NbRows(), 0 );
+            out <<"- whole table\n";
+            total.nbremoved += btbl.NbRows();
+            continue;
+        }
+        lambdaTableHeader( btbl.name, btbl.NbRows(), potbl->NbRows() );
+        total.Merge( DiffTable( base, btbl, other, *potbl, out ) );
+    }
+
+    for( const auto & otbl : other.Tables() )
+    {
+        if( FindTable( base, otbl.name ) != nullptr )
+            continue;
+        lambdaTableHeader( otbl.name, 0, otbl.NbRows() );
+        out <<"+ whole table\n";
+        total.nbadded += otbl.NbRows();
+    }
+    return total;
+}
+
+#endif
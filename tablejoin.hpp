@@ -0,0 +1,287 @@
+#ifndef TABLEJOIN_HPP
+#define TABLEJOIN_HPP
+/*
+tablejoin.hpp
+    Equi-joins between the columns of tables decoded into a SymbolIndex.
+
+    A join is written "<table>.<column>=<table>.<column>", with the table ids of the csv and jsonl
+    outputs. Ex: "event_list_table.unk3=entity_symbol_list_table.entityid". The column "symbol" is
+    the string the row points to, and can only be joined with another table's "symbol". The right
+    side is the referenced table: a hash table is built over its key column, and each row of the
+    left side is looked up in it, so a join is linear in the number of rows plus the number of
+    matches. Left rows whose key isn't in the right table are dangling references, and right rows
+    no left row refers to are unused.
+*/
+#include <cstdint>
+#include <cstddef>
+#include <iomanip>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "eventtables.hpp"
+#include "symbolindex.hpp"
+
+/*
+    JoinColumn
+        A column of a table, by table id and column name.
+*/
+struct JoinColumn
+{
+    std::string table;
+    std::string column;
+};
+
+struct JoinSpec
+{
+    JoinColumn left;    //The column holding the references
+    JoinColumn right;   //The column being referred to
+};
+
+struct JoinSummary
+{
+    size_t nbmatches  = 0;
+    size_t nbdangling = 0;
+    size_t nbunused   = 0;
+
+    void Merge( const JoinSummary & other )
+    {
+        nbmatches  += other.nbmatches;
+        nbdangling += other.nbdangling;
+        nbunused   += other.nbunused;
+    }
+};
+
+namespace tablejoin
+{
+    static const std::string SymbolColumn = "symbol";
+
+    inline JoinColumn ParseJoinColumn( std::string_view text, const std::string & spec )
+    {
+        const size_t dotpos = text.find('.');
+        if( dotpos == std::string_view::npos || dotpos == 0 || (dotpos + 1) == text.size() )
+            throw std::runtime_error("ParseJoinSpec(): Expected <table>.<column> on both sides of \"" + spec + "\"!");
+        return JoinColumn{ std::string( text.substr( 0, dotpos ) ), std::string( text.substr( dotpos + 1 ) ) };
+    }
+
+    //Symbol keys are string ids, which mean nothing compared to a field's value
+    inline void CheckJoinColumns( const JoinColumn & left, const JoinColumn & right, const char * caller )
+    {
+        if( (left.column == SymbolColumn) != (right.column == SymbolColumn) )
+        {
+            throw std::runtime_error( std::string(caller) + ": Can't join " + left.table + "." + left.column + " with " + right.table + "." + right.column
+                                      + ", the \"" + SymbolColumn + "\" column can only be joined with another \"" + SymbolColumn + "\" column!");
+        }
+    }
+
+    /*
+        BoundColumn
+            A JoinColumn resolved against a SymbolIndex. Gives the key of each row.
+            Rows with a NULL symbol have no key when joining on the symbol.
+    */
+    struct BoundColumn
+    {
+        const SymbolIndex::Table * ptbl     = nullptr;
+        size_t                     colidx   = 0;
+        bool                       bsymbol  = false;
+
+        inline bool Key( size_t row, int64_t & key )const
+        {
+            if( bsymbol )
+            {
+                key = ptbl->symbols[row];
+                return ptbl->symbols[row] != SymbolIndex::NoSymbol;
+            }
+            key = ptbl->values[(row * ptbl->columns.size()) + colidx];
+            return true;
+        }
+    };
+
+    inline BoundColumn BindColumn( const SymbolIndex & index, const JoinColumn & col )
+    {
+        BoundColumn bound;
+        for( const auto & tbl : index.Tables() )
+        {
+            if( tbl.name == col.table )
+                bound.ptbl = &tbl;
+        }
+        if( bound.ptbl == nullptr )
+            throw std::runtime_error("BindColumn(): Unknown table \"" + col.table + "\"!");
+        if( col.column == SymbolColumn )
+        {
+            bound.bsymbol = true;
+            return bound;
+        }
+        for( ; bound.colidx < bound.ptbl->columns.size(); ++bound.colidx )
+        {
+            if( index.ColumnName( bound.ptbl->columns[bound.colidx] ) == col.column )
+                return bound;
+        }
+        throw std::runtime_error("BindColumn(): The table \"" + col.table + "\" has no column \"" + col.column + "\"!");
+    }
+
+    /*
+        KeyTable
+            Open addressing hash table from a key to the rows that have it, in row order.
+            Sized once for the number of rows, so it never grows.
+    */
+    class KeyTable
+    {
+    public:
+        static constexpr uint32_t Empty = 0xFFFFFFFF;
+
+        explicit KeyTable( const BoundColumn & col )
+            :m_keys( col.ptbl->NbRows() ), m_next( col.ptbl->NbRows(), Empty )
+        {
+            size_t nbslots = 16;
+            while( nbslots < (col.ptbl->NbRows() * 2) )
+                nbslots *= 2;
+            m_slots.assign( nbslots, Empty );
+
+            //Going backward and pushing to the front of each chain keeps the rows in order
+            for( size_t row = col.ptbl->NbRows(); row-- > 0; )
+            {
+                if( !col.Key( row, m_keys[row] ) )
+                    continue;
+                uint32_t & slot = m_slots[FindSlot( m_keys[row] )];
+                m_next[row] = slot;
+                slot        = static_cast<uint32_t>(row);
+            }
+        }
+
+        //First row with the key, or Empty
+        inline uint32_t Find( int64_t key )const         { return m_slots[FindSlot(key)]; }
+        inline uint32_t Next( uint32_t row )const        { return m_next[row]; }
+
+    private:
+        size_t FindSlot( int64_t key )const
+        {
+            //splitmix64 finalizer
+            uint64_t x = static_cast<uint64_t>(key) + 0x9E3779B97F4A7C15ull;
+            x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+            x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+            x ^= (x >> 31);
+
+            const size_t mask = m_slots.size() - 1;
+            size_t       i    = static_cast<size_t>(x) & mask;
+            while( m_slots[i] != Empty && m_keys[m_slots[i]] != key )
+                i = (i + 1) & mask;
+            return i;
+        }
+
+    private:
+        std::vector<uint32_t> m_slots;
+        std::vector<int64_t>  m_keys;   //Key of each row
+        std::vector<uint32_t> m_next;   //Next row with the same key
+    };
+
+    inline std::string KeyText( const SymbolIndex & index, const BoundColumn & col, int64_t key )
+    {
+        if( col.bsymbol )
+            return "\"" + std::string( index.Symbol( static_cast<uint32_t>(key) ) ) + "\"";
+        return std::to_string(key);
+    }
+
+    //The symbol is only padded when something follows it on the line
+    inline void PrintRowRef( std::ostream & out, const SymbolIndex & index, const SymbolIndex::Table & tbl, size_t row, bool blast )
+    {
+        const uint32_t    symid  = tbl.symbols[row];
+        const std::string symbol = (symid == SymbolIndex::NoSymbol)? std::string("NULL") : ( "\"" + std::string( index.Symbol(symid) ) + "\"" );
+        out <<std::setw(9)  <<std::left <<row <<" "
+            <<std::setw(12) <<std::left <<NumberToHexString( tbl.offsets[row] ) <<" "
+            <<std::setw(blast? 0 : 20) <<std::left <<symbol;
+    }
+}
+
+/*
+    ParseJoinSpec
+        Ex: "event_list_table.unk3=entity_symbol_list_table.entityid"
+*/
+inline JoinSpec ParseJoinSpec( const std::string & spec )
+{
+    const size_t eqpos = spec.find('=');
+    if( eqpos == std::string::npos )
+        throw std::runtime_error("ParseJoinSpec(): Expected <table>.<column>=<table>.<column>, got \"" + spec + "\"!");
+    const std::string_view text(spec);
+    JoinSpec               parsed{ tablejoin::ParseJoinColumn( text.substr( 0, eqpos ), spec ), tablejoin::ParseJoinColumn( text.substr( eqpos + 1 ), spec ) };
+    tablejoin::CheckJoinColumns( parsed.left, parsed.right, "ParseJoinSpec()" );
+    return parsed;
+}
+
+/*
+    RunJoin
+        Writes one line per pair of matching rows, per dangling left row, and per unused right row,
+        in that order, then a summary line. Lines start with "match", "dangling" or "unused".
+*/
+inline JoinSummary RunJoin( const SymbolIndex & index, const JoinSpec & spec, std::ostream & out )
+{
+    using namespace tablejoin;
+    CheckJoinColumns( spec.left, spec.right, "RunJoin()" );
+    const BoundColumn   left    = BindColumn( index, spec.left );
+    const BoundColumn   right   = BindColumn( index, spec.right );
+    const KeyTable      rightkeys( right );
+    JoinSummary         summary;
+    std::vector<bool>   bused( right.ptbl->NbRows(), false );
+    std::vector<size_t> dangling;
+
+    out <<"=== " <<spec.left.table <<"." <<spec.left.column <<" = " <<spec.right.table <<"." <<spec.right.column <<"\n"
+        <<std::setw(9)  <<std::left <<"Status"    <<" "
+        <<std::setw(20) <<std::left <<"Key"       <<" "
+        <<std::setw(9)  <<std::left <<"Left row"  <<" " <<std::setw(12) <<std::left <<"Left offset"  <<" " <<std::setw(20) <<std::left <<"Left symbol"  <<" "
+        <<std::setw(9)  <<std::left <<"Right row" <<" " <<std::setw(12) <<std::left <<"Right offset" <<" " <<"Right symbol\n";
+
+    auto lambdaLineStart = [&]( const char * status, const BoundColumn & col, int64_t key )
+    {
+        out <<std::setw(9) <<std::left <<status <<" " <<std::setw(20) <<std::left <<KeyText( index, col, key ) <<" ";
+    };
+
+    for( size_t row = 0; row < left.ptbl->NbRows(); ++row )
+    {
+        int64_t key = 0;
+        if( !left.Key( row, key ) )
+            continue;
+        uint32_t match = rightkeys.Find(key);
+        if( match == KeyTable::Empty )
+        {
+            dangling.push_back(row);
+            continue;
+        }
+        for( ; match != KeyTable::Empty; match = rightkeys.Next(match) )
+        {
+            bused[match] = true;
+            lambdaLineStart( "match", left, key );
+            PrintRowRef( out, index, *left.ptbl, row, false );
+            out <<" ";
+            PrintRowRef( out, index, *right.ptbl, match, true );
+            out <<"\n";
+            ++summary.nbmatches;
+        }
+    }
+
+    for( size_t row : dangling )
+    {
+        int64_t key = 0;
+        left.Key( row, key );
+        lambdaLineStart( "dangling", left, key );
+        PrintRowRef( out, index, *left.ptbl, row, true );
+        out <<"\n";
+    }
+    summary.nbdangling = dangling.size();
+
+    for( size_t row = 0; row < right.ptbl->NbRows(); ++row )
+    {
+        int64_t key = 0;
+        if( bused[row] || !right.Key( row, key ) )
+            continue;
+        lambdaLineStart( "unused", right, key );
+        out <<std::string( 9 + 1 + 12 + 1 + 20 + 1, ' ' );
+        PrintRowRef( out, index, *right.ptbl, row, true );
+        out <<"\n";
+        ++summary.nbunused;
+    }
+    out <<"--- " <<summary.nbmatches <<" match(es), " <<summary.nbdangling <<" dangling, " <<summary.nbunused <<" unused\n";
+    return summary;
+}
+
+#endif
@@ -0,0 +1,480 @@
+#ifndef TABLEPATCH_HPP
+#define TABLEPATCH_HPP
+/*
+tablepatch.hpp
+    Edits the table entries of an unpacked binary in place, from a patch file.
+
+    A patch file lists single field changes. Each one names the table by its id as in the CSV and
+    JSON outputs ("entity_symbol_list_table"), the row by its index in the table ("row") or by its
+    file offset ("offset"), the field by its output name ("unk3", "symbol_ptr"), and the new value,
+    in decimal or in hex with a "0x" prefix.
+
+    As CSV, with a header naming the columns:
+        table,row,field,value
+        entity_symbol_list_table,12,unk3,0x1F
+    As JSON lines, one object per change:
+        {"table":"entity_symbol_list_table","row":12,"field":"unk3","value":31}
+
+    Every change is validated before anything is written, so a bad patch leaves the file untouched.
+    The records are then re-encoded with the same field descriptors they're decoded with, and only
+    the bytes that differ are written.
+*/
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "eventtables.hpp"
+#include "lutscanner.hpp"
+
+/*
+    TablePatch
+        A single field change.
+*/
+struct TablePatch
+{
+    std::string table;
+    bool        bbyoffset = false;  //Whether "row" is the row's file offset, rather than its index
+    uint32_t    row       = 0;
+    std::string field;
+    int64_t     value     = 0;
+    size_t      line      = 0;      //Line in the patch file, for error messages
+};
+
+/*
+    PatchResult
+        What applying patches to a file changed.
+*/
+struct PatchResult
+{
+    size_t nbpatches      = 0;  //Changes that applied to the file
+    size_t nbrowschanged  = 0;
+    size_t nbbyteschanged = 0;
+
+    void Merge( const PatchResult & other )
+    {
+        nbpatches      += other.nbpatches;
+        nbrowschanged  += other.nbrowschanged;
+        nbbyteschanged += other.nbbyteschanged;
+    }
+};
+
+namespace tablepatch
+{
+    inline std::runtime_error PatchError( const std::string & fpath, size_t line, const std::string & msg )
+    {
+        return std::runtime_error( fpath + ":" + std::to_string(line) + ": " + msg );
+    }
+
+    /*
+        ParseInt
+            Parses a decimal integer, or a hex one with a "0x" prefix. Either can be negative.
+    */
+    inline bool ParseInt( std::string_view str, int64_t & out )
+    {
+        bool bnegative = false;
+        if( !str.empty() && str.front() == '-' )
+        {
+            bnegative = true;
+            str.remove_prefix(1);
+        }
+        int base = 10;
+        if( str.size() > 2 && str[0] == '0' && (str[1] == 'x' || str[1] == 'X') )
+        {
+            base = 16;
+            str.remove_prefix(2);
+        }
+        uint64_t magnitude = 0;
+        auto     res       = std::from_chars( str.data(), str.data() + str.size(), magnitude, base );
+        if( str.empty() || res.ec != std::errc() || res.ptr != (str.data() + str.size()) || magnitude > static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) )
+            return false;
+        out = bnegative? -static_cast<int64_t>(magnitude) : static_cast<int64_t>(magnitude);
+        return true;
+    }
+
+    //Splits a CSV line on commas. Quoted cells may contain commas, and doubled quotes.
+    inline std::vector<std::string> SplitCsvLine( const std::string & line )
+    {
+        std::vector<std::string> cells(1);
+        bool                     bquoted = false;
+        for( size_t i = 0; i < line.size(); ++i )
+        {
+            const char c = line[i];
+            if( bquoted )
+            {
+                if( c != '"' )
+                    cells.back().push_back(c);
+                else if( (i + 1) < line.size() && line[i + 1] == '"' )
+                    cells.back().push_back( line[++i] );
+                else
+                    bquoted = false;
+            }
+            else if( c == '"' )
+                bquoted = true;
+            else if( c == ',' )
+                cells.emplace_back();
+            else
+                cells.back().push_back(c);
+        }
+        return cells;
+    }
+
+    /*
+        ParseFlatJsonObject
+            Reads a single line JSON object whose values are all strings or numbers, into key/value pairs.
+            Numbers are kept as written. Returns false if the line isn't such an object.
+    */
+    inline bool ParseFlatJsonObject( const std::string & line, std::vector<std::pair<std::string,std::string>> & out )
+    {
+        size_t pos = 0;
+        auto lambdaSkipSpaces = [&](){ while( pos < line.size() && isspace( static_cast<unsigned char>(line[pos]) ) ) ++pos; };
+        auto lambdaReadString = [&]( std::string & str )
+        {
+            if( pos >= line.size() || line[pos] != '"' )
+                return false;
+            for( ++pos; pos < line.size() && line[pos] != '"'; ++pos )
+            {
+                if( line[pos] == '\\' && (pos + 1) < line.size() )
+                    ++pos;  //Only simple escapes, table and field names are plain ASCII
+                str.push_back( line[pos] );
+            }
+            return pos++ < line.size();
+        };
+
+        lambdaSkipSpaces();
+        if( pos >= line.size() || line[pos++] != '{' )
+            return false;
+        for(;;)
+        {
+            lambdaSkipSpaces();
+            if( pos < line.size() && line[pos] == '}' && out.empty() )
+                break;
+            std::pair<std::string,std::string> kv;
+            if( !lambdaReadString(kv.first) )
+                return false;
+            lambdaSkipSpaces();
+            if( pos >= line.size() || line[pos++] != ':' )
+                return false;
+            lambdaSkipSpaces();
+            if( pos < line.size() && line[pos] == '"' )
+            {
+                if( !lambdaReadString(kv.second) )
+                    return false;
+            }
+            else
+            {
+                for( ; pos < line.size() && line[pos] != ',' && line[pos] != '}' && !isspace( static_cast<unsigned char>(line[pos]) ); ++pos )
+                    kv.second.push_back( line[pos] );
+            }
+            out.push_back( std::move(kv) );
+            lambdaSkipSpaces();
+            if( pos < line.size() && line[pos] == ',' )
+            {
+                ++pos;
+                continue;
+            }
+            if( pos < line.size() && line[pos] == '}' )
+                break;
+            return false;
+        }
+        ++pos;
+        lambdaSkipSpaces();
+        return pos == line.size();
+    }
+
+    //Makes a patch out of named values, from either format
+    template<class _LookupFunTy>
+        TablePatch MakePatch( const std::string & fpath, size_t line, _LookupFunTy && lookup )
+    {
+        TablePatch          patch;
+        const std::string * ptable = lookup("table");
+        const std::string * prow   = lookup("row");
+        const std::string * poffs  = lookup("offset");
+        const std::string * pfield = lookup("field");
+        const std::string * pvalue = lookup("value");
+        if( ptable == nullptr || pfield == nullptr || pvalue == nullptr || (prow == nullptr && poffs == nullptr) )
+            throw PatchError( fpath, line, "A change needs a table, a row or an offset, a field and a value!" );
+
+        int64_t rowval = 0;
+        patch.bbyoffset = (prow == nullptr || prow->empty()) && poffs != nullptr;
+        const std::string & rowstr = patch.bbyoffset? *poffs : *prow;
+        if( !ParseInt( rowstr, rowval ) || rowval < 0 || rowval > std::numeric_limits<uint32_t>::max() )
+            throw PatchError( fpath, line, "Invalid " + std::string(patch.bbyoffset? "offset" : "row") + " \"" + rowstr + "\"!" );
+        if( !ParseInt( *pvalue, patch.value ) )
+            throw PatchError( fpath, line, "Invalid value \"" + *pvalue + "\"!" );
+        patch.table = *ptable;
+        patch.row   = static_cast<uint32_t>(rowval);
+        patch.field = *pfield;
+        patch.line  = line;
+        return patch;
+    }
+
+    /*
+        PrepareTablePatches
+            Validates the patches for the table "headertext", which "locate" finds in the binary, and
+            appends the re-encoded records they change to "records", as ( file offset, record bytes ).
+            Returns the number of patches for the table.
+    */
+    template<class _EntryTy>
+        size_t PrepareTablePatches( LUTLocator & locator, LUTLocation (*locate)( LUTLocator & ), const std::string & headertext,
+                                    const std::vector<TablePatch> & allpatches, const std::string & patchpath,
+                                    std::vector<std::pair<uint32_t, std::vector<uint8_t>>> & records )
+    {
+        const std::string              tableid = MakeTableId(headertext);
+        std::vector<const TablePatch*> patches;
+        for( const TablePatch & patch : allpatches )
+            if( patch.table == tableid )
+                patches.push_back( &patch );
+        if( patches.empty() )
+            return 0;
+
+        const uint8_t *              pfbeg      = locator.ImageBeg();
+        const size_t                 fsize      = static_cast<size_t>(locator.ImageEnd() - pfbeg);
+        const uint32_t               loadoffset = locator.LoadOffset();
+        const LUTLocation            loc        = locate(locator);
+        std::map<uint32_t, _EntryTy> edited;    //By row index, so records are written in file order
+        if( (loc.offset + (loc.nbentries * _EntryTy::Size)) > fsize )
+            throw std::runtime_error("PrepareTablePatches(): The " + headertext + " at " + NumberToHexString(loc.offset) + " goes past the end of the file!");
+
+        for( const TablePatch * ppatch : patches )
+        {
+            uint32_t rowidx = ppatch->row;
+            if( ppatch->bbyoffset )
+            {
+                if( ppatch->row < loc.offset || ((ppatch->row - loc.offset) % _EntryTy::Size) != 0 )
+                    throw PatchError( patchpath, ppatch->line, "Offset " + NumberToHexString(ppatch->row) + " isn't the start of a row of the " + ppatch->table + "!" );
+                rowidx = static_cast<uint32_t>( (ppatch->row - loc.offset) / _EntryTy::Size );
+            }
+            if( rowidx >= loc.nbentries )
+                throw PatchError( patchpath, ppatch->line, "Row " + std::to_string(rowidx) + " is past the end of the " + ppatch->table + ", which has " + std::to_string(loc.nbentries) + " rows!" );
+
+            auto itrow = edited.find(rowidx);
+            if( itrow == edited.end() )
+            {
+                const uint8_t * precord = pfbeg + loc.offset + (rowidx * _EntryTy::Size);
+                itrow = edited.emplace( rowidx, _EntryTy() ).first;
+                itrow->second.Read( precord, precord + _EntryTy::Size );
+            }
+
+            _EntryTy & entry = itrow->second;
+            try
+            {
+                if( !entry.SetField( ppatch->field, ppatch->value ) )
+                    throw std::runtime_error("The " + ppatch->table + " has no field \"" + ppatch->field + "\"!");
+            }
+            catch( const std::exception & e )
+            {
+                throw PatchError( patchpath, ppatch->line, e.what() );
+            }
+
+            //A new symbol pointer must lead to a symbol in the file, like the ones the tables are validated with
+            const uint32_t ptr = entry.SymbolPtr();
+            if( ppatch->field == "symbol_ptr" && ptr != 0 && ( (ptr - loadoffset) >= fsize || !lutscan::IsSymbolAt( pfbeg, fsize, ptr - loadoffset ) ) )
+                throw PatchError( patchpath, ppatch->line, "The pointer " + NumberToHexString(ptr) + " doesn't lead to a symbol in the file!" );
+        }
+
+        for( const auto & row : edited )
+        {
+            std::vector<uint8_t> encoded( _EntryTy::Size );
+            row.second.Write( encoded.data() );
+            records.emplace_back( static_cast<uint32_t>( loc.offset + (row.first * _EntryTy::Size) ), std::move(encoded) );
+        }
+        return patches.size();
+    }
+
+    //Writes the bytes of the records that differ from the file
+    inline void WriteRecords( uint8_t * pfbeg, const std::vector<std::pair<uint32_t, std::vector<uint8_t>>> & records, PatchResult & result )
+    {
+        for( const auto & record : records )
+        {
+            uint8_t * pdest     = pfbeg + record.first;
+            size_t    nbchanged = 0;
+            for( size_t i = 0; i < record.second.size(); ++i )
+            {
+                if( pdest[i] == record.second[i] )
+                    continue;
+                pdest[i] = record.second[i];
+                ++nbchanged;
+            }
+            result.nbbyteschanged += nbchanged;
+            result.nbrowschanged  += (nbchanged != 0)? 1 : 0;
+        }
+    }
+}
+
+/*
+    LoadTablePatches
+        Reads a patch file. Files ending in ".csv" are read as CSV, anything else as JSON lines.
+*/
+inline std::vector<TablePatch> LoadTablePatches( const std::string & fpath )
+{
+    std::ifstream in( fpath );
+    if( in.bad() || !(in.is_open()) )
+        throw std::runtime_error("Couldn't open patch file " + fpath);
+
+    const bool               bcsv = fpath.size() >= 4 && fpath.compare( fpath.size() - 4, 4, ".csv" ) == 0;
+    std::vector<TablePatch>  patches;
+    std::vector<std::string> columns;
+    std::string              line;
+    for( size_t cntline = 1; std::getline( in, line ); ++cntline )
+    {
+        while( !line.empty() && isspace( static_cast<unsigned char>(line.back()) ) )
+            line.pop_back();
+        if( line.empty() || line.front() == '#' )
+            continue;
+
+        if( bcsv )
+        {
+            std::vector<std::string> cells = tablepatch::SplitCsvLine(line);
+            if( columns.empty() )
+            {
+                columns = std::move(cells);
+                continue;
+            }
+            if( cells.size() != columns.size() )
+                throw tablepatch::PatchError( fpath, cntline, "Expected " + std::to_string(columns.size()) + " cells, got " + std::to_string(cells.size()) + "!" );
+            patches.push_back( tablepatch::MakePatch( fpath, cntline, [&]( const char * name )->const std::string*
+            {
+                for( size_t i = 0; i < columns.size(); ++i )
+                    if( columns[i] == name )
+                        return &cells[i];
+                return nullptr;
+            }));
+        }
+        else
+        {
+            std::vector<std::pair<std::string,std::string>> values;
+            if( !tablepatch::ParseFlatJsonObject( line, values ) )
+                throw tablepatch::PatchError( fpath, cntline, "Expected a JSON object with only string and number values!" );
+            patches.push_back( tablepatch::MakePatch( fpath, cntline, [&]( const char * name )->const std::string*
+            {
+                for( const auto & kv : values )
+                    if( kv.first == name )
+                        return &kv.second;
+                return nullptr;
+            }));
+        }
+    }
+    return patches;
+}
+
+//The tables of each binary that can be patched
+const std::initializer_list<const char*> Arm9PatchTables      = { "Entity Symbol List Table", "Event List Table" };
+const std::initializer_list<const char*> Overlay11PatchTables = { "Event Sub File List Table", "Special List Table" };
+
+/*
+    IsTableIn / HasTablePatches
+        Whether the table id, or any of the patches' tables, is one of the tables named in "headertexts".
+*/
+inline bool IsTableIn( const std::string & tableid, std::initializer_list<const char*> headertexts )
+{
+    for( const char * name : headertexts )
+        if( tableid == MakeTableId(name) )
+            return true;
+    return false;
+}
+
+inline bool HasTablePatches( const std::vector<TablePatch> & patches, std::initializer_list<const char*> headertexts )
+{
+    for( const TablePatch & patch : patches )
+        if( IsTableIn( patch.table, headertexts ) )
+            return true;
+    return false;
+}
+
+/*
+    CheckPatchTables
+        Throws if a patch is for a table that isn't one of the tables that can be patched.
+*/
+inline void CheckPatchTables( const std::vector<TablePatch> & patches, const std::string & patchpath )
+{
+    for( const TablePatch & patch : patches )
+    {
+        if( !IsTableIn( patch.table, Arm9PatchTables ) && !IsTableIn( patch.table, Overlay11PatchTables ) )
+            throw tablepatch::PatchError( patchpath, patch.line, "Unknown table \"" + patch.table + "\"!" );
+    }
+}
+
+/*
+    PreparedPatches
+        The records the patches of a binary change, validated, but not written yet, and the tables
+        that had to be found by scanning, since they weren't where the binary's build keeps them.
+*/
+struct PreparedPatches
+{
+    uint8_t *                                              pfbeg     = nullptr;
+    size_t                                                 nbpatches = 0;
+    std::vector<std::pair<uint32_t, std::vector<uint8_t>>> records;
+    std::vector<LocatedLUT>                                fallbacks;
+};
+
+/*
+    PrepareArm9Patches / PrepareOverlay0011Patches
+        Validates the patches for the tables of an unpacked arm9 or overlay 11, loaded at "loadoffset",
+        and re-encodes the records they change, without writing anything. Patches for the other
+        binary's tables are ignored. Throws on the first invalid patch. "pknown" lists where the
+        binary's build keeps the tables, as for ParseArm9Tables().
+*/
+inline PreparedPatches PrepareArm9Patches( uint8_t * pfbeg, uint8_t * pfend, uint32_t loadoffset, const std::vector<TablePatch> & patches, const std::string & patchpath,
+                                           const std::vector<KnownLUT> * pknown = nullptr )
+{
+    PreparedPatches prepared;
+    LUTLocator      locator( pfbeg, pfend, loadoffset, pknown );
+    prepared.pfbeg = pfbeg;
+    prepared.nbpatches += tablepatch::PrepareTablePatches<EntitySymbolListEntry>( locator, &LocateEntitySymbols, "Entity Symbol List Table", patches, patchpath, prepared.records );
+    prepared.nbpatches += tablepatch::PrepareTablePatches<LevelEntry>           ( locator, &LocateEventList,     "Event List Table",         patches, patchpath, prepared.records );
+    prepared.fallbacks  = locator.Fallbacks();
+    return prepared;
+}
+
+inline PreparedPatches PrepareOverlay0011Patches( uint8_t * pfbeg, uint8_t * pfend, uint32_t loadoffset, const std::vector<TablePatch> & patches, const std::string & patchpath,
+                                                  const std::vector<KnownLUT> * pknown = nullptr )
+{
+    PreparedPatches prepared;
+    LUTLocator      locator( pfbeg, pfend, loadoffset, pknown );
+    prepared.pfbeg = pfbeg;
+    prepared.nbpatches += tablepatch::PrepareTablePatches<EventSubFileListEntry>( locator, &LocateEventSubFileList, "Event Sub File List Table", patches, patchpath, prepared.records );
+    prepared.nbpatches += tablepatch::PrepareTablePatches<SpecListEntry>        ( locator, &LocateSpecialList,      "Special List Table",        patches, patchpath, prepared.records );
+    prepared.fallbacks  = locator.Fallbacks();
+    return prepared;
+}
+
+/*
+    WritePreparedPatches
+        Writes the records of prepared patches, and adds what changed to "result".
+*/
+inline void WritePreparedPatches( const PreparedPatches & prepared, PatchResult & result )
+{
+    result.nbpatches += prepared.nbpatches;
+    tablepatch::WriteRecords( prepared.pfbeg, prepared.records, result );
+}
+
+/*
+    PatchArm9Tables / PatchOverlay0011Tables
+        Applies the patches for the tables of an unpacked arm9 or overlay 11, loaded at "loadoffset",
+        in place. Patches for the other binary's tables are ignored. Nothing is written if any of the
+        patches is invalid. To patch both binaries of a ROM all or nothing, prepare both first instead.
+*/
+inline PatchResult PatchArm9Tables( uint8_t * pfbeg, uint8_t * pfend, uint32_t loadoffset, const std::vector<TablePatch> & patches, const std::string & patchpath )
+{
+    PatchResult result;
+    WritePreparedPatches( PrepareArm9Patches( pfbeg, pfend, loadoffset, patches, patchpath ), result );
+    return result;
+}
+
+inline PatchResult PatchOverlay0011Tables( uint8_t * pfbeg, uint8_t * pfend, uint32_t loadoffset, const std::vector<TablePatch> & patches, const std::string & patchpath )
+{
+    PatchResult result;
+    WritePreparedPatches( PrepareOverlay0011Patches( pfbeg, pfend, loadoffset, patches, patchpath ), result );
+    return result;
+}
+
+#endif
@@ -0,0 +1,227 @@
+#ifndef TABLESTORE_HPP
+#define TABLESTORE_HPP
+/*
+tablestore.hpp
+    Content addressed store of rendered tables, shared by every ROM dumped into it.
+
+    Each table's text is stored once, in a file named after the table's cache key, the hash of
+    everything its output depends on: its position, its records and the strings they point to.
+    Instead of "<basename>.txt", each binary gets a "<basename>.manifest" listing the stored tables
+    its dump is made of, in order, one path relative to the store per line. The text dump is the
+    concatenation of those files:
+        cd <store> && xargs cat < <outdir>/arm9.manifest > arm9.txt
+
+    A table that's already in the store isn't decoded at all, so dumping a corpus of mostly
+    identical ROMs only decodes and writes as many tables as there are different ones.
+
+    Store layout:
+        tables/<key>.txt    The text of the table with that key, as 16 upper case hex digits.
+*/
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_set>
+#include <vector>
+#include "eventtables.hpp"
+#include "textbuffer.hpp"
+
+class TableStore
+{
+public:
+    static constexpr const char * TablesDir = "tables";
+    static constexpr const char * TableExt  = ".txt";
+
+    /*
+        Opens the store in "rootdir", creating it if needed, and lists the tables it already has.
+        Files left over by an interrupted run are never listed, since tables are only renamed
+        into place once completely written.
+    */
+    explicit TableStore( const std::string & rootdir )
+        :m_rootdir(rootdir)
+    {
+        namespace fs = std::filesystem;
+        const fs::path  tablesdir = fs::path(m_rootdir) / TablesDir;
+        std::error_code ec;
+        fs::create_directories( tablesdir, ec );
+        if( !fs::is_directory( tablesdir ) )
+            throw std::runtime_error("TableStore::TableStore(): Couldn't create the store directory " + tablesdir.string() + "!");
+
+        for( const fs::directory_entry & entry : fs::directory_iterator(tablesdir) )
+        {
+            uint64_t key = 0;
+            if( entry.is_regular_file() && ParseTableName( entry.path().filename().string(), key ) )
+                m_keys.insert(key);
+        }
+        m_nbexisting = m_keys.size();
+    }
+
+    TableStore( const TableStore & )             = delete;
+    TableStore & operator=( const TableStore & ) = delete;
+
+    /*
+        Claim
+            Adds a reference to the table with this key. Returns true if the table isn't stored yet,
+            and the caller is the one that has to Write() it. Thread safe.
+    */
+    bool Claim( uint64_t key )
+    {
+        ++m_nbreferences;
+        std::lock_guard<std::mutex> lk(m_mtx);
+        return m_keys.insert(key).second;
+    }
+
+    /*
+        Write
+            Stores the text of a claimed table. It goes to a temporary file first, then replaces
+            the table's file, so a table file is never seen half written.
+    */
+    void Write( uint64_t key, std::string_view text )
+    {
+        namespace fs = std::filesystem;
+        const std::string fpath = m_rootdir + "/" + TablePath(key);
+        const std::string tmp   = fpath + ".tmp";
+        {
+            std::ofstream out( tmp, std::ios::out | std::ios::binary | std::ios::trunc );
+            out.write( text.data(), static_cast<std::streamsize>( text.size() ) );
+            if( !out )
+                throw std::runtime_error("TableStore::Write(): Couldn't write " + tmp + "!");
+        }
+        std::error_code ec;
+        fs::rename( tmp, fpath, ec );
+        if( ec )
+            throw std::runtime_error("TableStore::Write(): Couldn't move " + tmp + " into place: " + ec.message() + "!");
+        PMD2_PROF_COUNT( BytesWritten, text.size() );
+        ++m_nbwritten;
+    }
+
+    //Path of a table's file, relative to the store's root. Ex: "tables/0123456789ABCDEF.txt"
+    static std::string TablePath( uint64_t key )
+    {
+        TextBuffer path;
+        path << TablesDir << '/';
+        path.AppendHex( key, 16 );
+        path << TableExt;
+        return path.str();
+    }
+
+    inline const std::string & RootDir     ()const { return m_rootdir; }
+    inline size_t              NbExisting  ()const { return m_nbexisting; }    //Tables stored before this run
+    inline size_t              NbWritten   ()const { return m_nbwritten; }     //Tables stored by this run
+    inline size_t              NbReferences()const { return m_nbreferences; }  //Tables dumped by this run
+
+private:
+    static bool ParseTableName( const std::string & fname, uint64_t & key )
+    {
+        const size_t extlen = std::char_traits<char>::length(TableExt);
+        if( fname.size() != (16 + extlen) || fname.compare( 16, extlen, TableExt ) != 0 )
+            return false;
+        key = 0;
+        for( size_t i = 0; i < 16; ++i )
+        {
+            const char c = fname[i];
+            uint64_t   digit;
+            if( c >= '0' && c <= '9' )
+                digit = static_cast<uint64_t>(c - '0');
+            else if( c >= 'A' && c <= 'F' )
+                digit = static_cast<uint64_t>(c - 'A' + 10);
+            else
+                return false;
+            key = (key << 4) | digit;
+        }
+        return true;
+    }
+
+private:
+    std::string                  m_rootdir;
+    std::mutex                   m_mtx;
+    std::unordered_set<uint64_t> m_keys;            //Every table stored, or claimed by this run
+    size_t                       m_nbexisting = 0;
+    std::atomic<size_t>          m_nbwritten    {0};
+    std::atomic<size_t>          m_nbreferences {0};
+};
+
+// ----------------------------------------------------------------------------------------
+/*
+    StoredTextSink
+        Writes the text layout of a binary's tables into a TableStore, and the list of the tables
+        it's made of to the manifest stream.
+        Tables already in the store are skipped before they're decoded, unless "bdecodeall" is set,
+        for callers that need the stats of every table. Those are decoded, but not written again.
+*/
+class StoredTextSink
+{
+public:
+    StoredTextSink( TableStore & store, std::ostream * pmanifest, bool bdecodeall )
+        :m_store(store), m_pmanifest(pmanifest), m_bdecodeall(bdecodeall), m_curkey(0), m_bclaimed(false)
+    {}
+
+    bool ReuseTable( uint64_t key )
+    {
+        m_curkey   = key;
+        m_bclaimed = m_store.Claim(key);
+        m_keys.push_back(key);
+        return !m_bclaimed && !m_bdecodeall;
+    }
+
+    template<class _EntryTy>
+        void BeginTable( const std::string & headertext, uint32_t offset, size_t nbentries )
+    {
+        if( !m_bclaimed )
+            return;
+        m_text.Buffer().clear();
+        m_text.BeginTable<_EntryTy>( headertext, offset, nbentries );
+    }
+
+    template<class _EntryTy>
+        void WriteRow( uint32_t rowoffset, const _EntryTy & entry, std::optional<std::string_view> symbol )
+    {
+        if( m_bclaimed )
+            m_text.WriteRow( rowoffset, entry, symbol );
+    }
+
+    template<class _EntryTy>
+        void EndTable( typename _EntryTy::Stats & stats )
+    {
+        if( !m_bclaimed )
+            return;
+        m_text.EndTable<_EntryTy>(stats);
+        m_store.Write( m_curkey, m_text.Buffer().View() );
+        m_text.Buffer().clear();
+    }
+
+    void Finish()
+    {
+        if( m_pmanifest == nullptr )
+            return;
+        TextBuffer lines;
+        for( uint64_t key : m_keys )
+            lines << TableStore::TablePath(key) << '\n';
+        lines.WriteTo(*m_pmanifest);
+        m_pmanifest->flush();
+    }
+
+    //Forks only collect the keys of their table, the parent writes the manifest
+    typedef StoredTextSink fork_t;
+    std::unique_ptr<fork_t> Fork()const             { return std::make_unique<StoredTextSink>( m_store, nullptr, m_bdecodeall ); }
+    void                    Join( fork_t & fork )   { m_keys.insert( m_keys.end(), fork.m_keys.begin(), fork.m_keys.end() ); }
+
+private:
+    TableStore &              m_store;
+    std::ostream *            m_pmanifest;
+    bool                      m_bdecodeall;
+    uint64_t                  m_curkey;
+    bool                      m_bclaimed;
+    std::vector<uint64_t>     m_keys;       //Tables of the binary, in order
+    TextSink                  m_text;       //Renders the claimed table without a stream
+};
+
+#endif
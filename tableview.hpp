@@ -0,0 +1,200 @@
+#ifndef TABLEVIEW_HPP
+#define TABLEVIEW_HPP
+/*
+tableview.hpp
+    Read-only access to the tables of an unpacked binary, without dumping them.
+
+    A TableView only checks that its table fits in the image. Records are decoded when they're
+    accessed, and symbols are string_views into the image, so reading a few rows of a table costs
+    just those rows. The image must outlive the views made over it.
+*/
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include "eventtables.hpp"
+#include "lutscanner.hpp"
+
+/*
+    TableView
+        Random access to the records of a table of "_EntryTy" entries.
+        Rows and iterators point back to their view, so they're only valid as long as it is.
+*/
+template<class _EntryTy>
+    class TableView
+{
+public:
+    typedef _EntryTy entry_t;
+
+    /*
+        Row
+            A record of the table. Nothing is decoded until one of its accessors is called.
+    */
+    class Row
+    {
+    public:
+        Row( const TableView * pview, size_t index )
+            :m_pview(pview), m_index(index)
+        {}
+
+        //Decodes the whole record
+        inline _EntryTy Entry()const { return m_pview->Entry(m_index); }
+
+        //The symbol the record points to, or nothing if its pointer is null. Only the pointer is decoded.
+        inline std::optional<std::string_view> Symbol()const { return m_pview->Symbol(m_index); }
+
+        //File offset of the record
+        inline uint32_t Offset()const { return m_pview->RowOffset(m_index); }
+        inline size_t   Index ()const { return m_index; }
+
+    private:
+        const TableView * m_pview;
+        size_t            m_index;
+    };
+
+    /*
+        iterator
+            Yields a Row for each record, in table order.
+    */
+    class iterator
+    {
+    public:
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef Row                             value_type;
+        typedef std::ptrdiff_t                  difference_type;
+        typedef void                            pointer;
+        typedef Row                             reference;
+
+        iterator( const TableView * pview = nullptr, size_t index = 0 )
+            :m_pview(pview), m_index(index)
+        {}
+
+        inline Row        operator*()const                        { return Row( m_pview, m_index ); }
+        inline Row        operator[]( difference_type n )const    { return Row( m_pview, m_index + n ); }
+        inline iterator & operator++()                            { ++m_index; return *this; }
+        inline iterator   operator++(int)                         { iterator prev = *this; ++m_index; return prev; }
+        inline iterator & operator--()                            { --m_index; return *this; }
+        inline iterator   operator--(int)                         { iterator prev = *this; --m_index; return prev; }
+        inline iterator & operator+=( difference_type n )         { m_index += n; return *this; }
+        inline iterator & operator-=( difference_type n )         { m_index -= n; return *this; }
+        inline iterator   operator+ ( difference_type n )const    { return iterator( m_pview, m_index + n ); }
+        inline iterator   operator- ( difference_type n )const    { return iterator( m_pview, m_index - n ); }
+        inline difference_type operator-( const iterator & other )const { return static_cast<difference_type>(m_index) - static_cast<difference_type>(other.m_index); }
+        friend inline iterator operator+( difference_type n, const iterator & it ) { return it + n; }
+
+        inline bool operator==( const iterator & other )const { return m_index == other.m_index; }
+        inline bool operator!=( const iterator & other )const { return m_index != other.m_index; }
+        inline bool operator< ( const iterator & other )const { return m_index <  other.m_index; }
+        inline bool operator> ( const iterator & other )const { return m_index >  other.m_index; }
+        inline bool operator<=( const iterator & other )const { return m_index <= other.m_index; }
+        inline bool operator>=( const iterator & other )const { return m_index >= other.m_index; }
+
+    private:
+        const TableView * m_pview;
+        size_t            m_index;
+    };
+    typedef iterator const_iterator;
+
+public:
+    /*
+        "offset" is the file offset of the table, and "ptrDiff" the address the image is loaded at.
+        Throws if the table goes past the end of the image.
+    */
+    TableView( const uint8_t * pfbeg, const uint8_t * pfend, uint32_t offset, size_t nbentries, uint32_t ptrDiff )
+        :m_pfbeg(pfbeg), m_pfend(pfend), m_offset(offset), m_nbentries(nbentries), m_ptrdiff(ptrDiff)
+    {
+        if( static_cast<size_t>(pfend - pfbeg) < (offset + (nbentries * _EntryTy::Size)) )
+            throw std::runtime_error("TableView::TableView(): The table at " + NumberToHexString(offset) + " goes past the end of the file!");
+    }
+
+    inline size_t   size  ()const { return m_nbentries; }
+    inline bool     empty ()const { return m_nbentries == 0; }
+    inline uint32_t Offset()const { return m_offset; }
+
+    inline iterator begin()const { return iterator( this, 0 ); }
+    inline iterator end  ()const { return iterator( this, m_nbentries ); }
+
+    //No bounds checks
+    inline Row operator[]( size_t index )const { return Row( this, index ); }
+
+    Row at( size_t index )const
+    {
+        if( index >= m_nbentries )
+            throw std::runtime_error("TableView::at(): Row " + std::to_string(index) + " is past the end of the table at " + NumberToHexString(m_offset) + "!");
+        return Row( this, index );
+    }
+
+    inline uint32_t RowOffset( size_t index )const
+    {
+        return static_cast<uint32_t>( m_offset + (index * _EntryTy::Size) );
+    }
+
+    _EntryTy Entry( size_t index )const
+    {
+        const uint8_t * precord = m_pfbeg + RowOffset(index);
+        _EntryTy        entry;
+        entry.Read( precord, precord + _EntryTy::Size );
+        return entry;
+    }
+
+    inline uint32_t SymbolPtr( size_t index )const
+    {
+        return LoadIntLE<uint32_t>( m_pfbeg + RowOffset(index) + _EntryTy::PtrOffset() );
+    }
+
+    //Throws if the pointer leads outside of the image, or to an unterminated string
+    std::optional<std::string_view> Symbol( size_t index )const
+    {
+        const uint32_t ptrstring = SymbolPtr(index);
+        if( ptrstring == 0 )
+            return std::nullopt;
+        return FetchString( ptrstring - m_ptrdiff, m_pfbeg, m_pfend );
+    }
+
+private:
+    const uint8_t * m_pfbeg;
+    const uint8_t * m_pfend;
+    uint32_t        m_offset;
+    size_t          m_nbentries;
+    uint32_t        m_ptrdiff;
+};
+
+/*
+    MakeTableView
+        View of a table found by a LUTLocator, over the image the locator was made for.
+*/
+template<class _EntryTy>
+    inline TableView<_EntryTy> MakeTableView( const LUTLocator & locator, const LUTLocation & loc )
+{
+    return TableView<_EntryTy>( locator.ImageBeg(), locator.ImageEnd(), loc.offset, loc.nbentries, locator.LoadOffset() );
+}
+
+/*
+    View*
+        Locates a table in an unpacked arm9 or overlay 11, and returns a view of it.
+        The location is validated the same way as when dumping.
+*/
+inline TableView<EntitySymbolListEntry> ViewEntitySymbols( LUTLocator & arm9locator )
+{
+    return MakeTableView<EntitySymbolListEntry>( arm9locator, LocateEntitySymbols(arm9locator) );
+}
+
+inline TableView<LevelEntry> ViewEventList( LUTLocator & arm9locator )
+{
+    return MakeTableView<LevelEntry>( arm9locator, LocateEventList(arm9locator) );
+}
+
+inline TableView<EventSubFileListEntry> ViewEventSubFileList( LUTLocator & ov11locator )
+{
+    return MakeTableView<EventSubFileListEntry>( ov11locator, LocateEventSubFileList(ov11locator) );
+}
+
+inline TableView<SpecListEntry> ViewSpecialList( LUTLocator & ov11locator )
+{
+    return MakeTableView<SpecListEntry>( ov11locator, LocateSpecialList(ov11locator) );
+}
+
+#endif
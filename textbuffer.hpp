@@ -0,0 +1,96 @@
+#ifndef TEXTBUFFER_HPP
+#define TEXTBUFFER_HPP
+/*
+textbuffer.hpp
+    Formats text into a reusable buffer, without going through iostreams.
+
+    Integers are converted with std::to_chars, and padded the same way setw and setfill pad them,
+    so text formatted here is byte for byte what the stream manipulators produced. The buffer keeps
+    its capacity when emptied, so once it grew to the size of the largest table, formatting doesn't
+    allocate anymore, and the whole buffer goes to the output stream in a single write.
+*/
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+class TextBuffer
+{
+public:
+    explicit TextBuffer( size_t capacity = 0 )
+    {
+        m_buf.reserve(capacity);
+    }
+
+    inline void Append( std::string_view text ) { m_buf.append( text.data(), text.size() ); }
+    inline void Append( char c )                { m_buf.push_back(c); }
+
+    inline TextBuffer & operator<<( std::string_view text ) { Append(text); return *this; }
+    inline TextBuffer & operator<<( char c )                { Append(c);    return *this; }
+
+    /*
+        AppendDec
+            Decimal, right aligned on at least "width" characters, padded with spaces.
+            Same as "<< setfill(' ') << setw(width) << +value".
+    */
+    template<class T>
+        inline void AppendDec( T value, int width = 0 )
+    {
+        AppendPadded( +value, 10, width, ' ' );
+    }
+
+    /*
+        AppendHex
+            Upper case hexadecimal without prefix, on at least "width" digits, padded with zeros.
+            Same as "<< hex << uppercase << setfill('0') << setw(width) << +value".
+    */
+    template<class T>
+        inline void AppendHex( T value, int width = 0 )
+    {
+        AppendPadded( +value, 16, width, '0' );
+    }
+
+    inline std::string_view    View ()const { return std::string_view(m_buf); }
+    inline const std::string & str  ()const { return m_buf; }
+    inline size_t              size ()const { return m_buf.size(); }
+    inline bool                empty()const { return m_buf.empty(); }
+    inline void                clear()      { m_buf.clear(); }
+
+    //Writes the content to the stream in one call, and empties the buffer
+    void WriteTo( std::ostream & out )
+    {
+        if( m_buf.empty() )
+            return;
+        out.write( m_buf.data(), static_cast<std::streamsize>( m_buf.size() ) );
+        m_buf.clear();
+    }
+
+private:
+    template<class T>
+        void AppendPadded( T value, int base, int width, char fill )
+    {
+        static_assert( std::is_integral<T>::value, "TextBuffer::AppendPadded(): Only integers can be formatted!" );
+        char                       digits[24];  //Room for a 64 bits value in decimal with its sign
+        const std::to_chars_result res = std::to_chars( digits, digits + sizeof(digits), value, base );
+        const size_t               len = static_cast<size_t>( res.ptr - digits );
+        if( base == 16 )
+        {
+            for( size_t i = 0; i < len; ++i )
+            {
+                if( digits[i] >= 'a' )
+                    digits[i] = static_cast<char>( digits[i] - ('a' - 'A') );
+            }
+        }
+        if( static_cast<size_t>(width) > len )
+            m_buf.append( static_cast<size_t>(width) - len, fill );
+        m_buf.append( digits, len );
+    }
+
+private:
+    std::string m_buf;
+};
+
+#endif
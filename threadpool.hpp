@@ -0,0 +1,442 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+/*
+threadpool.hpp
+    A small work-stealing thread pool, and a few helpers to coordinate threads.
+
+    Each worker owns a task deque. Workers pop their own tasks from the back,
+    and when they run out, steal from the front of the other workers' deques.
+    Tasks submitted from outside the pool are spread round-robin over the workers.
+*/
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+    typedef std::function<void()> task_t;
+
+    explicit ThreadPool( size_t nbthreads = std::thread::hardware_concurrency() )
+    {
+        if( nbthreads == 0 )
+            nbthreads = 1;
+
+        for( size_t i = 0; i < nbthreads; ++i )
+            m_queues.push_back( std::make_unique<WorkQueue>() );
+        for( size_t i = 0; i < nbthreads; ++i )
+            m_threads.emplace_back( &ThreadPool::WorkerLoop, this, i );
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_sleepmtx);
+            m_stop = true;
+        }
+        m_wakecv.notify_all();
+        for( auto & th : m_threads )
+            th.join();
+    }
+
+    ThreadPool( const ThreadPool & )             = delete;
+    ThreadPool & operator=( const ThreadPool & ) = delete;
+
+    /*
+        Queue a task. When called from one of the pool's workers, the task goes
+        on that worker's own deque, otherwise it goes to the next worker in turn.
+    */
+    void Submit( task_t task )
+    {
+        size_t qidx = (t_ownerpool == this)? t_workeridx : (m_nextqueue++ % m_queues.size());
+        ++m_pending;
+        {
+            std::lock_guard<std::mutex> lk(m_queues[qidx]->mtx);
+            m_queues[qidx]->tasks.push_back( std::move(task) );
+        }
+        {
+            std::lock_guard<std::mutex> lk(m_sleepmtx);
+        }
+        m_wakecv.notify_one();
+    }
+
+    /*
+        Block until every queued task was processed.
+        Rethrows the first exception a task threw, if any.
+    */
+    void WaitIdle()
+    {
+        {
+            std::unique_lock<std::mutex> lk(m_sleepmtx);
+            m_idlecv.wait( lk, [this](){ return m_pending == 0; } );
+        }
+        std::exception_ptr pexcept;
+        {
+            std::lock_guard<std::mutex> lk(m_sleepmtx);
+            std::swap( pexcept, m_firstexcept );
+        }
+        if( pexcept )
+            std::rethrow_exception(pexcept);
+    }
+
+    inline size_t NbThreads()const { return m_threads.size(); }
+
+private:
+    struct WorkQueue
+    {
+        std::mutex          mtx;
+        std::deque<task_t>  tasks;
+    };
+
+    //Pop from the back of our own queue, or steal from the front of another one
+    bool TryPop( size_t ownidx, task_t & out )
+    {
+        {
+            WorkQueue & own = *m_queues[ownidx];
+            std::lock_guard<std::mutex> lk(own.mtx);
+            if( !own.tasks.empty() )
+            {
+                out = std::move( own.tasks.back() );
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        for( size_t i = 1; i < m_queues.size(); ++i )
+        {
+            WorkQueue & victim = *m_queues[(ownidx + i) % m_queues.size()];
+            std::lock_guard<std::mutex> lk(victim.mtx);
+            if( !victim.tasks.empty() )
+            {
+                out = std::move( victim.tasks.front() );
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void RunTask( task_t & task )
+    {
+        try
+        {
+            task();
+        }
+        catch(...)
+        {
+            std::lock_guard<std::mutex> lk(m_sleepmtx);
+            if( !m_firstexcept )
+                m_firstexcept = std::current_exception();
+        }
+
+        if( --m_pending == 0 )
+        {
+            std::lock_guard<std::mutex> lk(m_sleepmtx);
+            m_idlecv.notify_all();
+        }
+    }
+
+    void WorkerLoop( size_t idx )
+    {
+        t_ownerpool = this;
+        t_workeridx = idx;
+
+        for(;;)
+        {
+            task_t task;
+            if( TryPop( idx, task ) )
+            {
+                RunTask(task);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lk(m_sleepmtx);
+            if( m_stop )
+                return;
+            //Re-check under the lock so a Submit() can't slip between the pop attempt and the wait
+            m_wakecv.wait( lk, [this](){ return m_stop || HasQueuedTasks(); } );
+            if( m_stop && !HasQueuedTasks() )
+                return;
+        }
+    }
+
+    bool HasQueuedTasks()
+    {
+        for( auto & pq : m_queues )
+        {
+            std::lock_guard<std::mutex> lk(pq->mtx);
+            if( !pq->tasks.empty() )
+                return true;
+        }
+        return false;
+    }
+
+private:
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+    std::vector<std::thread>                m_threads;
+    std::atomic<size_t>                     m_nextqueue {0};
+    std::atomic<size_t>                     m_pending   {0};
+    std::mutex                              m_sleepmtx;
+    std::condition_variable                 m_wakecv;
+    std::condition_variable                 m_idlecv;
+    std::exception_ptr                      m_firstexcept;
+    bool                                    m_stop = false;
+
+    static thread_local ThreadPool *        t_ownerpool;
+    static thread_local size_t              t_workeridx;
+};
+
+inline thread_local ThreadPool * ThreadPool::t_ownerpool = nullptr;
+inline thread_local size_t       ThreadPool::t_workeridx = 0;
+
+// ----------------------------------------------------------------------------------------
+/*
+    TaskGroup
+        Tracks a set of tasks submitted to a pool, so a thread can wait on just those.
+        The group keeps its own queue of tasks, and only gives the pool a ticket to run the next one
+        per task. While waiting, the thread runs the group's tasks no one started yet itself, so
+        waiting from inside one of the pool's own tasks can't leave every worker blocked. It never
+        picks up another group's tasks, so a thread waiting on its tables can't start another ROM's
+        whole job on top of its own. Without a pool, tasks run as they're added.
+*/
+class TaskGroup
+{
+public:
+    explicit TaskGroup( ThreadPool * ppool )
+        :m_ppool(ppool), m_pstate( std::make_shared<State>() )
+    {}
+
+    ~TaskGroup()
+    {
+        //The tasks may refer to the caller's locals, so they must be done before we leave
+        WaitAll();
+    }
+
+    TaskGroup( const TaskGroup & )             = delete;
+    TaskGroup & operator=( const TaskGroup & ) = delete;
+
+    void Run( ThreadPool::task_t task )
+    {
+        const size_t taskidx = m_nbtasks++;
+        if( m_ppool == nullptr )
+        {
+            RunTask( *m_pstate, taskidx, task );
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lk(m_pstate->mtx);
+            m_pstate->queued.push_back( QueuedTask{ taskidx, std::move(task) } );
+            ++(m_pstate->pending);
+        }
+        //The ticket may run after the group is gone, if the waiting thread ran every task itself
+        m_ppool->Submit( [pstate = m_pstate](){ RunNextTask(*pstate); } );
+    }
+
+    /*
+        Block until every task of the group was processed.
+        Rethrows the exception of the earliest added task that threw, if any, so the error
+        reported doesn't depend on scheduling.
+    */
+    void Wait()
+    {
+        WaitAll();
+        std::exception_ptr pexcept;
+        {
+            std::lock_guard<std::mutex> lk(m_pstate->mtx);
+            std::swap( pexcept, m_pstate->firstexcept );
+        }
+        if( pexcept )
+            std::rethrow_exception(pexcept);
+    }
+
+private:
+    struct QueuedTask
+    {
+        size_t             idx = 0;
+        ThreadPool::task_t task;
+    };
+
+    //Shared with the tickets in the pool's queues, which may outlive the group
+    struct State
+    {
+        std::mutex              mtx;
+        std::condition_variable donecv;
+        std::deque<QueuedTask>  queued;             //Tasks no one started yet
+        size_t                  pending        = 0; //Tasks not done yet
+        std::exception_ptr      firstexcept;
+        size_t                  firstexceptidx = 0;
+    };
+
+    static void RunTask( State & state, size_t taskidx, ThreadPool::task_t & task )
+    {
+        try
+        {
+            task();
+        }
+        catch(...)
+        {
+            std::lock_guard<std::mutex> lk(state.mtx);
+            if( !state.firstexcept || taskidx < state.firstexceptidx )
+            {
+                state.firstexcept    = std::current_exception();
+                state.firstexceptidx = taskidx;
+            }
+        }
+    }
+
+    //Runs the group's oldest task no one started yet. Returns false if there's none.
+    static bool RunNextTask( State & state )
+    {
+        QueuedTask next;
+        {
+            std::lock_guard<std::mutex> lk(state.mtx);
+            if( state.queued.empty() )
+                return false;
+            next = std::move( state.queued.front() );
+            state.queued.pop_front();
+        }
+        RunTask( state, next.idx, next.task );
+        std::lock_guard<std::mutex> lk(state.mtx);
+        if( --(state.pending) == 0 )
+            state.donecv.notify_all();
+        return true;
+    }
+
+    void WaitAll()
+    {
+        if( m_ppool == nullptr )
+            return;
+        while( RunNextTask(*m_pstate) )
+        {}
+        //Nothing left to start, so our remaining tasks are running on other threads
+        std::unique_lock<std::mutex> lk(m_pstate->mtx);
+        m_pstate->donecv.wait( lk, [this](){ return m_pstate->pending == 0; } );
+    }
+
+private:
+    ThreadPool *           m_ppool;
+    std::shared_ptr<State> m_pstate;
+    size_t                 m_nbtasks = 0;
+};
+
+// ----------------------------------------------------------------------------------------
+/*
+    BufferPool
+        Byte buffers lent to one user at a time, and kept once returned. Buffers only ever grow, so
+        once each one grew to the largest size needed, borrowing one doesn't allocate. There are
+        never more buffers than users holding one at the same time.
+*/
+class BufferPool
+{
+public:
+    typedef std::vector<uint8_t> buffer_t;
+
+    //Gives the buffer back to the pool when it goes out of scope
+    class Lease
+    {
+    public:
+        Lease( BufferPool & pool, std::unique_ptr<buffer_t> pbuf )
+            :m_pool(pool), m_pbuf(std::move(pbuf))
+        {}
+
+        ~Lease()
+        {
+            m_pool.Return( std::move(m_pbuf) );
+        }
+
+        Lease( const Lease & )             = delete;
+        Lease & operator=( const Lease & ) = delete;
+
+        inline buffer_t & Buffer() { return *m_pbuf; }
+
+    private:
+        BufferPool &              m_pool;
+        std::unique_ptr<buffer_t> m_pbuf;
+    };
+
+    Lease Borrow()
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        if( m_free.empty() )
+            return Lease( *this, std::make_unique<buffer_t>() );
+        std::unique_ptr<buffer_t> pbuf = std::move( m_free.back() );
+        m_free.pop_back();
+        return Lease( *this, std::move(pbuf) );
+    }
+
+private:
+    void Return( std::unique_ptr<buffer_t> pbuf )
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        m_free.push_back( std::move(pbuf) );
+    }
+
+private:
+    std::mutex                             m_mtx;
+    std::vector<std::unique_ptr<buffer_t>> m_free;
+};
+
+// ----------------------------------------------------------------------------------------
+/*
+    BoundedQueue
+        A FIFO queue between threads, holding at most "capacity" items. Push() blocks while it's
+        full and Pop() while it's empty, so a stage of a pipeline can't run ahead of the next one
+        by more than the capacity. Once closed, Push() fails, and Pop() fails once it's empty.
+*/
+template<class T>
+    class BoundedQueue
+{
+public:
+    explicit BoundedQueue( size_t capacity )
+        :m_capacity( std::max<size_t>( capacity, 1 ) )
+    {}
+
+    bool Push( T item )
+    {
+        std::unique_lock<std::mutex> lk(m_mtx);
+        m_notfullcv.wait( lk, [this](){ return m_bclosed || m_items.size() < m_capacity; } );
+        if( m_bclosed )
+            return false;
+        m_items.push_back( std::move(item) );
+        m_notemptycv.notify_one();
+        return true;
+    }
+
+    bool Pop( T & out )
+    {
+        std::unique_lock<std::mutex> lk(m_mtx);
+        m_notemptycv.wait( lk, [this](){ return m_bclosed || !m_items.empty(); } );
+        if( m_items.empty() )
+            return false;
+        out = std::move( m_items.front() );
+        m_items.pop_front();
+        m_notfullcv.notify_one();
+        return true;
+    }
+
+    //No more items will be pushed. Wakes everyone up.
+    void Close()
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        m_bclosed = true;
+        m_notemptycv.notify_all();
+        m_notfullcv.notify_all();
+    }
+
+private:
+    size_t                  m_capacity;
+    bool                    m_bclosed = false;
+    std::deque<T>           m_items;
+    std::mutex              m_mtx;
+    std::condition_variable m_notemptycv;
+    std::condition_variable m_notfullcv;
+};
+
+#endif
@@ -0,0 +1,181 @@
+#ifndef XXH64_HPP
+#define XXH64_HPP
+/*
+xxh64.hpp
+    The XXH64 non-cryptographic hash, usable in one call, or incrementally over several buffers.
+    Both give the same result as the reference implementation for the same bytes and seed.
+*/
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+namespace xxh64
+{
+    const uint64_t Prime1 = 0x9E3779B185EBCA87ull;
+    const uint64_t Prime2 = 0xC2B2AE3D27D4EB4Full;
+    const uint64_t Prime3 = 0x165667B19E3779F9ull;
+    const uint64_t Prime4 = 0x85EBCA77C2B2AE63ull;
+    const uint64_t Prime5 = 0x27D4EB2F165667C5ull;
+    const size_t   StripeLen = 32;
+
+    inline uint64_t RotL( uint64_t x, int r )
+    {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    inline uint64_t Read64LE( const uint8_t * p )
+    {
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || defined(_WIN32)
+        uint64_t v;
+        std::memcpy( &v, p, sizeof(v) );
+        return v;
+#else
+        uint64_t v = 0;
+        for( int i = 7; i >= 0; --i )
+            v = (v << 8) | p[i];
+        return v;
+#endif
+    }
+
+    inline uint32_t Read32LE( const uint8_t * p )
+    {
+        return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+    inline uint64_t Round( uint64_t acc, uint64_t input )
+    {
+        acc += input * Prime2;
+        acc  = RotL( acc, 31 );
+        return acc * Prime1;
+    }
+
+    inline uint64_t MergeRound( uint64_t acc, uint64_t val )
+    {
+        acc ^= Round( 0, val );
+        return (acc * Prime1) + Prime4;
+    }
+
+    //Hashes the last bytes that don't fill a whole stripe, and mixes the result
+    inline uint64_t Finalize( uint64_t h, const uint8_t * p, size_t len )
+    {
+        for( ; len >= 8; p += 8, len -= 8 )
+        {
+            h ^= Round( 0, Read64LE(p) );
+            h  = (RotL( h, 27 ) * Prime1) + Prime4;
+        }
+        if( len >= 4 )
+        {
+            h ^= static_cast<uint64_t>( Read32LE(p) ) * Prime1;
+            h  = (RotL( h, 23 ) * Prime2) + Prime3;
+            p   += 4;
+            len -= 4;
+        }
+        for( ; len > 0; ++p, --len )
+        {
+            h ^= (*p) * Prime5;
+            h  = RotL( h, 11 ) * Prime1;
+        }
+        h ^= h >> 33;
+        h *= Prime2;
+        h ^= h >> 29;
+        h *= Prime3;
+        h ^= h >> 32;
+        return h;
+    }
+}
+
+/*
+    XXH64State
+        Incremental hashing. Feed the bytes through Update() in as many pieces as needed.
+*/
+class XXH64State
+{
+public:
+    explicit XXH64State( uint64_t seed = 0 )
+        :m_totallen(0), m_buflen(0)
+    {
+        m_acc[0] = seed + xxh64::Prime1 + xxh64::Prime2;
+        m_acc[1] = seed + xxh64::Prime2;
+        m_acc[2] = seed;
+        m_acc[3] = seed - xxh64::Prime1;
+        m_seed   = seed;
+    }
+
+    void Update( const void * pdata, size_t len )
+    {
+        const uint8_t * p = static_cast<const uint8_t*>(pdata);
+        m_totallen += len;
+
+        //Complete the stripe left over from the last call first
+        if( m_buflen != 0 )
+        {
+            const size_t nbcopied = (len < (xxh64::StripeLen - m_buflen))? len : (xxh64::StripeLen - m_buflen);
+            std::memcpy( m_buf + m_buflen, p, nbcopied );
+            m_buflen += nbcopied;
+            p        += nbcopied;
+            len      -= nbcopied;
+            if( m_buflen < xxh64::StripeLen )
+                return;
+            ProcessStripe(m_buf);
+            m_buflen = 0;
+        }
+
+        for( ; len >= xxh64::StripeLen; p += xxh64::StripeLen, len -= xxh64::StripeLen )
+            ProcessStripe(p);
+
+        if( len != 0 )
+            std::memcpy( m_buf, p, len );
+        m_buflen = len;
+    }
+
+    //Integers are hashed as their little endian bytes, so the hash doesn't depend on the host
+    template<class T>
+        void UpdateInt( T value )
+    {
+        uint8_t bytes[sizeof(T)];
+        for( size_t i = 0; i < sizeof(T); ++i )
+            bytes[i] = static_cast<uint8_t>( static_cast<uint64_t>(value) >> (i * 8) );
+        Update( bytes, sizeof(T) );
+    }
+
+    uint64_t Digest()const
+    {
+        uint64_t h = 0;
+        if( m_totallen >= xxh64::StripeLen )
+        {
+            h = xxh64::RotL( m_acc[0], 1 ) + xxh64::RotL( m_acc[1], 7 ) + xxh64::RotL( m_acc[2], 12 ) + xxh64::RotL( m_acc[3], 18 );
+            for( uint64_t acc : m_acc )
+                h = xxh64::MergeRound( h, acc );
+        }
+        else
+            h = m_seed + xxh64::Prime5;
+        h += m_totallen;
+        return xxh64::Finalize( h, m_buf, m_buflen );
+    }
+
+private:
+    void ProcessStripe( const uint8_t * p )
+    {
+        for( size_t i = 0; i < 4; ++i )
+            m_acc[i] = xxh64::Round( m_acc[i], xxh64::Read64LE( p + (i * 8) ) );
+    }
+
+    uint64_t m_acc[4];
+    uint64_t m_seed;
+    uint64_t m_totallen;
+    uint8_t  m_buf[xxh64::StripeLen];
+    size_t   m_buflen;
+};
+
+/*
+    XXH64
+        Hashes a single buffer.
+*/
+inline uint64_t XXH64( const void * pdata, size_t len, uint64_t seed = 0 )
+{
+    XXH64State state(seed);
+    state.Update( pdata, len );
+    return state.Digest();
+}
+
+#endif